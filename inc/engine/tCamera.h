@@ -11,17 +11,25 @@ class tCamera
 {
   public:
     tCamera(const tVulkanDevice &device, const vk::Extent2D extent);
-    ~tCamera()
-    {
-        CameraMemory.unmapMemory();
-        spdlog::info("tCamera: Destroyed");
-    }
+    ~tCamera() { spdlog::info("tCamera: Destroyed"); }
 
     void updateViewData();
     void addYawPitch(float deltaYaw, float deltaPitch);
     void moveLocal(const glm::vec3 &dir, float distance);
     void onResize(const vk::Extent2D extent);
 
+    // Frustum culling of particle clusters in the task shader. Clusters farther than LodDistance draw every second
+    // particle, every fourth beyond twice that and so on; 0 draws every particle at any distance.
+    struct tCulling
+    {
+        bool Enabled{true};
+        float LodDistance{100.f};
+
+        bool operator==(const tCulling &) const = default;
+    };
+    const tCulling &getCulling() const { return Culling; }
+    void setCulling(const tCulling &culling) { Culling = culling; }
+
     const vk::raii::DescriptorSet &getDescriptorSet() const { return DescriptorSet; }
     const vk::raii::DescriptorSetLayout &getDescriptorSetLayout() const { return DescriptorLayout; }
 
@@ -50,7 +58,7 @@ class tCamera
     vk::raii::DescriptorSet DescriptorSet{nullptr};
 
     vk::raii::Buffer CameraBuffer{nullptr};
-    vk::raii::DeviceMemory CameraMemory{nullptr};
+    tAllocation CameraMemory{nullptr};
 
     glm::vec3 Position{0.0f, 0.0f, -10.0f};
     float Yaw{0.0f};
@@ -58,6 +66,7 @@ class tCamera
     float FovY{glm::radians(80.0f)};
     float ZNear{0.1f};
     float ZFar{500.f};
+    tCulling Culling{};
 
     tParams CachedUBO{};
     void *MappedCameraData;
@@ -4,12 +4,18 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 
+#include <array>
+
 #include <GLFW/glfw3.h>
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "engine/tRenderer.h"
+
 class tCamera;
 
+class tSim;
+
 class tSwapchain;
 
 class tVulkanDevice;
@@ -18,6 +24,7 @@ class tGui
 {
   public:
     tGui(tCamera &camera,
+         tSim &sim,
          const tVulkanDevice &device,
          const tSwapchain &swapchain,
          const vk::raii::Instance &instance,
@@ -30,12 +37,19 @@ class tGui
                        const vk::Image &image,
                        const vk::ImageView &imageView) const;
     float getFrameRate() const { return Io->Framerate; };
+    // The renderer only sees the GUI as const, so tApp hands its stats over and the rasterizer choice back each frame.
+    void setFrameStats(const tRenderer::tFrameStats &stats);
+    tRenderer::tRasterizer getRasterizer() const { return Rasterizer; }
 
   private:
     static constexpr float MouseSensitivity = 0.0025f;
     static constexpr float MoveSpeed = 7.0f;
 
     void updateFPSCounter();
+    void updateSimControls();
+    void updateDiagnostics();
+    void updateMemory();
+    void updateRendering();
     void handleCameraUserInputs();
     void handleCameraKeyboard(float deltaTime);
     void handleCameraMouse();
@@ -47,7 +61,13 @@ class tGui
     ImGui_ImplVulkanH_Window *ImGuiWindow{nullptr};
 
     tCamera &Camera;
+    tSim &Sim;
+    const tVulkanDevice &Device;
     GLFWwindow &Window;
+    tRenderer::tFrameStats FrameStats{};
+    tRenderer::tRasterizer Rasterizer{tRenderer::tRasterizer::MeshShader};
+    // Smoothed particle pass GPU time per rasterizer, kept while the other one is selected for comparison.
+    std::array<float, 2> ParticlePassMs{};
 
     double LastMousePosX, LastMousePosY;
     bool IsFirstMouse = true; // so we don't get a huge jump when re-entering
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+class tMemoryAllocator;
+
+// A range of one of the allocator's blocks, handed back to it on destruction. Declared {nullptr} like the raii
+// handles it stands in for.
+class tAllocation
+{
+  public:
+    tAllocation(std::nullptr_t = nullptr) {}
+    ~tAllocation() { release(); }
+    tAllocation(tAllocation &&other) noexcept;
+    tAllocation &operator=(tAllocation &&other) noexcept;
+    tAllocation(const tAllocation &) = delete;
+    tAllocation &operator=(const tAllocation &) = delete;
+
+    vk::DeviceMemory getMemory() const;
+    vk::DeviceSize getOffset() const { return Offset; }
+    vk::DeviceSize getSize() const { return Size; }
+    // Persistently mapped pointer to the start of the range; nullptr unless the memory is host-visible.
+    void *getMappedData() const;
+    explicit operator bool() const { return Allocator != nullptr; }
+
+  private:
+    friend class tMemoryAllocator;
+    struct tBlock;
+
+    void release();
+
+    tMemoryAllocator *Allocator{nullptr};
+    tBlock *Block{nullptr};
+    vk::DeviceSize Offset{0};
+    vk::DeviceSize Size{0};
+    // Start of the free range this allocation was cut from; Offset is that rounded up to the alignment.
+    vk::DeviceSize RangeOffset{0};
+    const std::string *Tag{nullptr};
+};
+
+// Sub-allocates buffers and images from large device memory blocks, so hundreds of resources stay far below
+// maxMemoryAllocationCount. Blocks are kept per memory type and per resource kind, buffers apart from optimal-tiling
+// images so bufferImageGranularity never applies; host-visible blocks stay mapped for their whole life. Requests
+// larger than half a block get a block of their own. Every allocation carries a tag, and the per-tag totals plus the
+// per-heap budget (VK_EXT_memory_budget where the device has it) are what the GUI's Memory tab shows.
+class tMemoryAllocator
+{
+  public:
+    enum class tResource
+    {
+        Buffer,
+        Image
+    };
+
+    struct tHeapBudget
+    {
+        vk::DeviceSize Size;
+        // Whole-process usage and budget from the driver, or the allocator's own blocks against 80% of the heap when
+        // the device lacks VK_EXT_memory_budget.
+        vk::DeviceSize Usage;
+        vk::DeviceSize Budget;
+        // Bytes in the allocator's blocks, and the part of them handed out.
+        vk::DeviceSize BlockBytes;
+        vk::DeviceSize AllocatedBytes;
+        bool DeviceLocal;
+    };
+
+    struct tTagUsage
+    {
+        std::string Tag;
+        vk::DeviceSize Bytes;
+        uint32_t Allocations;
+    };
+
+    static constexpr vk::DeviceSize DefaultBlockSize = 64ull << 20;
+
+    tMemoryAllocator(const vk::raii::PhysicalDevice &physicalDevice,
+                     const vk::raii::Device &device,
+                     bool memoryBudgetEnabled);
+    ~tMemoryAllocator();
+
+    // flags are required, except that a request for device-local memory alone falls back to any other type when
+    // device memory runs out. Throws std::runtime_error when no type can hold the request.
+    tAllocation allocate(const vk::MemoryRequirements &requirements,
+                         vk::MemoryPropertyFlags flags,
+                         tResource resource,
+                         std::string_view tag);
+    // Allocate and bind in one go.
+    tAllocation allocate(const vk::raii::Buffer &buffer, vk::MemoryPropertyFlags flags, std::string_view tag);
+    tAllocation allocate(const vk::raii::Image &image, vk::MemoryPropertyFlags flags, std::string_view tag);
+
+    std::vector<tHeapBudget> getHeapBudgets() const;
+    // Live bytes and allocations per tag, largest first.
+    std::vector<tTagUsage> getTagUsage() const;
+    uint32_t getBlockCount() const;
+    uint32_t getAllocationCount() const;
+    bool hasMemoryBudget() const { return MemoryBudgetEnabled; }
+
+  private:
+    friend class tAllocation;
+    using tBlock = tAllocation::tBlock;
+
+    struct tTagTotals
+    {
+        vk::DeviceSize Bytes{0};
+        uint32_t Allocations{0};
+    };
+
+    // First fit; the alignment padding in front stays with the allocation and returns to the block with it.
+    static bool subAllocate(tBlock &block, const vk::MemoryRequirements &requirements, tAllocation &allocation);
+
+    std::vector<tHeapBudget> computeHeapBudgets() const;
+    tBlock *createBlock(uint32_t memoryType, tResource resource, vk::DeviceSize size, bool dedicated);
+    bool fitsBudget(uint32_t heap, vk::DeviceSize size) const;
+    void free(tAllocation &allocation);
+
+    const vk::raii::PhysicalDevice &PhysicalDevice;
+    const vk::raii::Device &Device;
+    const bool MemoryBudgetEnabled;
+    vk::PhysicalDeviceMemoryProperties MemoryProperties;
+    uint32_t MaxAllocationCount;
+
+    mutable std::mutex Mutex;
+    std::vector<std::unique_ptr<tBlock>> Blocks;
+    std::map<std::string, tTagTotals, std::less<>> Tags;
+    uint32_t AllocationCount{0};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+// One vk::PipelineCache for every pipeline on the device, persisted between runs. The file carries a header of our own
+// ahead of the driver's data: format version, vendor and device ID, driver version, the pipeline cache UUID, the data
+// size and a checksum. A file written by another device, driver or format, or a damaged one, is ignored, and so is
+// data whose own Vulkan header does not match the device. save() writes a temporary file and renames it over the old
+// one, so a crash mid-write never leaves a truncated cache behind.
+class tPipelineCache
+{
+  public:
+    static constexpr uint32_t FormatVersion = 1;
+
+    // An empty path disables persistence; the cache still serves the pipelines of this run.
+    tPipelineCache(const vk::raii::PhysicalDevice &physicalDevice,
+                   const vk::raii::Device &device,
+                   std::filesystem::path path);
+    // Saves, as pipelines compiled at any point of the run are worth keeping.
+    ~tPipelineCache();
+
+    // Under $XDG_CACHE_HOME or ~/.cache, one file per pipeline cache UUID so several GPUs do not evict each other.
+    static std::filesystem::path getDefaultPath(const vk::PhysicalDeviceProperties &properties);
+
+    const vk::raii::PipelineCache &getCache() const { return Cache; }
+    const std::filesystem::path &getPath() const { return Path; }
+    // Whether the cache started from a valid file rather than empty.
+    bool wasLoaded() const { return Loaded; }
+    // Writes the current contents; returns false and logs if the file cannot be written.
+    bool save() const;
+
+  private:
+    struct tHeader
+    {
+        std::array<char, 4> Magic;
+        uint32_t FormatVersion;
+        uint32_t VendorId;
+        uint32_t DeviceId;
+        uint32_t DriverVersion;
+        std::array<uint8_t, VK_UUID_SIZE> CacheUuid;
+        uint32_t Pad0; // keeps the header free of implicit padding, which is compared bytewise
+        uint64_t DataSize;
+        uint64_t Checksum;
+    };
+
+    tHeader createHeader(uint64_t dataSize, uint64_t checksum) const;
+    std::vector<char> load() const;
+    bool isCompatible(const std::vector<char> &data) const;
+
+    const vk::raii::Device &Device;
+    const vk::PhysicalDeviceProperties Properties;
+    const std::filesystem::path Path;
+    vk::raii::PipelineCache Cache{nullptr};
+    bool Loaded{false};
+};
@@ -7,8 +7,10 @@
 // vulkan-tracy include order
 #include <tracy/TracyVulkan.hpp>
 
+#include "engine/tCamera.h"
+#include "helpers/createBuffer.h"
+
 class tSim;
-class tCamera;
 class tGui;
 class tSwapchain;
 class tVulkanDevice;
@@ -22,6 +24,35 @@ class tRenderer
     void drawFrame();
     void recreateSwapchain(vk::Extent2D extent);
 
+    // MeshShader draws the particles as point primitives through task and mesh shaders. Compute splats every live
+    // particle into a per-pixel buffer with atomics, which a full-screen pass composites; it skips the per-primitive
+    // overhead that dominates at 10^7 particles, but also the task shader's culling and LOD.
+    enum class tRasterizer
+    {
+        MeshShader,
+        Compute
+    };
+    void setRasterizer(tRasterizer rasterizer) { Rasterizer = rasterizer; }
+    tRasterizer getRasterizer() const { return Rasterizer; }
+
+    // Task shader culling counts, zero with the compute rasterizer.
+    struct tCullStats
+    {
+        uint32_t Clusters{0};   // clusters with live particles
+        uint32_t Culled{0};     // of those, outside the frustum
+        uint32_t MeshGroups{0}; // mesh workgroups emitted, one per visible cluster
+        uint32_t Points{0};     // particle slots those read after decimation
+    };
+    // Of the last frame whose graphics pass completed. ParticlePassMs is the GPU time from the start of the graphics
+    // command buffer to the end of the particle pass, 0 when the graphics queue has no timestamps.
+    struct tFrameStats
+    {
+        tRasterizer Rasterizer{tRasterizer::MeshShader};
+        tCullStats Cull{};
+        float ParticlePassMs{0.f};
+    };
+    const tFrameStats &getFrameStats() const { return FrameStats; }
+
   private:
     static constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
 
@@ -31,6 +62,10 @@ class tRenderer
     void createShaderModules();
     void createCommandBuffers();
     void createCommandPool();
+    void createSplatPipeline();
+    void createFrameStatsResources();
+    void createSplatBuffer();
+    void collectFrameStats(uint32_t ixImage);
 
     std::pair<vk::Result, uint32_t> acquireNextImage();
     std::pair<vk::Result, uint32_t> synchronizeFrame();
@@ -42,26 +77,56 @@ class tRenderer
     void recordGraphicsCommandBufferNoop(uint32_t ixImage) {};
     void recordGraphicsPass(const vk::raii::CommandBuffer &commandBuffer,
                             const vk::Image &image,
-                            const vk::raii::ImageView &imageView);
+                            const vk::raii::ImageView &imageView,
+                            uint32_t ixImage);
+    void recordSplatPass(const vk::raii::CommandBuffer &commandBuffer) const;
+    void recordParticlePassEnd(const vk::raii::CommandBuffer &commandBuffer, uint32_t ixImage) const;
     void waitTimelineValue(uint64_t value);
 
+    // Particle capacity, render stream choice, culling settings and rasterizer each reusable graphics command buffer
+    // was recorded for. The drawn particle set follows the buffer parity, which picks the command buffer instead.
+    struct tRecordedState
+    {
+        uint32_t Capacity{0};
+        bool RenderStream{false};
+        tCamera::tCulling Culling{};
+        tRasterizer Rasterizer{tRasterizer::MeshShader};
+
+        bool operator==(const tRecordedState &) const = default;
+    };
+    tRecordedState getRecordedState() const;
+    // Reusable graphics command buffers come in one per image and buffer parity, so the A/B swap alternates between
+    // two recorded buffers instead of re-recording one every frame.
+    uint32_t getGraphicsBufferIndex(uint32_t ixImage) const;
+
     const tCamera &Camera;
     const tVulkanDevice &Device;
     const tGui &Gui;
     const vk::raii::Device &LogicalDevice;
     const vk::raii::PhysicalDevice &PhysicalDevice;
     const vk::raii::Queue &Queue;
+    const vk::raii::Queue &ComputeQueue;
     tSwapchain &Swapchain;
     tSim &Sim;
 
     using RecordGraphicsFn = void (tRenderer::*)(uint32_t);
     const TracyVkCtx TracyContext;
+    const TracyVkCtx ComputeTracyContext;
     const RecordGraphicsFn RecordGraphicsPerFrame;
 
     vk::raii::PipelineLayout GraphicsPipelineLayout{nullptr};
     vk::raii::Pipeline GraphicsPipeline{nullptr};
+    vk::raii::PipelineLayout SplatPipelineLayout{nullptr};
+    vk::raii::Pipeline SplatPipeline{nullptr};
+    vk::raii::PipelineLayout CompositePipelineLayout{nullptr};
+    vk::raii::Pipeline CompositePipeline{nullptr};
+    // Attachment formats the graphics pipelines were built for; recreating the swapchain with the same keeps them.
+    vk::Format PipelineColorFormat{vk::Format::eUndefined};
+    vk::Format PipelineDepthFormat{vk::Format::eUndefined};
 
     vk::raii::CommandPool CommandPool{nullptr};
+    // Sim command buffers are submitted to the compute queue, which may belong to another family.
+    vk::raii::CommandPool ComputeCommandPool{nullptr};
     vk::raii::CommandBuffers CommandBuffers{nullptr};
     vk::raii::CommandBuffers GuiCommandBuffers{nullptr};
     vk::raii::CommandBuffers SimCommandBuffers{nullptr};
@@ -69,17 +134,41 @@ class tRenderer
     vk::raii::ShaderModule TaskShaderModule{nullptr};
     vk::raii::ShaderModule MeshShaderModule{nullptr};
     vk::raii::ShaderModule FragmentShaderModule{nullptr};
+    vk::raii::ShaderModule CompositeMeshShaderModule{nullptr};
+    vk::raii::ShaderModule CompositeFragmentShaderModule{nullptr};
 
     std::vector<vk::raii::Semaphore> ImageAvailable;
     std::vector<vk::raii::Semaphore> RenderFinished;
     vk::raii::Semaphore FrameTimeline{nullptr};
+    // Signalled by the compute queue with async compute, waited for by the graphics submit of the same frame.
+    vk::raii::Semaphore ComputeTimeline{nullptr};
+    uint64_t LastComputeValue{0};
     std::vector<uint64_t> FrameTimelineValues;
     std::vector<uint64_t> ImageTimelineValues;
+    std::vector<tRecordedState> RecordedStates;
+    // Graphics command buffer submitted with each image's last frame.
+    std::vector<uint32_t> SubmittedGraphicsBuffers;
     uint64_t LastTimelineValue{0};
     size_t IxCurrentFrame{0};
 
-    vk::MemoryBarrier2 ComputeToGraphicsBarrier{vk::PipelineStageFlagBits2::eComputeShader,
-                                                vk::AccessFlagBits2::eShaderWrite,
-                                                vk::PipelineStageFlagBits2::eMeshShaderEXT,
-                                                vk::AccessFlagBits2::eShaderRead};
+    tRasterizer Rasterizer{tRasterizer::MeshShader};
+    // One packed depth and colour word per pixel of the swapchain extent, for the compute rasterizer.
+    tStorageBuffer SplatBuffer;
+
+    // One slot and two timestamps per swapchain image, written by the graphics command buffer and read once the
+    // image's frame has completed.
+    vk::raii::Buffer CullStatsBuffer{nullptr};
+    tAllocation CullStatsMemory{nullptr};
+    tCullStats *MappedCullStats{nullptr};
+    vk::DeviceAddress CullStatsAddress{0};
+    vk::raii::QueryPool TimestampPool{nullptr};
+    float TimestampPeriod{0.f};
+    tFrameStats FrameStats{};
+
+    vk::MemoryBarrier2 ComputeToGraphicsBarrier{
+        vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+        vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eTransferWrite,
+        vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eTaskShaderEXT |
+            vk::PipelineStageFlagBits2::eMeshShaderEXT | vk::PipelineStageFlagBits2::eComputeShader,
+        vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderRead};
 };
@@ -6,12 +6,14 @@
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "engine/tMemoryAllocator.h"
+
 class tVulkanDevice;
 
 struct DepthBufferData
 {
     vk::raii::Image Image{nullptr};
-    vk::raii::DeviceMemory Memory{nullptr};
+    tAllocation Memory{nullptr};
     vk::raii::ImageView ImageView{nullptr};
 };
 
@@ -54,6 +56,7 @@ struct tSwapchain
     const vk::raii::Device *Device{nullptr};
     const vk::raii::PhysicalDevice *PhysicalDevice{nullptr};
     const vk::raii::Queue *Queue{nullptr};
+    tMemoryAllocator *Allocator{nullptr};
 
     vk::Extent2D Extent{};
     vk::Format ColorFormat = vk::Format::eR8G8B8A8Unorm;
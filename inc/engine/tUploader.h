@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "engine/tMemoryAllocator.h"
+
+class tVulkanDevice;
+
+// Host-to-buffer uploads without stalls. Data is copied into a persistently mapped staging ring right away and the
+// buffer copies are batched until flush(), which submits them and returns; nothing waits on the host unless the ring
+// laps a segment the GPU still reads from. On devices with a transfer-only queue family the copies run there: the
+// compute queue releases the destinations to the transfer queue after its earlier work, and acquires them back before
+// its later work, all ordered by one timeline semaphore. Without one the copies go on the compute queue itself. Either
+// way work submitted to the compute queue after flush() sees the uploads, and anything may wait for the value
+// upload() returns. Destinations must be exclusively owned by the compute queue family, like every simulation buffer;
+// the buffers handed over to the graphics queue are not upload targets. Not thread-safe, like the queues it submits to.
+class tUploader
+{
+  public:
+    static constexpr vk::DeviceSize SegmentSize = 8ull << 20;
+    static constexpr uint32_t SegmentCount = 4;
+
+    explicit tUploader(const tVulkanDevice &device);
+    ~tUploader();
+
+    // Timeline value at which the copy has landed; the destination must live until then. Uploads larger than the
+    // space left in a segment are split over several.
+    uint64_t upload(vk::Buffer destination, vk::DeviceSize offset, const void *data, vk::DeviceSize size);
+    // Submits the batched copies and returns the value they complete at, the last one if nothing was batched.
+    uint64_t flush();
+    bool isComplete(uint64_t value) const;
+    void wait(uint64_t value) const;
+    const vk::raii::Semaphore &getTimeline() const { return Timeline; }
+    uint64_t getSubmittedValue() const { return SubmittedValue; }
+    bool usesTransferQueue() const { return TransferFamily != ComputeFamily; }
+
+  private:
+    struct tSegment
+    {
+        // The release and acquire halves on the compute queue bracket the copies; only used with a transfer queue.
+        vk::raii::CommandBuffer Release{nullptr};
+        vk::raii::CommandBuffer Copy{nullptr};
+        vk::raii::CommandBuffer Acquire{nullptr};
+        uint64_t Value{0};
+    };
+
+    struct tCopy
+    {
+        vk::Buffer Destination;
+        vk::BufferCopy Region;
+    };
+
+    void createCommandBuffers();
+    void submit(const vk::raii::Queue &queue,
+                const vk::raii::CommandBuffer &commandBuffer,
+                uint64_t waitValue,
+                uint64_t signalValue) const;
+    // One whole-buffer barrier per distinct destination of the batch.
+    std::vector<vk::BufferMemoryBarrier2> createBarriers(vk::PipelineStageFlags2 srcStage,
+                                                         vk::AccessFlags2 srcAccess,
+                                                         vk::PipelineStageFlags2 dstStage,
+                                                         vk::AccessFlags2 dstAccess,
+                                                         uint32_t srcFamily = VK_QUEUE_FAMILY_IGNORED,
+                                                         uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED) const;
+    // Moves to the next segment, waiting for its previous batch only if the GPU has not finished it yet.
+    void advance();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const uint32_t ComputeFamily;
+    const uint32_t TransferFamily;
+
+    vk::raii::Buffer Ring{nullptr};
+    tAllocation RingMemory{nullptr};
+    char *MappedRing{nullptr};
+
+    vk::raii::CommandPool ComputePool{nullptr};
+    vk::raii::CommandPool TransferPool{nullptr};
+    std::array<tSegment, SegmentCount> Segments;
+    vk::raii::Semaphore Timeline{nullptr};
+    uint64_t SubmittedValue{0};
+
+    uint32_t Current{0};
+    vk::DeviceSize Used{0};
+    std::vector<tCopy> Copies;
+};
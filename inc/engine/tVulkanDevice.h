@@ -1,43 +1,101 @@
 #pragma once
 
+#include <memory>
+
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 // vulkan-tracy include order
 #include <tracy/TracyVulkan.hpp>
 
+#include "engine/tMemoryAllocator.h"
+#include "engine/tPipelineCache.h"
+#include "engine/tUploader.h"
+
 class tVulkanDevice
 {
   public:
-    void init(const vk::raii::Instance &instance, const vk::SurfaceKHR &surface, bool enableValidation);
+    enum class tQueueType
+    {
+        Graphics,
+        Compute
+    };
+
+    // With enableAsyncCompute the simulation gets its own queue from a compute-only family if the device has one;
+    // otherwise the compute queue is the graphics queue. Without persistPipelineCache the pipeline cache starts empty
+    // and is never written to disk, which keeps tests away from the user's cache directory.
+    void init(const vk::raii::Instance &instance,
+              const vk::SurfaceKHR &surface,
+              bool enableValidation,
+              bool enableAsyncCompute = true,
+              bool persistPipelineCache = true);
     ~tVulkanDevice();
 
-    vk::raii::CommandBuffer beginSingleTimeCommands() const;
-    void endSingleTimeCommands(vk::raii::CommandBuffer &commandBuffer) const;
+    // Simulation buffers are read back and initialised on the compute queue, which owns them. Ending flushes the
+    // uploader first, so commands recorded here see every upload issued before; it waits for this submission alone.
+    vk::raii::CommandBuffer beginSingleTimeCommands(tQueueType queue = tQueueType::Compute) const;
+    void endSingleTimeCommands(vk::raii::CommandBuffer &commandBuffer, tQueueType queue = tQueueType::Compute) const;
 
     const vk::raii::PhysicalDevice &getPhysicalDevice() const { return PhysicalDevice; }
     const vk::raii::Device &getLogicalDevice() const { return Device; }
     const vk::raii::Queue &getQueue() const { return Queue; }
     uint32_t getQueueFamily() const { return QueueFamily; }
     const vk::raii::CommandPool &getCommandPool() const { return CommandPool; }
+    const vk::raii::Queue &getComputeQueue() const { return ComputeQueue; }
+    uint32_t getComputeQueueFamily() const { return ComputeQueueFamily; }
+    bool hasAsyncCompute() const { return ComputeQueueFamily != QueueFamily; }
+    // A transfer-only family for uploads if the device has one, the compute queue otherwise.
+    const vk::raii::Queue &getTransferQueue() const { return TransferQueue; }
+    uint32_t getTransferQueueFamily() const { return TransferQueueFamily; }
+    bool hasTransferQueue() const { return TransferQueueFamily != ComputeQueueFamily; }
+    // Every buffer and image is sub-allocated from here; allocating changes its state, hence non-const.
+    tMemoryAllocator &getAllocator() const { return *Allocator; }
+    bool hasMemoryBudget() const { return MemoryBudgetEnabled; }
+    // Uploads into buffers owned by the compute queue; submitting changes its state, hence non-const.
+    tUploader &getUploader() const { return *Uploader; }
+    // Every pipeline is created through this cache, which is loaded at init and saved when the device goes.
+    const vk::raii::PipelineCache &getPipelineCache() const { return PipelineCache->getCache(); }
     TracyVkCtx getTracyContext() const { return TracyContext; }
+    // Context for command buffers submitted to the compute queue, the graphics one without async compute.
+    TracyVkCtx getComputeTracyContext() const { return ComputeTracyContext; }
 
   private:
     void pickPhysicalDevice(const vk::raii::Instance &instance);
+    void pickComputeQueueFamily();
+    void pickTransferQueueFamily();
     void createLogicalDevice();
+    void createPipelineCache();
     void createCommandPool();
+    void createAllocator();
+    void createUploader();
     void initTracyContext();
     bool supportsRequiredFeaturesAndExtensions(vk::PhysicalDevice device) const;
     bool queueSupportsPresent(vk::PhysicalDevice device, uint32_t queueFamily, vk::SurfaceKHR Surface);
 
     vk::raii::PhysicalDevice PhysicalDevice{nullptr};
     vk::raii::Device Device{nullptr};
+    // After Device, so every block is freed before the device goes.
+    std::unique_ptr<tMemoryAllocator> Allocator;
+    // After Device, so it is saved while the device is still alive.
+    std::unique_ptr<tPipelineCache> PipelineCache;
+    // After Allocator, so it drains its last uploads and frees its staging ring first.
+    std::unique_ptr<tUploader> Uploader;
     vk::raii::CommandPool CommandPool{nullptr};
+    vk::raii::CommandPool ComputeCommandPool{nullptr};
     vk::raii::Queue Queue{nullptr};
+    vk::raii::Queue ComputeQueue{nullptr};
+    vk::raii::Queue TransferQueue{nullptr};
     vk::raii::CommandBuffer TracyCommandBuffer{nullptr};
+    vk::raii::CommandBuffer ComputeTracyCommandBuffer{nullptr};
     uint32_t QueueFamily = 0;
+    uint32_t ComputeQueueFamily = 0;
+    uint32_t TransferQueueFamily = 0;
     vk::SurfaceKHR Surface = VK_NULL_HANDLE;
 
     TracyVkCtx TracyContext{nullptr};
+    TracyVkCtx ComputeTracyContext{nullptr};
     bool ValidationEnabled = false;
+    bool AsyncComputeEnabled = true;
+    bool PipelineCachePersisted = true;
+    bool MemoryBudgetEnabled = false;
 };
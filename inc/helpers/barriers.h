@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+// Makes compute shader writes visible to the next compute dispatch.
+void recordComputeBarrier(const vk::raii::CommandBuffer &commandBuffer);
+
+// Makes compute shader writes visible to indirect dispatch/draw arguments and to the next compute dispatch.
+void recordComputeToIndirectBarrier(const vk::raii::CommandBuffer &commandBuffer);
+
+// Makes fill/update/copy writes visible to the next compute dispatch.
+void recordTransferToComputeBarrier(const vk::raii::CommandBuffer &commandBuffer);
+
+// Orders earlier compute dispatches before fill/update/copy commands that overwrite their buffers.
+void recordComputeToTransferBarrier(const vk::raii::CommandBuffer &commandBuffer);
+
+// Makes compute shader writes to host-visible memory visible to host reads once the submission has completed.
+void recordComputeToHostBarrier(const vk::raii::CommandBuffer &commandBuffer);
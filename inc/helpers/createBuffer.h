@@ -1,15 +1,35 @@
 #pragma once
 
+#include <string_view>
+
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "engine/tMemoryAllocator.h"
+
 class tVulkanDevice;
 
-std::tuple<vk::raii::Buffer, vk::raii::DeviceMemory, void *>
-createBuffer(const tVulkanDevice &device,
-             const vk::DeviceSize bufferSize,
-             const vk::BufferUsageFlags usageFlags,
-             const vk::SharingMode sharingMode,
-             const vk::MemoryPropertyFlags memoryPropertyFlags,
-             const void *data);
\ No newline at end of file
+struct tStorageBuffer
+{
+    vk::raii::Buffer Buffer{nullptr};
+    tAllocation Memory{nullptr};
+    vk::DeviceAddress Address{0};
+};
+
+// The memory comes from the device's tMemoryAllocator and is counted under tag in its ledger. The pointer is the
+// persistently mapped memory for host-visible buffers, nullptr otherwise. Initial data for device memory goes through
+// the device's tUploader without waiting; work submitted to the compute queue from then on sees it.
+std::tuple<vk::raii::Buffer, tAllocation, void *> createBuffer(const tVulkanDevice &device,
+                                                               const vk::DeviceSize bufferSize,
+                                                               const vk::BufferUsageFlags usageFlags,
+                                                               const vk::SharingMode sharingMode,
+                                                               const vk::MemoryPropertyFlags memoryPropertyFlags,
+                                                               const void *data,
+                                                               std::string_view tag);
+
+// Device-local storage buffer that shaders reach through its buffer device address.
+tStorageBuffer createStorageBuffer(const tVulkanDevice &device,
+                                   const vk::DeviceSize bufferSize,
+                                   std::string_view tag,
+                                   const vk::BufferUsageFlags extraUsageFlags = {});
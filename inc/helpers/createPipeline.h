@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+// Loads the SPIR-V file and builds a compute pipeline on the given layout through the cache. The module is released
+// afterwards.
+vk::raii::Pipeline createComputePipeline(const vk::raii::Device &device,
+                                         const vk::raii::PipelineCache &cache,
+                                         const vk::raii::PipelineLayout &layout,
+                                         const std::string &shaderFileName);
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include <vulkan/vulkan.hpp>
-#include <vulkan/vulkan_raii.hpp>
 
-vk::MemoryAllocateInfo getMemoryAllocateInfo(const vk::raii::PhysicalDevice &PhysicalDevice,
-                                             vk::MemoryRequirements memoryRequirements,
-                                             vk::MemoryPropertyFlags requirementsMask,
-                                             const void *pNext = nullptr);
+// Memory types allowed by memoryTypeBits that have every required flag, best first: those with every preferred flag,
+// then those with the fewest flags beyond the required and preferred ones, so device-local requests do not take the
+// small host-visible BAR heap and host requests do not take device memory. Lazily allocated and protected types only
+// qualify when asked for. Empty if nothing matches.
+std::vector<uint32_t> rankMemoryTypes(const vk::PhysicalDeviceMemoryProperties &memoryProperties,
+                                      uint32_t memoryTypeBits,
+                                      vk::MemoryPropertyFlags required,
+                                      vk::MemoryPropertyFlags preferred = {});
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "tParticle.h"
+
+// Initial states shared by the GPU and CPU backends. Every particle draws from its own Philox stream, keyed by Seed
+// and addressed by its index, so the same settings give the same particles bit for bit on any number of threads.
+// Particles have ParticleMass each; the equilibrium models take their velocities from the total mass, with the
+// gravitational constant of the force kernels.
+struct tInitialConditions
+{
+    enum class tModel
+    {
+        // count particles on a shell of radius 2, circling a tilted axis.
+        Shell,
+        // Plummer sphere of ScaleRadius, isotropic velocities from its distribution function.
+        Plummer,
+        // Hernquist sphere of ScaleRadius, isotropic velocities from the Jeans equation.
+        Hernquist,
+        // Exponential disk of scale length ScaleRadius and sech^2 profile of DiskScaleHeight, on circular orbits of
+        // its enclosed mass plus DiskDispersion of the circular speed, tilted by DiskInclination about the x axis.
+        Disk,
+        // Two disks of half the particles each, the second tilted by MergerInclination more, falling towards each
+        // other on a parabolic orbit from MergerSeparation apart with MergerImpactParameter.
+        Merger,
+        // count particles at rest on a cubic lattice of side ScaleRadius, n = ceil(cbrt(count)) sites per axis filled
+        // x first; with count = n^3 the unperturbed start of a periodic box of that side.
+        Lattice
+    };
+
+    tModel Model{tModel::Shell};
+    uint64_t Seed{12345};
+    float ParticleMass{1.f};
+    float ScaleRadius{1.f};
+    // Models are cut off at this many scale radii; the velocities still follow the untruncated model.
+    float TruncationRadius{10.f};
+    float DiskScaleHeight{0.1f};
+    float DiskDispersion{0.05f};
+    float DiskInclination{0.5f};
+    float MergerSeparation{8.f};
+    float MergerImpactParameter{2.f};
+    float MergerInclination{1.f};
+};
+
+// The default shell.
+std::vector<tParticle> createInitialParticles(uint32_t count);
+// threadCount 0 uses every hardware thread.
+std::vector<tParticle> createInitialParticles(uint32_t count,
+                                              const tInitialConditions &conditions,
+                                              uint32_t threadCount = 0);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+// Subset of particles a force pass evaluates, compacted on the GPU. Shaders read Indices and Count through their
+// device addresses; DispatchOffset in Dispatch holds the vk::DispatchIndirectCommand for LocalSize-wide groups.
+// Without Indices the list stands for every live slot [0, *Count), see tParticlePool::getLiveList().
+struct tActiveList
+{
+    static constexpr uint32_t LocalSize = 128;
+
+    vk::DeviceAddress Indices{0};
+    vk::DeviceAddress Count{0};
+    vk::Buffer Dispatch{nullptr};
+    vk::DeviceSize DispatchOffset{0};
+
+    bool isAll() const { return Indices == 0; }
+    bool isValid() const { return Count != 0; }
+};
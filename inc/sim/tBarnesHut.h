@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tActiveList.h"
+#include "tRadixSort.h"
+
+class tVulkanDevice;
+
+// Barnes-Hut gravity on the GPU: bounds, Morton keys, radix sort, radix-tree build, center-of-mass
+// upward pass and an opening-angle traversal that writes one acceleration per particle. The tree always covers
+// every slot of the pool, free ones included since they carry no mass; with an active list only the listed
+// particles walk it.
+class tBarnesHut
+{
+  public:
+    tBarnesHut(const tVulkanDevice &device,
+               const vk::raii::DescriptorSetLayout &descriptorLayout,
+               uint32_t numParticles);
+    ~tBarnesHut() { spdlog::info("tBarnesHut: Destroyed"); }
+
+    void setOpeningAngle(float theta) { OpeningAngle = theta; }
+    float getOpeningAngle() const { return OpeningAngle; }
+    void recordBarnesHutPass(const vk::raii::CommandBuffer &commandBuffer,
+                             const vk::raii::DescriptorSet &set,
+                             vk::DeviceAddress accelerations,
+                             const tActiveList &active = {}) const;
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+    static constexpr uint32_t ForceLocalSize = tActiveList::LocalSize;
+    // Keep in sync with bhForce.comp, whose traversal stack is sized from it.
+    static constexpr uint32_t MortonBits = 30;
+
+    void createBuffers();
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+    void dispatch(const vk::raii::CommandBuffer &commandBuffer,
+                  const vk::raii::Pipeline &pipeline,
+                  const vk::raii::DescriptorSet &set,
+                  uint32_t count,
+                  uint32_t localSize,
+                  vk::DeviceAddress accelerations,
+                  const tActiveList &active) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t NumParticles;
+    const uint32_t NumNodes;
+
+    float OpeningAngle{0.5f};
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline BoundsPipeline{nullptr};
+    vk::raii::Pipeline MortonPipeline{nullptr};
+    vk::raii::Pipeline BuildPipeline{nullptr};
+    vk::raii::Pipeline SummarizePipeline{nullptr};
+    vk::raii::Pipeline ForcePipeline{nullptr};
+
+    tStorageBuffer Keys;
+    tStorageBuffer Values;
+    tStorageBuffer Bounds;
+    tStorageBuffer Children;
+    tStorageBuffer Parents;
+    tStorageBuffer NodeMass;
+    tStorageBuffer BoxMin;
+    tStorageBuffer BoxMax;
+    tStorageBuffer VisitCounts;
+
+    std::unique_ptr<tRadixSort> Sort{nullptr};
+};
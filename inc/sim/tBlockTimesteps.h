@@ -0,0 +1,98 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tActiveList.h"
+#include "tPrefixScan.h"
+
+class tVulkanDevice;
+
+// Hierarchical block timesteps: every particle sits in a power-of-two level k and steps by DeltaTime / 2^k.
+// A frame is split into 2^(Levels - 1) finest substeps. All particles drift every substep; at the end of a
+// substep only the levels whose step ends there are active, get new forces through a compacted active list and
+// indirect dispatch, and are kicked with their own step size (hierarchical KDK).
+class tBlockTimesteps
+{
+  public:
+    static constexpr uint32_t MaxLevels = 8;
+
+    // Parts of the per-particle kick, combined as bit flags.
+    enum tKick : uint32_t
+    {
+        KickClosing = 1,
+        KickReassign = 2,
+        KickOpening = 4
+    };
+
+    struct tParams
+    {
+        uint32_t Levels{4};   // 1 to MaxLevels; 1 is plain leapfrog at DeltaTime
+        float Accuracy{0.05f}; // eta in dt = eta * sqrt(softening / |a|)
+    };
+
+    tBlockTimesteps(const tVulkanDevice &device,
+                    const vk::raii::DescriptorSetLayout &descriptorLayout,
+                    uint32_t numParticles,
+                    const tParams &params = {});
+    ~tBlockTimesteps() { spdlog::info("tBlockTimesteps: Destroyed"); }
+
+    void setParams(const tParams &params);
+    const tParams &getParams() const { return Params; }
+    uint32_t getSubsteps() const { return 1u << (Params.Levels - 1); }
+
+    // Kicks the active particles in place; syncTime is the substep the kick happens at, modulo getSubsteps().
+    // A non-zero renderStream also receives the packed fp16 render data of the kicked particles.
+    void recordKick(const vk::raii::CommandBuffer &commandBuffer,
+                    const vk::raii::DescriptorSet &set,
+                    vk::DeviceAddress accelerations,
+                    uint32_t syncTime,
+                    uint32_t kickFlags,
+                    const tActiveList &active,
+                    vk::DeviceAddress renderStream = 0) const;
+
+    // Builds the list of live particles whose step ends after substep syncTime, in index order. Ends with a
+    // barrier that makes the list and its dispatch arguments visible to indirect compute dispatches.
+    tActiveList recordCompaction(const vk::raii::CommandBuffer &commandBuffer,
+                                 uint32_t syncTime,
+                                 const tActiveList &live) const;
+
+    const vk::raii::Buffer &getLevelsBuffer() const { return Levels.Buffer; }
+    const vk::raii::Buffer &getActiveIndicesBuffer() const { return ActiveIndices.Buffer; }
+    const vk::raii::Buffer &getDispatchBuffer() const { return Dispatch.Buffer; }
+
+    // Lowest level whose step ends after substep syncTime, 0 < syncTime < 2^maxLevel.
+    static uint32_t minActiveLevel(uint32_t syncTime, uint32_t maxLevel);
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+
+    void createBuffers();
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t NumParticles;
+
+    tParams Params;
+
+    vk::raii::PipelineLayout KickPipelineLayout{nullptr};
+    vk::raii::PipelineLayout CompactPipelineLayout{nullptr};
+    vk::raii::Pipeline KickPipeline{nullptr};
+    vk::raii::Pipeline FlagsPipeline{nullptr};
+    vk::raii::Pipeline CompactPipeline{nullptr};
+
+    tStorageBuffer Levels;
+    tStorageBuffer Offsets;
+    tStorageBuffer ActiveIndices;
+    tStorageBuffer Dispatch;
+
+    std::unique_ptr<tPrefixScan> Scan{nullptr};
+};
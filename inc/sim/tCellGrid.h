@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tParticle.h"
+#include "tPrefixScan.h"
+
+class tVulkanDevice;
+
+// Uniform spatial grid rebuilt on the GPU with a counting sort: per-cell histogram, prefix scan, scatter.
+// Cell c holds SortedIndices[CellStart[c] .. CellStart[c] + CellCount[c]); particles outside the grid are
+// clamped into the border cells.
+class tCellGrid
+{
+  public:
+    struct tParams
+    {
+        glm::uvec3 Dimensions{32, 32, 32};
+        float CellSize{0.25f};
+        glm::vec3 Origin{-4.f, -4.f, -4.f};
+    };
+
+    // Host-side counting sort with the same cell assignment as the GPU, for tests and debugging.
+    struct tReference
+    {
+        std::vector<uint32_t> CellStart;
+        std::vector<uint32_t> CellCount;
+        std::vector<uint32_t> SortedIndices;
+    };
+
+    tCellGrid(const tVulkanDevice &device,
+              const vk::raii::DescriptorSetLayout &descriptorLayout,
+              uint32_t numParticles,
+              const tParams &params);
+    ~tCellGrid() { spdlog::info("tCellGrid: Destroyed"); }
+
+    // Rebuilds the grid from the read particle buffer bound in set and ends with a compute barrier.
+    void recordBuildPass(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set) const;
+
+    // Dimensions are fixed by the allocation; origin and cell size may change between steps.
+    void setCellSize(float cellSize) { Params.CellSize = cellSize; }
+    void setOrigin(const glm::vec3 &origin) { Params.Origin = origin; }
+    const tParams &getParams() const { return Params; }
+    uint32_t getCellTotal() const { return CellTotal; }
+
+    const vk::raii::Buffer &getCellStartBuffer() const { return CellStart.Buffer; }
+    const vk::raii::Buffer &getCellCountBuffer() const { return CellCount.Buffer; }
+    const vk::raii::Buffer &getSortedIndicesBuffer() const { return SortedIndices.Buffer; }
+    vk::DeviceAddress getCellStartAddress() const { return CellStart.Address; }
+    vk::DeviceAddress getCellCountAddress() const { return CellCount.Address; }
+    vk::DeviceAddress getSortedIndicesAddress() const { return SortedIndices.Address; }
+
+    static uint32_t cellIndex(const glm::vec3 &position, const tParams &params);
+    static tReference buildReference(const std::vector<tParticle> &particles, const tParams &params);
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+
+    void createBuffers();
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+    void dispatch(const vk::raii::CommandBuffer &commandBuffer,
+                  const vk::raii::Pipeline &pipeline,
+                  const vk::raii::DescriptorSet &set) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t NumParticles;
+
+    tParams Params;
+    const uint32_t CellTotal;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline CountPipeline{nullptr};
+    vk::raii::Pipeline ScatterPipeline{nullptr};
+
+    tStorageBuffer CellIds;
+    tStorageBuffer CellCount;
+    tStorageBuffer CellStart;
+    tStorageBuffer CellCursor;
+    tStorageBuffer SortedIndices;
+
+    std::unique_ptr<tPrefixScan> Scan{nullptr};
+};
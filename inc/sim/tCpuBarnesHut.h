@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include "tParticle.h"
+#include "tThreadPool.h"
+
+// Barnes-Hut gravity on the CPU for headless nodes with large particle counts. Every step sorts the particles along
+// a 63-bit Morton curve with a parallel radix sort, builds an octree over the sorted order (the top levels serially,
+// the subtrees below them in parallel, one node array per task, spliced afterwards) and walks it once per particle
+// with the same opening criterion and softening as bhForce.comp. Works directly on tParticle arrays.
+class tCpuBarnesHut
+{
+  public:
+    struct tParams
+    {
+        float OpeningAngle{0.5f};
+        // Max particles in a leaf; the walk sums leaves directly.
+        uint32_t LeafSize{8};
+    };
+
+    // threadCount 0 uses every hardware thread.
+    explicit tCpuBarnesHut(uint32_t threadCount = 0);
+    ~tCpuBarnesHut() { spdlog::info("tCpuBarnesHut: Destroyed"); }
+
+    void setParams(const tParams &params) { Params = params; }
+    const tParams &getParams() const { return Params; }
+
+    // One acceleration per particle, in the order of particles. Free slots (no mass) get none.
+    std::vector<glm::vec3> computeAccelerations(const std::vector<tParticle> &particles);
+    // One semi-implicit Euler step in place: forces, v += a dt, x += v dt.
+    void step(std::vector<tParticle> &particles, float deltaTime);
+
+    uint32_t getThreadCount() const { return Pool.getThreadCount(); }
+    // Nodes of the last tree, leaves included.
+    size_t getNodeCount() const { return Nodes.size(); }
+
+  private:
+    // Bits per axis of the Morton keys, also the deepest level of the tree.
+    static constexpr uint32_t MortonBits = 21;
+    static constexpr uint32_t RadixBits = 8;
+    static constexpr uint32_t RadixPasses = (3 * MortonBits + RadixBits - 1) / RadixBits;
+    static constexpr size_t SortChunkSize = 16384;
+    static constexpr size_t ChunkSize = 1024;
+    // Walks use an explicit stack; every opened node pushes at most 8 children per level.
+    static constexpr uint32_t StackSize = 8 * MortonBits + 8;
+
+    struct tNode
+    {
+        glm::vec4 CenterOfMass; // xyz = center of mass, w = total mass
+        glm::vec3 CellMin;
+        float CellSize;
+        uint32_t Begin; // range of sorted particles
+        uint32_t End;
+        uint32_t FirstChild; // children are contiguous
+        uint32_t ChildCount; // 0 for leaves
+    };
+
+    // A cell whose subtree is still to be built.
+    struct tCell
+    {
+        uint32_t Node;
+        uint32_t Level;
+    };
+
+    void sortParticles(const std::vector<tParticle> &particles);
+    void buildTree();
+    // Splits root and its descendants down to leaves, appending children after their parent. With deferBelow set,
+    // internal cells of fewer particles are left unsplit and returned, to be built as separate tasks.
+    std::vector<tCell> splitCells(std::vector<tNode> &nodes, tCell root, size_t deferBelow) const;
+    void summarize(tNode &node, const std::vector<tNode> &nodes) const;
+    glm::vec3 walk(uint32_t sorted) const;
+
+    tParams Params;
+    tThreadPool Pool;
+
+    // Sorted state, reused across steps.
+    std::vector<uint64_t> Keys;
+    std::vector<uint32_t> Order;
+    std::vector<uint64_t> KeysScratch;
+    std::vector<uint32_t> OrderScratch;
+    std::vector<glm::vec4> SortedPositions;
+    glm::vec3 RootMin{0.f};
+    float RootSize{1.f};
+    std::vector<tNode> Nodes;
+};
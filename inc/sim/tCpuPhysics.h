@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include "constants.h"
+#include "tParticle.h"
+#include "tThreadPool.h"
+
+// CPU counterpart of tPhysics for nodes without a GPU: the direct-sum force of forceNaive.comp and the default
+// semi-implicit Euler step, on structure-of-arrays state. The force kernel is picked at runtime from the best
+// instruction set the CPU supports and runs on a work-stealing thread pool over blocks of target particles.
+class tCpuPhysics
+{
+  public:
+    // Scalar is portable, Avx2 evaluates 8 targets per instruction, Avx512 16.
+    enum class tKernel
+    {
+        Scalar,
+        Avx2,
+        Avx512
+    };
+
+    // Max acceleration difference to the scalar kernel, relative to the largest acceleration. The vector kernels
+    // refine a reciprocal square root estimate instead of dividing.
+    static constexpr float KernelTolerance = 1e-4f;
+
+    struct tParams
+    {
+        float DeltaTime;
+    };
+
+    // The first count slots get the default initial particles; threadCount 0 uses every hardware thread.
+    explicit tCpuPhysics(uint32_t count = NUM_PARTICLES, uint32_t threadCount = 0);
+    ~tCpuPhysics() { spdlog::info("tCpuPhysics: Destroyed"); }
+
+    void updateParams(const tParams &params) { Params = params; }
+    // Falls back to the best supported kernel when kernel is not available on this CPU.
+    void setKernel(tKernel kernel);
+    tKernel getKernel() const { return Kernel; }
+    static bool isSupported(tKernel kernel);
+    static tKernel getBestKernel();
+
+    // Fills the accelerations of every particle from the current positions.
+    void computeAccelerations();
+    // One semi-implicit Euler step: forces, v += a dt, x += v dt.
+    void step();
+
+    uint32_t getCount() const { return Count; }
+    uint32_t getThreadCount() const { return Pool.getThreadCount(); }
+    std::vector<tParticle> getParticles() const;
+    void setParticles(const std::vector<tParticle> &particles);
+    std::vector<glm::vec3> getAccelerations() const;
+    // Pair interactions per second of the last computeAccelerations(), Count^2 / wall time.
+    double getInteractionsPerSecond() const { return InteractionsPerSecond; }
+
+  private:
+    // Arrays are padded to a whole number of widest vectors; padding slots have no mass.
+    static constexpr uint32_t Padding = 16;
+    // Targets per work-stealing chunk, a multiple of Padding.
+    static constexpr size_t ChunkSize = 256;
+
+    void resize(uint32_t count);
+
+    uint32_t Count{0};
+    tKernel Kernel;
+    tParams Params{0.f};
+    double InteractionsPerSecond{0.0};
+    tThreadPool Pool;
+
+    std::vector<float> PosX, PosY, PosZ, Mass;
+    std::vector<float> VelX, VelY, VelZ;
+    std::vector<float> AccX, AccY, AccZ;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tParticle.h"
+#include "tPhysics.h"
+
+class tVulkanDevice;
+
+// Conserved quantities of the particle state, reduced on the GPU and read back through a ring of host-visible slots
+// a few frames late, like the pool counters, so watching them never stalls the pipeline. Kinetic energy, linear and
+// angular momentum and center of mass are exact sums over all live slots; the potential energy is O(N^2) and is
+// estimated from a strided sample of slots, each summed against every other particle with the softening of the
+// force kernels.
+class tDiagnostics
+{
+  public:
+    // Layout of one reduction record on the device, see diagnosticsBlocks.comp.
+    struct tRecord
+    {
+        glm::vec4 Energy;          // x = kinetic, y = potential, z = mass, w = live particles
+        glm::vec4 Momentum;        // xyz
+        glm::vec4 AngularMomentum; // xyz, about the origin
+        glm::vec4 MassMoment;      // xyz = sum of mass * position
+    };
+
+    struct tSample
+    {
+        uint64_t Step{0};
+        float Kinetic{0.f};
+        float Potential{0.f};
+        float Mass{0.f};
+        uint32_t Count{0};
+        glm::vec3 Momentum{0.f};
+        glm::vec3 AngularMomentum{0.f};
+        glm::vec3 CenterOfMass{0.f};
+
+        float getTotalEnergy() const { return Kinetic + Potential; }
+        static tSample fromRecord(const tRecord &record, uint64_t step);
+    };
+
+    // Covers buffers of up to maxCapacity slots, so it outlives pool growth along with its readback ring.
+    tDiagnostics(const tVulkanDevice &device, uint32_t maxCapacity, uint32_t readbackSlots);
+    ~tDiagnostics() { spdlog::info("tDiagnostics: Destroyed"); }
+
+    // Reduces slots [0, count) of buffers holding capacity slots, with count read from particleCount on the GPU, and
+    // copies the record into readback slot. About potentialSamples slots estimate the potential energy, 0 skips it.
+    // Expects the last writes to buffers to be visible to compute shaders.
+    void recordDiagnostics(const vk::raii::CommandBuffer &commandBuffer,
+                           const tPhysics::tParticleBuffers &buffers,
+                           uint32_t capacity,
+                           vk::DeviceAddress particleCount,
+                           uint32_t potentialSamples,
+                           uint32_t slot) const;
+    tRecord readRecord(uint32_t slot) const;
+
+    // The same reduction on the host in double precision, for tests.
+    static tRecord computeRecord(const std::vector<tParticle> &particles, uint32_t potentialSamples);
+
+  private:
+    static constexpr uint32_t LocalSize = 128;
+
+    void createBuffers();
+    void createPipelines();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t MaxCapacity;
+    const uint32_t ReadbackSlots;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline BlocksPipeline{nullptr};
+    vk::raii::Pipeline CombinePipeline{nullptr};
+
+    tStorageBuffer BlockRecords;
+    tStorageBuffer Result;
+    vk::raii::Buffer ReadbackBuffer{nullptr};
+    tAllocation ReadbackMemory{nullptr};
+    void *MappedReadback{nullptr};
+};
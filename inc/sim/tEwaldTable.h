@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "engine/tMemoryAllocator.h"
+
+class tVulkanDevice;
+
+// Ewald correction for gravity in a periodic box: the force of a particle and all its periodic images against a
+// uniform neutralising background, minus the Newtonian force of its minimum image alone. Tabulated once on the host
+// for a unit box over the octant [0, 1/2]^3 of separations and sampled as a 3D texture, so the direct force kernels
+// only add one lookup per interaction. Each component is odd in its own axis and even in the others, so the other
+// octants follow by sign flips; a box of side L scales the unit-box correction by 1 / L^2.
+class tEwaldTable
+{
+  public:
+    // Texels per axis; texel i sits at separation i / (2 (Size - 1)), so both 0 and 1/2 are sampled exactly.
+    // Keep in sync with EwaldTableSize in the force kernels.
+    static constexpr uint32_t Size = 32;
+
+    explicit tEwaldTable(const tVulkanDevice &device);
+    ~tEwaldTable() { spdlog::info("tEwaldTable: Destroyed"); }
+
+    // Correction per unit G m for a neighbour at separation r in a unit box, added to r / |r|^3.
+    static glm::dvec3 computeCorrection(const glm::dvec3 &r);
+    // Size^3 texels, x fastest, correction in xyz; threadCount 0 uses every hardware thread.
+    static std::vector<glm::vec4> computeTable(uint32_t threadCount = 0);
+
+    const vk::raii::ImageView &getImageView() const { return ImageView; }
+    const vk::raii::Sampler &getSampler() const { return Sampler; }
+
+  private:
+    void createImage();
+    void uploadTable();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const vk::raii::PhysicalDevice &PhysicalDevice;
+
+    // fp32 where the device filters it linearly, fp16 otherwise.
+    vk::Format Format{vk::Format::eR32G32B32A32Sfloat};
+    vk::raii::Image Image{nullptr};
+    tAllocation Memory{nullptr};
+    vk::raii::ImageView ImageView{nullptr};
+    vk::raii::Sampler Sampler{nullptr};
+};
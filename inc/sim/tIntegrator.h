@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tActiveList.h"
+
+class tVulkanDevice;
+
+// Time integration split from force evaluation. A scheme is a sequence of stages: force evaluations, which the
+// active solver records into the acceleration buffer, and kick/drift passes that update the working particle
+// state in place. Coefficients are fractions of DeltaTime.
+class tIntegrator
+{
+  public:
+    enum class tScheme
+    {
+        SemiImplicitEuler,
+        LeapfrogKdk,
+        VelocityVerlet,
+        Yoshida4
+    };
+
+    enum class tStageType
+    {
+        Force,
+        Kick,
+        Drift
+    };
+
+    struct tStage
+    {
+        tStageType Type;
+        float Kick{0.f};
+        float Drift{0.f};
+    };
+
+    tIntegrator(const tVulkanDevice &device,
+                const vk::raii::DescriptorSetLayout &descriptorLayout,
+                uint32_t numParticles,
+                tScheme scheme = tScheme::SemiImplicitEuler);
+    ~tIntegrator() { spdlog::info("tIntegrator: Destroyed"); }
+
+    void setScheme(tScheme scheme);
+    tScheme getScheme() const { return Scheme; }
+    const std::vector<tStage> &getStages() const { return Stages; }
+
+    // Schemes that start with a kick reuse the forces of the previous step's last evaluation.
+    bool reusesForces() const { return reusesForces(Scheme); }
+
+    // Updates the live slots of live, dispatched indirectly from its count. A non-zero renderStream also receives
+    // the packed fp16 render data of the updated slots.
+    void recordStage(const vk::raii::CommandBuffer &commandBuffer,
+                     const vk::raii::DescriptorSet &set,
+                     const tStage &stage,
+                     const tActiveList &live,
+                     vk::DeviceAddress renderStream = 0) const;
+
+    vk::DeviceAddress getAccelerationAddress() const { return Accelerations.Address; }
+    const vk::raii::Buffer &getAccelerationBuffer() const { return Accelerations.Buffer; }
+
+    static std::vector<tStage> buildStages(tScheme scheme);
+    static bool reusesForces(tScheme scheme) { return scheme != tScheme::SemiImplicitEuler; }
+
+  private:
+    void createBuffers();
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t NumParticles;
+
+    tScheme Scheme;
+    std::vector<tStage> Stages;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline KickPipeline{nullptr};
+    vk::raii::Pipeline DriftPipeline{nullptr};
+
+    tStorageBuffer Accelerations;
+};
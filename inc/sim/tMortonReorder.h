@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tPhysics.h"
+#include "tRadixSort.h"
+
+class tParticlePool;
+class tVulkanDevice;
+
+// Reorders the particles along a Z-order curve so neighbours in space are neighbours in memory. Bounds and 30-bit
+// Morton keys of the live particles are sorted with tRadixSort, then both streams of every slot are gathered from the
+// read set into the write set together with its stable ID. Free slots sort last, so the reorder also compacts the pool.
+class tMortonReorder
+{
+  public:
+    tMortonReorder(const tVulkanDevice &device, uint32_t capacity);
+    ~tMortonReorder() { spdlog::info("tMortonReorder: Destroyed"); }
+
+    // Writes the reordered source particles to destination and rewrites the pool's IDs and counters. Takes the
+    // place of the copy that starts a step and ends with a barrier for indirect dispatches.
+    void recordReorder(const vk::raii::CommandBuffer &commandBuffer,
+                       const vk::raii::DescriptorSet &set,
+                       const tPhysics::tParticleBuffers &source,
+                       const tPhysics::tParticleBuffers &destination,
+                       const tParticlePool &pool) const;
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+    static constexpr uint32_t KeyBits = 31;
+
+    void createBuffers();
+    void createPipelines();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t Capacity;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline BoundsPipeline{nullptr};
+    vk::raii::Pipeline KeysPipeline{nullptr};
+    vk::raii::Pipeline GatherPipeline{nullptr};
+
+    tStorageBuffer Keys;
+    tStorageBuffer Values;
+    tStorageBuffer Bounds;
+    tStorageBuffer ScratchIds;
+
+    std::unique_ptr<tRadixSort> Sort{nullptr};
+};
@@ -2,8 +2,10 @@
 
 #include <glm/glm.hpp>
 
+// Host-side view of one slot. On the device positions and velocities live in separate streams, see
+// tPhysics::tParticleBuffers.
 struct tParticle
 {
     glm::vec4 Position; // xyz = position, w = mass
     glm::vec4 Velocity; // xyz = velocity
-};
\ No newline at end of file
+};
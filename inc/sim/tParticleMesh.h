@@ -0,0 +1,90 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+
+class tVulkanDevice;
+
+// Particle-Mesh gravity in a periodic box: cloud-in-cell deposit with fixed-point atomics, 3D FFT, Poisson
+// solve in k-space, inverse FFT, central-difference gradient and CIC interpolation of the particle accelerations.
+class tParticleMesh
+{
+  public:
+    static constexpr uint32_t MaxGridSize = 1024;
+
+    struct tParams
+    {
+        uint32_t GridSize{64}; // cells per axis, power of two up to MaxGridSize
+        float BoxSize{8.f};
+        glm::vec3 Origin{-4.f, -4.f, -4.f};
+    };
+
+    tParticleMesh(const tVulkanDevice &device,
+                  const vk::raii::DescriptorSetLayout &descriptorLayout,
+                  uint32_t numParticles,
+                  float totalMass,
+                  const tParams &params);
+    ~tParticleMesh() { spdlog::info("tParticleMesh: Destroyed"); }
+
+    void recordParticleMeshPass(const vk::raii::CommandBuffer &commandBuffer,
+                                const vk::raii::DescriptorSet &set,
+                                vk::DeviceAddress accelerations) const;
+
+    // In-place 3D FFT of GridSize^3 complex floats at data: direction 1 is forward, -1 the unnormalized inverse.
+    void recordFft(const vk::raii::CommandBuffer &commandBuffer, vk::DeviceAddress data, int direction) const;
+
+    const tParams &getParams() const { return Params; }
+    // Cell masses of the last pass in fixed point: a low and a high 32-bit word per cell, massScale units per mass.
+    const tStorageBuffer &getDensity() const { return Density; }
+    float getMassScale() const { return MassScale; }
+
+    // Separable direct DFT in double precision with the same conventions as recordFft.
+    static std::vector<std::complex<float>>
+    dftReference(const std::vector<std::complex<float>> &data, uint32_t gridSize, int direction);
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+
+    void createBuffers();
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+    void dispatchParticles(const vk::raii::CommandBuffer &commandBuffer,
+                           const vk::raii::Pipeline &pipeline,
+                           const vk::raii::DescriptorSet &set,
+                           vk::DeviceAddress accelerations) const;
+    void dispatchCells(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::Pipeline &pipeline) const;
+    void pushConstants(const vk::raii::CommandBuffer &commandBuffer,
+                       vk::DeviceAddress field,
+                       uint32_t axis,
+                       int direction,
+                       vk::DeviceAddress particleAccelerations = 0) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t NumParticles;
+    const float MassScale;
+    const tParams Params;
+    const uint32_t Log2GridSize;
+    const uint32_t CellTotal;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline DepositPipeline{nullptr};
+    vk::raii::Pipeline ConvertPipeline{nullptr};
+    vk::raii::Pipeline FftPipeline{nullptr};
+    vk::raii::Pipeline PoissonPipeline{nullptr};
+    vk::raii::Pipeline GradientPipeline{nullptr};
+    vk::raii::Pipeline InterpolatePipeline{nullptr};
+
+    tStorageBuffer Density;
+    tStorageBuffer Field;
+    tStorageBuffer Acceleration;
+};
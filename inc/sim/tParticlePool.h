@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tActiveList.h"
+#include "tPrefixScan.h"
+
+class tVulkanDevice;
+
+// Live particle count, free list and indirect arguments, all kept on the GPU. Slots [0, count) may hold particles;
+// killed slots carry no mass, sit on the free list and are reused by the next emission before the count grows.
+// The host only sees the counters through a readback ring a few frames late.
+class tParticlePool
+{
+  public:
+    struct tCounters
+    {
+        uint32_t Count{0};
+        uint32_t FreeCount{0};
+
+        uint32_t getAlive() const { return Count - FreeCount; }
+    };
+
+    tParticlePool(const tVulkanDevice &device,
+                  const vk::raii::DescriptorSetLayout &descriptorLayout,
+                  uint32_t count,
+                  uint32_t capacity,
+                  uint32_t readbackSlots);
+    ~tParticlePool() { spdlog::info("tParticlePool: Destroyed"); }
+
+    // Kills particles beyond radius, then emits emitCount new ones into free or fresh slots. Works in place on the
+    // write buffer and ends with a barrier for indirect dispatches. With orderedFreeList set the free list is rebuilt
+    // in slot order after the kills instead of in atomic arrival order, so emission reuses the same slots every run.
+    void recordKillAndEmit(const vk::raii::CommandBuffer &commandBuffer,
+                           const vk::raii::DescriptorSet &set,
+                           float killRadius,
+                           uint32_t emitCount,
+                           uint32_t seed,
+                           bool orderedFreeList = false) const;
+    // Recomputes the indirect arguments from the counters, for passes that rewrite them directly.
+    void recordArgumentRefresh(const vk::raii::CommandBuffer &commandBuffer,
+                               const vk::raii::DescriptorSet &set) const;
+    void recordReadback(const vk::raii::CommandBuffer &commandBuffer, uint32_t slot) const;
+    // Copies the counters and indirect arguments into destination, so drawing does not read the counters the next
+    // step updates. Expects the readback's barrier to have made the counters visible to transfers.
+    void recordCounterSnapshot(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::Buffer &destination) const;
+    tCounters readCounters(uint32_t slot) const;
+
+    // Reallocates the free list and IDs for capacity slots. The old buffers are returned so the caller can keep
+    // them alive until the GPU is done with them; recordGrowth() copies their contents on the device.
+    std::shared_ptr<void> grow(uint32_t capacity);
+    void recordGrowth(const vk::raii::CommandBuffer &commandBuffer) const;
+
+    uint32_t getCapacity() const { return Capacity; }
+    uint32_t getReadbackSlots() const { return ReadbackSlots; }
+    // Every live slot, dispatched indirectly from the GPU count.
+    tActiveList getLiveList() const { return {0, Counters.Address, *Counters.Buffer, DispatchArgsOffset}; }
+    vk::DeviceAddress getCountAddress() const { return Counters.Address; }
+    // Stable particle ID per slot, InvalidId for free slots. IDs follow particles through reordering.
+    vk::DeviceAddress getIdsAddress() const { return Ids.Address; }
+    const vk::raii::Buffer &getIdsBuffer() const { return Ids.Buffer; }
+    const vk::raii::Buffer &getCounterBuffer() const { return Counters.Buffer; }
+
+    static constexpr uint32_t CounterWords = 12;
+    static constexpr vk::DeviceSize DispatchArgsOffset = 4 * sizeof(uint32_t);
+    static constexpr vk::DeviceSize DrawArgsOffset = 8 * sizeof(uint32_t);
+    static constexpr uint32_t TaskParticles = 4096;
+    static constexpr uint32_t InvalidId = 0xFFFFFFFFu;
+
+  private:
+    static constexpr uint32_t LocalSize = 128;
+
+    void createBuffers(uint32_t count);
+    void createPipelines(const vk::raii::DescriptorSetLayout &setLayout);
+    void bindAndPush(const vk::raii::CommandBuffer &commandBuffer,
+                     const vk::raii::DescriptorSet &set,
+                     float killRadius,
+                     uint32_t emitCount,
+                     uint32_t seed,
+                     bool orderedFreeList) const;
+    void recordFreeListRebuild(const vk::raii::CommandBuffer &commandBuffer) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t ReadbackSlots;
+    uint32_t Capacity;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline KillPipeline{nullptr};
+    vk::raii::Pipeline EmitPipeline{nullptr};
+    vk::raii::Pipeline FinalizePipeline{nullptr};
+    vk::raii::Pipeline FreeFlagsPipeline{nullptr};
+    vk::raii::Pipeline FreeCompactPipeline{nullptr};
+
+    tStorageBuffer Counters;
+    tStorageBuffer FreeList;
+    tStorageBuffer Ids;
+    tStorageBuffer FreeFlags;
+    std::unique_ptr<tPrefixScan> Scan{nullptr};
+    vk::raii::Buffer ReadbackBuffer{nullptr};
+    tAllocation ReadbackMemory{nullptr};
+    void *MappedReadback{nullptr};
+
+    // Free list and IDs being replaced, copied into the new ones by the next recordGrowth().
+    mutable vk::Buffer GrowthFreeList{nullptr};
+    mutable vk::Buffer GrowthIds{nullptr};
+    mutable vk::DeviceSize GrowthSourceSize{0};
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tParticle.h"
+#include "tPhysics.h"
+
+class tVulkanDevice;
+
+// Streams particle state to the host without stalling either side. Requests queue up on the host; the next compute
+// pass gathers each into a free slot of a ring of persistently mapped, host-cached buffers, and once the slot's
+// timeline value is reached poll() hands it to the request's callback. While every slot is in flight requests simply
+// wait in the queue. A request selects slots first, first + stride, ... below the live count of that step, at most
+// count of them; free slots in that range come back with zero mass and tParticlePool::InvalidId.
+class tParticleReadback
+{
+  public:
+    struct tRequest
+    {
+        uint32_t First{0};
+        uint32_t Stride{1};
+        uint32_t Count{std::numeric_limits<uint32_t>::max()};
+    };
+
+    // Points into the mapped slot, so only valid during the callback.
+    struct tSnapshot
+    {
+        uint64_t Step;
+        tRequest Request;
+        std::span<const tParticle> Particles;
+        std::span<const uint32_t> Ids;
+    };
+    using tCallback = std::function<void(const tSnapshot &)>;
+
+    // Keep in sync with readbackGather.comp.
+    static constexpr vk::DeviceSize HeaderSize = 16;
+
+    tParticleReadback(const tVulkanDevice &device, uint32_t slots);
+    ~tParticleReadback();
+
+    void request(const tRequest &request, tCallback callback);
+    // Requests queued, gathered or in flight.
+    bool isIdle() const;
+    // Gathers the oldest queued requests that have a free slot from buffers holding capacity slots, with the live
+    // count read from particleCount on the GPU, tagged with step. Expects the last writes to buffers to be visible to
+    // compute shaders.
+    void recordReadbacks(const vk::raii::CommandBuffer &commandBuffer,
+                         const tPhysics::tParticleBuffers &buffers,
+                         vk::DeviceAddress ids,
+                         uint32_t capacity,
+                         vk::DeviceAddress particleCount,
+                         uint64_t step);
+    // Signals the timeline for everything recordReadbacks() recorded since the last call; call right after the
+    // command buffer was submitted to the compute queue.
+    void submit();
+    // Hands every finished slot to its callback and frees it. Never waits.
+    void poll();
+    // Waits for the slots in flight and polls, for tests and shutdown.
+    void drain();
+
+  private:
+    static constexpr uint32_t LocalSize = 128;
+
+    enum class tState
+    {
+        Free,
+        Recorded,
+        InFlight
+    };
+
+    struct tSlot
+    {
+        tState State{tState::Free};
+        uint64_t Value{0};
+        uint64_t Step{0};
+        tRequest Request;
+        tCallback Callback;
+        uint32_t MaxRecords{0};
+        vk::raii::Buffer Buffer{nullptr};
+        tAllocation Memory{nullptr};
+        vk::DeviceSize Size{0};
+        vk::DeviceAddress Address{0};
+        const char *Mapped{nullptr};
+    };
+
+    struct tPending
+    {
+        tRequest Request;
+        tCallback Callback;
+    };
+
+    void createPipeline();
+    // Grows the slot's buffer to hold records particles; host-cached memory where the device has it.
+    void reserve(tSlot &slot, uint32_t records) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline GatherPipeline{nullptr};
+    vk::raii::Semaphore Timeline{nullptr};
+    uint64_t LastValue{0};
+
+    std::vector<tSlot> Slots;
+    std::deque<tPending> Pending;
+};
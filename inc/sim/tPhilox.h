@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Counter-based Philox4x32-10 generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"). Every
+// (key, counter) pair maps to four independent 32-bit words, so each particle draws from its own stream, addressed
+// by its index, and the numbers do not depend on which thread generates them or in what order. Keep in sync with
+// philox() in initialParticles.comp.
+class tPhilox
+{
+  public:
+    using tCounter = std::array<uint32_t, 4>;
+    using tKey = std::array<uint32_t, 2>;
+
+    static constexpr tCounter generate(tCounter counter, tKey key)
+    {
+        for (int round = 0; round < 10; ++round)
+        {
+            const uint64_t product0 = static_cast<uint64_t>(Multiplier0) * counter[0];
+            const uint64_t product1 = static_cast<uint64_t>(Multiplier1) * counter[2];
+            counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<uint32_t>(product1),
+                       static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<uint32_t>(product0)};
+            key[0] += Weyl0;
+            key[1] += Weyl1;
+        }
+        return counter;
+    }
+
+    // Stream stream of seed: block b is generate({b, stream, 0, 0}, seed).
+    tPhilox(const uint64_t seed, const uint32_t stream)
+        : Key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, Stream(stream)
+    {
+    }
+
+    uint32_t nextUint()
+    {
+        if (Used == Block.size())
+        {
+            Block = generate({BlockIndex++, Stream, 0u, 0u}, Key);
+            Used = 0;
+        }
+        return Block[Used++];
+    }
+    // Uniform in [0, 1), from the top 24 bits.
+    float nextFloat() { return static_cast<float>(nextUint() >> 8) * 0x1p-24f; }
+    // Uniform in (0, 1), for logarithms and inverse distributions.
+    float nextFloatOpen() { return (static_cast<float>(nextUint() >> 8) + 0.5f) * 0x1p-24f; }
+
+  private:
+    static constexpr uint32_t Multiplier0 = 0xD2511F53u;
+    static constexpr uint32_t Multiplier1 = 0xCD9E8D57u;
+    static constexpr uint32_t Weyl0 = 0x9E3779B9u;
+    static constexpr uint32_t Weyl1 = 0xBB67AE85u;
+
+    tKey Key;
+    uint32_t Stream;
+    uint32_t BlockIndex{0};
+    tCounter Block{};
+    uint32_t Used{4};
+};
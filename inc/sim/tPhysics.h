@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <memory>
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.hpp>
@@ -7,29 +11,95 @@
 // vulkan-tracy include order
 #include <tracy/TracyVulkan.hpp>
 
+#include "constants.h"
+#include "helpers/createBuffer.h"
+#include "initialParticles.h"
+#include "tActiveList.h"
+
 class tVulkanDevice;
 
 class tPhysics
 {
   public:
-    tPhysics(const tVulkanDevice &device, const vk::raii::DescriptorSetLayout &descriptorLayout);
+    // Naive streams every particle from global memory, Tiled stages positions in workgroup-shared tiles.
+    enum class tKernel
+    {
+        Naive,
+        Tiled
+    };
+
+    // Max acceleration difference between the kernels, relative to the largest acceleration in the step.
+    // Both sum in the same order, so only FMA contraction and shared-memory loads may differ.
+    static constexpr float KernelTolerance = 1e-4f;
+
+    // NUM_PARTICLES particles of initialConditions are generated on the GPU; the slots above them up to capacity
+    // start free. Throws when their particle mass exceeds MaxParticleMass.
+    tPhysics(const tVulkanDevice &device,
+             const vk::raii::DescriptorSetLayout &descriptorLayout,
+             uint32_t capacity = NUM_PARTICLES,
+             tKernel kernel = tKernel::Tiled,
+             const tInitialConditions &initialConditions = {});
     ~tPhysics() { spdlog::info("tPhysics: Destroyed"); }
 
+    // The sim params UBO. BoxSize is the side of a periodic box centred on the origin, 0 for open boundaries.
     struct tParams
     {
         float DeltaTime;
+        float BoxSize{0.f};
     };
 
-    void swapParticleBuffers();
+    // Structure-of-arrays particle state. Positions carry the mass in w, 0 for free slots. The render stream
+    // holds fp16 position and speed for the mesh shader, written by the last integrator stage of a step when
+    // enabled. DrawArgs is a copy of the pool counters taken at the end of the step that wrote this set.
+    // ClusterBounds holds one bounding sphere (xyz = center, w = radius, negative when empty) per ClusterSize slots,
+    // which the task shader culls against the camera frustum.
+    struct tParticleBuffers
+    {
+        tStorageBuffer Positions;
+        tStorageBuffer Velocities;
+        tStorageBuffer RenderStream;
+        tStorageBuffer DrawArgs;
+        tStorageBuffer ClusterBounds;
+    };
+    static constexpr vk::DeviceSize RenderStreamStride = 2 * sizeof(uint32_t);
+    // Slots per cluster; keep in sync with clusterBounds.comp, task.task and mesh.mesh.
+    static constexpr uint32_t ClusterSize = 64;
+
+    // Flips which of the two sets is read and which is written; the sets themselves stay put.
+    void swapParticleBuffers() { Parity ^= 1u; }
     void updateParams(const tParams &params);
-    void recordPhysicsPass(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set) const;
+    void setKernel(tKernel kernel) { Kernel = kernel; }
+    tKernel getKernel() const { return Kernel; }
+    // Writes one acceleration per active particle to accelerations, summing over the particleCount live slots;
+    // integration is left to tIntegrator.
+    void recordPhysicsPass(const vk::raii::CommandBuffer &commandBuffer,
+                           const vk::raii::DescriptorSet &set,
+                           vk::DeviceAddress accelerations,
+                           vk::DeviceAddress particleCount,
+                           const tActiveList &active) const;
+    // Fits the cluster bounding spheres of set B to the live particles among its particleCount slots.
+    void recordClusterBounds(const vk::raii::CommandBuffer &commandBuffer, vk::DeviceAddress particleCount) const;
+
+    // Reallocates both sets of particle buffers for capacity slots. The old buffers are returned so the caller can keep
+    // them alive until the GPU is done with them; recordGrowth() copies the particles on the device.
+    std::shared_ptr<void> grow(uint32_t capacity);
+    void recordGrowth(const vk::raii::CommandBuffer &commandBuffer) const;
 
-    const vk::raii::Buffer &getBufferA() const { return ParticleBufferA; }
-    const vk::raii::Buffer &getBufferB() const { return ParticleBufferB; }
+    const tParticleBuffers &getBuffersA() const { return Buffers[Parity]; }
+    const tParticleBuffers &getBuffersB() const { return Buffers[Parity ^ 1u]; }
+    // Set A is Buffers[parity], so descriptors and addresses can be baked once per parity.
+    uint32_t getParity() const { return Parity; }
+    const tParticleBuffers &getBufferSet(uint32_t index) const { return Buffers[index]; }
     const vk::raii::Buffer &getParamsBuffer() const { return ParamsBuffer; }
+    uint32_t getCapacity() const { return Capacity; }
+    uint32_t getClusterCount() const { return (Capacity + ClusterSize - 1) / ClusterSize; }
+    // Upper bound of the total mass any mix of live particles can reach, for fixed-point mass accumulation.
+    float getMaxTotalMass() const { return static_cast<float>(Capacity) * MaxParticleMass; }
+
+    static constexpr float MaxParticleMass = 1.f;
 
   private:
-    uint32_t LocalSize = 128;
+    uint32_t LocalSize = tActiveList::LocalSize;
 
     const tVulkanDevice &Device;
     const vk::raii::Device &LogicalDevice;
@@ -38,21 +108,42 @@ class tPhysics
     const TracyVkCtx TracyContext;
 
     void createBuffers();
+    void createParticleBuffers();
+    tParticleBuffers createParticleBufferSet() const;
+    // Fills set A with the initial particles in a compute pass; initialParticles.comp mirrors
+    // createInitialParticles(), so nothing is staged through host memory.
+    void generateInitialParticles();
     void createPhysicsPipeline(const vk::raii::DescriptorSetLayout &setLayout);
+    void createInitialPipeline();
+    void createClusterBoundsPipeline();
     void createShaderModules();
 
-    vk::raii::Pipeline PhysicsPipeline{nullptr};
+    const vk::raii::Pipeline &getActivePipeline() const;
+
+    vk::raii::Pipeline NaivePipeline{nullptr};
+    vk::raii::Pipeline TiledPipeline{nullptr};
     vk::raii::PipelineLayout PhysicsPipelineLayout{nullptr};
+    vk::raii::Pipeline InitialPipeline{nullptr};
+    vk::raii::PipelineLayout InitialPipelineLayout{nullptr};
+    vk::raii::Pipeline ClusterBoundsPipeline{nullptr};
+    vk::raii::PipelineLayout ClusterBoundsPipelineLayout{nullptr};
 
-    vk::raii::Buffer ParticleBufferA{nullptr};
-    vk::raii::DeviceMemory ParticleMemoryA{nullptr};
-    vk::raii::Buffer ParticleBufferB{nullptr};
-    vk::raii::DeviceMemory ParticleMemoryB{nullptr};
+    std::array<tParticleBuffers, 2> Buffers;
+    uint32_t Parity{0};
     vk::raii::Buffer ParamsBuffer{nullptr};
-    vk::raii::DeviceMemory ParamsMemory{nullptr};
+    tAllocation ParamsMemory{nullptr};
+
+    vk::raii::ShaderModule NaiveShader{nullptr};
+    vk::raii::ShaderModule TiledShader{nullptr};
 
-    vk::raii::ShaderModule PhysicsShader{nullptr};
+    tKernel Kernel;
+    uint32_t Capacity;
+    tInitialConditions InitialConditions;
 
+    // Streams being replaced, copied into the new set A by the next recordGrowth().
+    mutable vk::Buffer GrowthPositions{nullptr};
+    mutable vk::Buffer GrowthVelocities{nullptr};
+    mutable vk::DeviceSize GrowthSourceSize{0};
     tParams CachedParams{};
     void *MappedParamsData;
 };
\ No newline at end of file
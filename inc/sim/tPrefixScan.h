@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "helpers/createBuffer.h"
+
+class tVulkanDevice;
+
+// Exclusive prefix sum over uint buffers addressed by device address. Block sums are scanned recursively,
+// so one instance covers any count up to the maxCount it was created with.
+class tPrefixScan
+{
+  public:
+    static constexpr uint32_t BlockSize = 1024;
+
+    tPrefixScan(const tVulkanDevice &device, uint32_t maxCount);
+    ~tPrefixScan() { spdlog::info("tPrefixScan: Destroyed"); }
+
+    // Scans count values in place and ends with a compute barrier.
+    void recordScan(const vk::raii::CommandBuffer &commandBuffer, vk::DeviceAddress data, uint32_t count) const;
+
+  private:
+    void createBuffers();
+    void createPipelines();
+    void recordLevel(const vk::raii::CommandBuffer &commandBuffer,
+                     vk::DeviceAddress data,
+                     uint32_t count,
+                     size_t level) const;
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const uint32_t MaxCount;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline ScanBlocksPipeline{nullptr};
+    vk::raii::Pipeline AddBlocksPipeline{nullptr};
+
+    std::vector<tStorageBuffer> BlockSums;
+};
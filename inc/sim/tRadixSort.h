@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tPrefixScan.h"
+
+class tVulkanDevice;
+
+// Stable LSD radix sort of (uint key, uint value) pairs addressed by device address. Each pass sorts
+// RadixBits bits with a block histogram, a prefix scan of the histogram and a ranked scatter.
+class tRadixSort
+{
+  public:
+    static constexpr uint32_t BlockSize = 256;
+    static constexpr uint32_t RadixBits = 4;
+    static constexpr uint32_t RadixBins = 1u << RadixBits;
+
+    tRadixSort(const tVulkanDevice &device, uint32_t maxCount);
+    ~tRadixSort() { spdlog::info("tRadixSort: Destroyed"); }
+
+    // Sorts count pairs in place by the low keyBits of each key and ends with a compute barrier.
+    // Passes are rounded up to an even number so the result lands back in the caller's buffers.
+    void recordSort(const vk::raii::CommandBuffer &commandBuffer,
+                    vk::DeviceAddress keys,
+                    vk::DeviceAddress values,
+                    uint32_t count,
+                    uint32_t keyBits = 32) const;
+
+  private:
+    void createBuffers();
+    void createPipelines();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const uint32_t MaxCount;
+    const uint32_t MaxBlocks;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline HistogramPipeline{nullptr};
+    vk::raii::Pipeline ScatterPipeline{nullptr};
+
+    tStorageBuffer ScratchKeys;
+    tStorageBuffer ScratchValues;
+    tStorageBuffer Histogram;
+
+    std::unique_ptr<tPrefixScan> Scan{nullptr};
+};
@@ -1,40 +1,245 @@
 #pragma once
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
 #include "engine/tVulkanDevice.h"
+#include "tBarnesHut.h"
+#include "tBlockTimesteps.h"
+#include "tCellGrid.h"
+#include "tDiagnostics.h"
+#include "tEwaldTable.h"
+#include "tIntegrator.h"
+#include "tMortonReorder.h"
+#include "tParticleMesh.h"
+#include "tParticlePool.h"
+#include "tParticleReadback.h"
 #include "tPhysics.h"
+#include "tStateHash.h"
 
 class tSim
 {
   public:
-    tSim(const tVulkanDevice &device, uint32_t nrDescriptorSets);
+    enum class tSolver
+    {
+        Direct,
+        BarnesHut,
+        ParticleMesh
+    };
+
+    // Fixed-step mode: every frame records as many steps of DeltaTime as the accumulated frame time covers, up to
+    // MaxSubsteps, all in the same command buffer. Off, a frame is one step of the frame time.
+    struct tFixedTimestep
+    {
+        bool Enabled{false};
+        float DeltaTime{1e-3f};
+        uint32_t MaxSubsteps{32};
+    };
+
+    // Checksum of the particle state after a step, see tStateHash.
+    struct tStepHash
+    {
+        uint64_t Step;
+        uint64_t Hash;
+    };
+
+    tSim(const tVulkanDevice &device,
+         uint32_t framesInFlight,
+         const tCellGrid::tParams &gridParams = {},
+         const tParticleMesh::tParams &meshParams = {},
+         const tInitialConditions &initialConditions = {});
     ~tSim() { spdlog::info("tSim: Destroyed"); }
 
-    void recordComputePass(const vk::raii::CommandBuffer &commandBuffer, size_t ixImage) const;
-    void updateParams(const tPhysics::tParams &physicsParams) { Physics->updateParams(physicsParams); };
+    void recordComputePass(const vk::raii::CommandBuffer &commandBuffer, size_t ixImage);
+    // Takes the frame time; decides how many steps the next compute pass records.
+    void updateParams(const tPhysics::tParams &physicsParams);
+    void setFixedTimestep(const tFixedTimestep &params);
+    const tFixedTimestep &getFixedTimestep() const { return FixedTimestep; }
+    // Steps the next compute pass records, 0 when a fixed-step frame did not cover a whole step.
+    uint32_t getSubsteps() const { return Substeps; }
+    // Adds frameTime to accumulator and takes out the whole steps, at most MaxSubsteps; a backlog beyond that is
+    // dropped.
+    static uint32_t takeSubsteps(float &accumulator, float frameTime, const tFixedTimestep &params);
+    // Periodic box of side boxSize centred on the origin, 0 for open boundaries; applies from the next
+    // updateParams(). Positions wrap into the box and the direct solver adds the Ewald correction of all periodic
+    // images. Barnes-Hut and Particle-Mesh always run with open boundaries; the box is kept for the direct solver.
+    void setBoxSize(float boxSize);
+    float getBoxSize() const { return BoxSize; }
     void swapParticleBuffers() { Physics->swapParticleBuffers(); };
+    void setForceKernel(tPhysics::tKernel kernel) { Physics->setKernel(kernel); }
+    tPhysics::tKernel getForceKernel() const { return Physics->getKernel(); }
+    void setSolver(tSolver solver);
+    tSolver getSolver() const { return Solver; }
+    void setOpeningAngle(float theta) { BarnesHut->setOpeningAngle(theta); }
+    float getOpeningAngle() const { return BarnesHut->getOpeningAngle(); }
+    // The grid is only rebuilt while enabled, i.e. while some pass consumes it.
+    void setCellGridEnabled(bool enabled) { CellGridEnabled = enabled; }
+    bool isCellGridEnabled() const { return CellGridEnabled; }
+    const tCellGrid &getCellGrid() const { return *CellGrid; }
+    // Rebuilds the mesh buffers, so it waits for the device to go idle first.
+    void setParticleMeshGridSize(uint32_t gridSize);
+    uint32_t getParticleMeshGridSize() const { return ParticleMesh->getParams().GridSize; }
+    const tParticleMesh &getParticleMesh() const { return *ParticleMesh; }
+    void setIntegrator(tIntegrator::tScheme scheme);
+    tIntegrator::tScheme getIntegrator() const { return Integrator->getScheme(); }
+    // Replaces the integrator scheme with hierarchical KDK over power-of-two timestep levels while enabled.
+    void setBlockTimestepsEnabled(bool enabled);
+    bool isBlockTimestepsEnabled() const { return BlockTimestepsEnabled; }
+    void setBlockTimestepParams(const tBlockTimesteps::tParams &params);
+    const tBlockTimesteps &getBlockTimesteps() const { return *BlockTimesteps; }
+
+    // Sorts the particles into Morton order at the start of every interval-th frame, 0 disables it. Slots change,
+    // IDs do not.
+    void setReorderInterval(uint32_t interval) { ReorderInterval = interval; }
+    uint32_t getReorderInterval() const { return ReorderInterval; }
+    // Particles per second emitted on a shell around the origin; live particles leave beyond the kill radius,
+    // 0 keeps them all.
+    void setEmissionRate(float rate) { EmissionRate = rate; }
+    float getEmissionRate() const { return EmissionRate; }
+    void setKillRadius(float radius) { KillRadius = radius; }
+    float getKillRadius() const { return KillRadius; }
+    // Reads the particle counters a few frames late, grows the capacity ahead of emission and releases buffers
+    // retired by earlier growth; also hands finished snapshots to their callbacks. Called once per frame before
+    // recording.
+    void updatePool();
+    uint32_t getCapacity() const { return Physics->getCapacity(); }
+    // As of the last counters the host has seen, a few frames behind the GPU.
+    uint32_t getLiveParticleCount() const { return LastCounters.getAlive(); }
+    const tParticlePool &getParticlePool() const { return *Pool; }
+
+    // Bit-reproducible mode: every frame is exactly one step of the fixed timestep's DeltaTime, whatever the frame
+    // time, and killed slots rejoin the free list in slot order. Every step is hashed on the GPU; the hashes arrive
+    // with the pool counters, a few frames late. Two runs with the same settings produce the same hashes.
+    void setDeterministic(bool enabled) { Deterministic = enabled; }
+    bool isDeterministic() const { return Deterministic; }
+    // Hashes read back since the last call, oldest first; only the latest MaxStepHashes are kept in between.
+    std::vector<tStepHash> takeStepHashes();
+    std::optional<tStepHash> getLastStepHash() const { return LastStepHash; }
 
-    const vk::raii::Buffer &getParticleBuffer() const { return Physics->getBufferB(); }
-    const vk::raii::DescriptorSet &getDescriptorSet(uint32_t ix) const { return DescriptorSets[ix]; }
+    // Conserved quantities of the state at the end of every frame while enabled, see tDiagnostics. They arrive with
+    // the pool counters, a few frames late; only the latest MaxDiagnosticsHistory are kept. About potentialSamples
+    // slots estimate the potential energy, 0 skips it.
+    void setDiagnosticsEnabled(bool enabled) { DiagnosticsEnabled = enabled; }
+    bool isDiagnosticsEnabled() const { return DiagnosticsEnabled; }
+    void setPotentialSamples(uint32_t samples) { PotentialSamples = samples; }
+    uint32_t getPotentialSamples() const { return PotentialSamples; }
+    const std::deque<tDiagnostics::tSample> &getDiagnosticsHistory() const { return DiagnosticsHistory; }
+    void clearDiagnosticsHistory() { DiagnosticsHistory.clear(); }
+
+    // Copies the particle state at the end of the next compute pass with a free readback slot to the host, see
+    // tParticleReadback; the callback runs from a later updatePool() once the GPU is done, nothing waits for it.
+    void requestSnapshot(const tParticleReadback::tRequest &request, tParticleReadback::tCallback callback);
+    // Requests a snapshot every interval-th frame, 0 stops the stream.
+    void setSnapshotStream(uint32_t interval,
+                           const tParticleReadback::tRequest &request = {},
+                           tParticleReadback::tCallback callback = nullptr);
+    uint32_t getSnapshotInterval() const { return SnapshotInterval; }
+    // Marks the snapshots recorded into a compute pass as submitted; call right after submitting it.
+    void submitReadbacks() const { ParticleReadback->submit(); }
+    tParticleReadback &getParticleReadback() const { return *ParticleReadback; }
+
+    // The last pass of every step also packs positions and speeds into the fp16 render stream while enabled. With
+    // async compute it is always on: graphics then only reads the render stream and draw arguments, the buffers
+    // handed over to the graphics queue.
+    void setRenderStreamEnabled(bool enabled) { RenderStreamEnabled = enabled; }
+    bool isRenderStreamEnabled() const { return RenderStreamEnabled || Device.hasAsyncCompute(); }
+    bool hasAsyncCompute() const { return Device.hasAsyncCompute(); }
+
+    const tPhysics::tParticleBuffers &getParticleBuffers() const { return Physics->getBuffersB(); }
+    // Which of the ParitySets ping-pong arrangements is current; flips with every buffer swap.
+    uint32_t getParity() const { return Physics->getParity(); }
+    static constexpr uint32_t ParitySets = 2;
+    // Binds the write set of the current parity; baked once per parity, so recording writes no descriptors.
+    const vk::raii::DescriptorSet &getDescriptorSet() const { return DescriptorSets[Physics->getParity()]; }
     const vk::raii::DescriptorSetLayout &getDescriptorSetLayout() const { return DescriptorLayout; }
 
   private:
-    const uint32_t NrDescriptorSets;
+    // Frames whose readbacks can be pending at once; the pool keeps one readback slot more.
+    const uint32_t FramesInFlight;
 
     void createDescriptorSets();
     void createDescriptorSetLayout();
-    void updateDescriptorSetForFrame(const vk::raii::DescriptorSet &set) const;
+    void writeDescriptorSets() const;
+    void recordBeginStep(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set);
+    // Where the last pass of a step packs the render data, 0 while the render stream is disabled.
+    vk::DeviceAddress getRenderStreamAddress() const;
+    void recordStep(const vk::raii::CommandBuffer &commandBuffer,
+                    const vk::raii::DescriptorSet &set,
+                    vk::DeviceAddress renderStream);
+    void recordForcePass(const vk::raii::CommandBuffer &commandBuffer,
+                         const vk::raii::DescriptorSet &set,
+                         const tActiveList &active) const;
+    void grow(uint32_t capacity);
+    void recordBlockStep(const vk::raii::CommandBuffer &commandBuffer,
+                         const vk::raii::DescriptorSet &set,
+                         vk::DeviceAddress renderStream);
 
     const tVulkanDevice &Device;
     const vk::raii::Device &LogicalDevice;
     const vk::raii::PhysicalDevice &PhysicalDevice;
 
-    // std::unique_ptr<tCellGrid> CellGrid{nullptr};
+    std::unique_ptr<tCellGrid> CellGrid{nullptr};
     std::unique_ptr<tPhysics> Physics{nullptr};
+    std::unique_ptr<tBarnesHut> BarnesHut{nullptr};
+    std::unique_ptr<tParticleMesh> ParticleMesh{nullptr};
+    std::unique_ptr<tIntegrator> Integrator{nullptr};
+    std::unique_ptr<tBlockTimesteps> BlockTimesteps{nullptr};
+    std::unique_ptr<tParticlePool> Pool{nullptr};
+    std::unique_ptr<tMortonReorder> Reorder{nullptr};
+    std::unique_ptr<tStateHash> StateHash{nullptr};
+    std::unique_ptr<tDiagnostics> Diagnostics{nullptr};
+    std::unique_ptr<tParticleReadback> ParticleReadback{nullptr};
+    std::unique_ptr<tEwaldTable> EwaldTable{nullptr};
+    tSolver Solver{tSolver::Direct};
+    bool CellGridEnabled{false};
+    bool BlockTimestepsEnabled{false};
+    uint32_t ReorderInterval{0};
+    bool RenderStreamEnabled{false};
+    // Set once the acceleration buffer holds the forces of the current particle state.
+    bool ForcesCurrent{false};
+
+    float BoxSize{0.f};
+    tFixedTimestep FixedTimestep{};
+    float Accumulator{0.f};
+    uint32_t Substeps{1};
+
+    static constexpr uint32_t MaxCapacity = 1u << 22;
+    float EmissionRate{0.f};
+    float KillRadius{0.f};
+    float PendingEmission{0.f};
+    uint32_t EmitCount{0};
+    uint64_t FrameIndex{0};
+    uint64_t StepCount{0};
+    bool Deterministic{false};
+    // What each readback slot holds besides the counters, and after which step.
+    struct tReadback
+    {
+        uint64_t Step{0};
+        bool Hash{false};
+        bool Diagnostics{false};
+    };
+    std::vector<tReadback> Readbacks;
+    static constexpr size_t MaxStepHashes = 4096;
+    std::deque<tStepHash> StepHashes;
+    std::optional<tStepHash> LastStepHash;
+    bool DiagnosticsEnabled{false};
+    uint32_t PotentialSamples{256};
+    static constexpr size_t MaxDiagnosticsHistory = 1024;
+    std::deque<tDiagnostics::tSample> DiagnosticsHistory;
+    uint32_t SnapshotInterval{0};
+    tParticleReadback::tRequest SnapshotRequest{};
+    tParticleReadback::tCallback SnapshotCallback{nullptr};
+    tParticlePool::tCounters LastCounters{NUM_PARTICLES, 0u};
+    // Buffers and passes replaced by growth, released once no frame in flight can still use them.
+    std::deque<std::pair<uint64_t, std::shared_ptr<void>>> Retired;
 
     vk::raii::DescriptorSetLayout DescriptorLayout{nullptr};
     vk::raii::DescriptorPool DescriptorPool{nullptr};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+// vulkan-tracy include order
+#include <tracy/TracyVulkan.hpp>
+
+#include "helpers/createBuffer.h"
+#include "tParticle.h"
+#include "tPhysics.h"
+
+class tVulkanDevice;
+
+// 64-bit checksum of the particle state, computed on the GPU and read back through a ring of host-visible slots a
+// few frames late, like the pool counters. Every live slot hashes its index with the bits of its position and
+// velocity; the slot hashes are summed per lane with integer wrap-around in a fixed two-pass reduction, so the
+// checksum is exact and any changed bit in any slot changes it.
+class tStateHash
+{
+  public:
+    // Covers buffers of up to maxCapacity slots, so it outlives pool growth along with its readback ring.
+    tStateHash(const tVulkanDevice &device, uint32_t maxCapacity, uint32_t readbackSlots);
+    ~tStateHash() { spdlog::info("tStateHash: Destroyed"); }
+
+    // Hashes slots [0, count) of buffers holding capacity slots, with count read from particleCount on the GPU, and
+    // copies the checksum into readback slot. Expects the last writes to buffers to be visible to compute shaders.
+    void recordHash(const vk::raii::CommandBuffer &commandBuffer,
+                    const tPhysics::tParticleBuffers &buffers,
+                    uint32_t capacity,
+                    vk::DeviceAddress particleCount,
+                    uint32_t slot) const;
+    uint64_t readHash(uint32_t slot) const;
+
+    // The same checksum on the host, for tests and for comparing against saved states.
+    static uint64_t hashParticles(const std::vector<tParticle> &particles);
+
+  private:
+    static constexpr uint32_t LocalSize = 256;
+
+    void createBuffers();
+    void createPipelines();
+
+    const tVulkanDevice &Device;
+    const vk::raii::Device &LogicalDevice;
+    const TracyVkCtx TracyContext;
+    const uint32_t MaxCapacity;
+    const uint32_t ReadbackSlots;
+
+    vk::raii::PipelineLayout PipelineLayout{nullptr};
+    vk::raii::Pipeline BlocksPipeline{nullptr};
+    vk::raii::Pipeline CombinePipeline{nullptr};
+
+    tStorageBuffer BlockHashes;
+    tStorageBuffer Result;
+    vk::raii::Buffer ReadbackBuffer{nullptr};
+    tAllocation ReadbackMemory{nullptr};
+    void *MappedReadback{nullptr};
+};
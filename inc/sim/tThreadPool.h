@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+// Fork-join pool for the CPU backends. parallelFor() deals every thread a contiguous share of the chunks in its own
+// deque; a thread works its share from the back and, once it runs dry, steals from the front of the others, so
+// uneven chunks still keep every core busy.
+class tThreadPool
+{
+  public:
+    using tRangeFn = std::function<void(size_t begin, size_t end)>;
+
+    // threadCount 0 uses every hardware thread. The calling thread counts as one of them.
+    explicit tThreadPool(uint32_t threadCount = 0);
+    ~tThreadPool();
+
+    tThreadPool(const tThreadPool &) = delete;
+    tThreadPool &operator=(const tThreadPool &) = delete;
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(Queues.size()); }
+
+    // Runs body over [begin, end) in chunks of at most grain elements and returns once every chunk ran. The first
+    // exception thrown by body is rethrown here after the remaining chunks are drained. Not reentrant.
+    void parallelFor(size_t begin, size_t end, size_t grain, const tRangeFn &body);
+
+  private:
+    struct tChunk
+    {
+        size_t Begin;
+        size_t End;
+    };
+
+    struct tQueue
+    {
+        std::mutex Mutex;
+        std::deque<tChunk> Chunks;
+    };
+
+    void workerLoop(uint32_t index);
+    void runChunks(uint32_t index);
+    bool popOwn(uint32_t index, tChunk &chunk);
+    bool steal(uint32_t thief, tChunk &chunk);
+
+    std::vector<std::unique_ptr<tQueue>> Queues;
+    std::vector<std::thread> Workers;
+
+    std::mutex JobMutex;
+    std::condition_variable JobReady;
+    std::condition_variable JobDone;
+    const tRangeFn *Body{nullptr};
+    uint64_t Generation{0};
+    uint32_t Busy{0};
+    bool Stopping{false};
+    std::exception_ptr Error;
+};
@@ -0,0 +1,31 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+layout(buffer_reference, std430) readonly buffer TargetBuffer
+{
+    uint values[]; // written by pointSplat.comp
+};
+
+layout(push_constant) uniform PushConstants
+{
+    TargetBuffer target;
+    uint width;
+    uint _pad0;
+}
+pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    uint splat = pc.target.values[pixel.y * pc.width + pixel.x];
+    if (splat == 0xFFFFFFFFu)
+        discard;
+
+    // Same gradient as fragment.frag.
+    float t = float(splat & 0xFFu) / 255.0;
+    vec3 slowColor = vec3(0.0, 0.4, 0.3);
+    vec3 fastColor = vec3(0.9, 0.8, 0.15);
+    outColor = vec4(mix(slowColor, fastColor, t), 1.0);
+}
@@ -65,7 +65,8 @@ void tCamera::createCameraBuffer()
                      vk::BufferUsageFlagBits::eUniformBuffer,
                      vk::SharingMode::eExclusive,
                      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                     nullptr);
+                     nullptr,
+                     "tCamera");
 
     spdlog::info("tCamera: Buffer created");
 }
@@ -88,8 +89,10 @@ void tCamera::createDescriptorSet()
 void tCamera::createDescriptorLayout()
 {
     spdlog::info("tCamera: Creating descriptor set layout...");
-    vk::DescriptorSetLayoutBinding cameraBinding{
-        0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eMeshEXT};
+    // The task shader culls against the same matrices the mesh shader and the compute rasterizer project with.
+    const auto stages = vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT |
+                        vk::ShaderStageFlagBits::eCompute;
+    vk::DescriptorSetLayoutBinding cameraBinding{0, vk::DescriptorType::eUniformBuffer, 1, stages};
 
     vk::DescriptorSetLayoutCreateInfo layoutInfo({}, cameraBinding);
     DescriptorLayout = LogicalDevice.createDescriptorSetLayout(layoutInfo);
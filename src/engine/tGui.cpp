@@ -1,6 +1,10 @@
 #include "engine/tGui.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <cstdio>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
@@ -9,13 +13,15 @@
 #include "engine/tCamera.h"
 #include "engine/tSwapchain.h"
 #include "engine/tVulkanDevice.h"
+#include "sim/tSim.h"
 
 tGui::tGui(tCamera &camera,
+           tSim &sim,
            const tVulkanDevice &device,
            const tSwapchain &swapchain,
            const vk::raii::Instance &instance,
            GLFWwindow &window)
-    : Camera(camera), Window(window)
+    : Camera(camera), Sim(sim), Device(device), Window(window)
 {
     spdlog::info("tGui: Initializing...");
     initImGui(device, instance, swapchain);
@@ -36,6 +42,26 @@ void tGui::update()
             updateFPSCounter();
             ImGui::EndTabItem();
         }
+        if (ImGui::BeginTabItem("Sim"))
+        {
+            updateSimControls();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Diagnostics"))
+        {
+            updateDiagnostics();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Memory"))
+        {
+            updateMemory();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Rendering"))
+        {
+            updateRendering();
+            ImGui::EndTabItem();
+        }
         ImGui::EndTabBar();
     }
     ImGui::End();
@@ -43,9 +69,290 @@ void tGui::update()
     spdlog::trace("tGui: Updated");
 }
 
+void tGui::setFrameStats(const tRenderer::tFrameStats &stats)
+{
+    FrameStats = stats;
+    if (stats.ParticlePassMs <= 0.f)
+        return;
+    auto &average = ParticlePassMs[static_cast<size_t>(stats.Rasterizer)];
+    average = average > 0.f ? 0.95f * average + 0.05f * stats.ParticlePassMs : stats.ParticlePassMs;
+}
+
 void tGui::updateFPSCounter()
 {
     ImGui::Text("FPS: %.1f", Io->Framerate);
+    // Both stay on screen, so switching rasterizers in the Rendering tab compares them on the same scene.
+    const char *names[] = {"Mesh shader", "Compute"};
+    for (size_t i = 0; i < ParticlePassMs.size(); ++i)
+    {
+        if (ParticlePassMs[i] > 0.f)
+            ImGui::Text("%s particle pass: %.3f ms GPU", names[i], ParticlePassMs[i]);
+        else
+            ImGui::Text("%s particle pass: not measured", names[i]);
+    }
+}
+
+void tGui::updateSimControls()
+{
+    ImGui::Text("Particles: %u / %u", Sim.getLiveParticleCount(), Sim.getCapacity());
+    float emissionRate = Sim.getEmissionRate();
+    if (ImGui::SliderFloat("Emission rate", &emissionRate, 0.f, 100000.f, "%.0f/s", ImGuiSliderFlags_Logarithmic))
+    {
+        Sim.setEmissionRate(emissionRate);
+    }
+    int reorderInterval = static_cast<int>(Sim.getReorderInterval());
+    if (ImGui::SliderInt("Morton reorder", &reorderInterval, 0, 64, reorderInterval > 0 ? "every %d steps" : "off"))
+    {
+        Sim.setReorderInterval(static_cast<uint32_t>(reorderInterval));
+    }
+    float killRadius = Sim.getKillRadius();
+    if (ImGui::SliderFloat("Kill radius", &killRadius, 0.f, 20.f, killRadius > 0.f ? "%.1f" : "off"))
+    {
+        Sim.setKillRadius(killRadius);
+    }
+    // Async compute hands only the render stream to the graphics queue, so it cannot be turned off there.
+    bool renderStream = Sim.isRenderStreamEnabled();
+    ImGui::BeginDisabled(Sim.hasAsyncCompute());
+    if (ImGui::Checkbox("Render stream (fp16)", &renderStream))
+    {
+        Sim.setRenderStreamEnabled(renderStream);
+    }
+    ImGui::EndDisabled();
+    ImGui::Text("Async compute: %s", Sim.hasAsyncCompute() ? "on" : "off");
+
+    bool deterministic = Sim.isDeterministic();
+    if (ImGui::Checkbox("Deterministic", &deterministic))
+    {
+        Sim.setDeterministic(deterministic);
+    }
+    if (const auto hash = Sim.getLastStepHash(); deterministic && hash)
+    {
+        ImGui::Text("Step %llu hash: %016llx",
+                    static_cast<unsigned long long>(hash->Step),
+                    static_cast<unsigned long long>(hash->Hash));
+    }
+
+    // Deterministic mode always takes one step of the fixed DeltaTime per frame.
+    auto fixedTimestep = Sim.getFixedTimestep();
+    ImGui::BeginDisabled(deterministic);
+    bool fixedChanged = ImGui::Checkbox("Fixed timestep", &fixedTimestep.Enabled);
+    ImGui::EndDisabled();
+    if (fixedTimestep.Enabled || deterministic)
+    {
+        float rate = 1.f / fixedTimestep.DeltaTime;
+        fixedChanged |= ImGui::SliderFloat("Step rate", &rate, 30.f, 4000.f, "%.0f Hz", ImGuiSliderFlags_Logarithmic);
+        fixedTimestep.DeltaTime = 1.f / rate;
+    }
+    if (fixedTimestep.Enabled && !deterministic)
+    {
+        int maxSubsteps = static_cast<int>(fixedTimestep.MaxSubsteps);
+        fixedChanged |= ImGui::SliderInt("Max substeps", &maxSubsteps, 1, 128);
+        ImGui::Text("Substeps this frame: %u", Sim.getSubsteps());
+        fixedTimestep.MaxSubsteps = static_cast<uint32_t>(maxSubsteps);
+    }
+    if (fixedChanged)
+    {
+        Sim.setFixedTimestep(fixedTimestep);
+    }
+
+    int solver = static_cast<int>(Sim.getSolver());
+    const char *solvers[] = {"Direct", "Barnes-Hut", "Particle-Mesh"};
+    if (ImGui::Combo("Solver", &solver, solvers, IM_ARRAYSIZE(solvers)))
+    {
+        Sim.setSolver(static_cast<tSim::tSolver>(solver));
+    }
+
+    bool blockTimesteps = Sim.isBlockTimestepsEnabled();
+    if (ImGui::Checkbox("Block timesteps", &blockTimesteps))
+    {
+        Sim.setBlockTimestepsEnabled(blockTimesteps);
+    }
+
+    if (blockTimesteps)
+    {
+        auto params = Sim.getBlockTimesteps().getParams();
+        int levels = static_cast<int>(params.Levels);
+        bool changed = ImGui::SliderInt("Levels", &levels, 1, tBlockTimesteps::MaxLevels);
+        changed |= ImGui::SliderFloat("Accuracy", &params.Accuracy, 0.005f, 0.5f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        if (changed)
+        {
+            params.Levels = static_cast<uint32_t>(levels);
+            Sim.setBlockTimestepParams(params);
+        }
+    }
+    else
+    {
+        int scheme = static_cast<int>(Sim.getIntegrator());
+        const char *schemes[] = {"Semi-implicit Euler", "Leapfrog KDK", "Velocity Verlet", "Yoshida 4"};
+        if (ImGui::Combo("Integrator", &scheme, schemes, IM_ARRAYSIZE(schemes)))
+        {
+            Sim.setIntegrator(static_cast<tIntegrator::tScheme>(scheme));
+        }
+    }
+
+    if (Sim.getSolver() == tSim::tSolver::Direct)
+    {
+        int kernel = static_cast<int>(Sim.getForceKernel());
+        const char *kernels[] = {"Naive", "Tiled"};
+        if (ImGui::Combo("Kernel", &kernel, kernels, IM_ARRAYSIZE(kernels)))
+        {
+            Sim.setForceKernel(static_cast<tPhysics::tKernel>(kernel));
+        }
+
+        float boxSize = Sim.getBoxSize();
+        if (ImGui::SliderFloat("Periodic box", &boxSize, 0.f, 100.f, boxSize > 0.f ? "%.1f" : "off"))
+        {
+            Sim.setBoxSize(boxSize);
+        }
+    }
+    else if (Sim.getSolver() == tSim::tSolver::BarnesHut)
+    {
+        float theta = Sim.getOpeningAngle();
+        if (ImGui::SliderFloat("Opening angle", &theta, 0.1f, 1.5f, "%.2f"))
+        {
+            Sim.setOpeningAngle(theta);
+        }
+    }
+    else
+    {
+        const uint32_t gridSizes[] = {32, 64, 128, 256};
+        const char *gridLabels[] = {"32^3", "64^3", "128^3", "256^3"};
+        const auto current = std::ranges::find(gridSizes, Sim.getParticleMeshGridSize());
+        int gridIx = current == std::end(gridSizes) ? 0 : static_cast<int>(current - std::begin(gridSizes));
+        if (ImGui::Combo("Mesh", &gridIx, gridLabels, IM_ARRAYSIZE(gridLabels)))
+        {
+            Sim.setParticleMeshGridSize(gridSizes[gridIx]);
+        }
+    }
+}
+
+void tGui::updateDiagnostics()
+{
+    bool enabled = Sim.isDiagnosticsEnabled();
+    if (ImGui::Checkbox("Conserved quantities", &enabled))
+    {
+        Sim.setDiagnosticsEnabled(enabled);
+    }
+    int samples = static_cast<int>(Sim.getPotentialSamples());
+    const char *samplesFormat = samples > 0 ? "%d" : "off";
+    if (ImGui::SliderInt("Potential samples", &samples, 0, 4096, samplesFormat, ImGuiSliderFlags_Logarithmic))
+    {
+        Sim.setPotentialSamples(static_cast<uint32_t>(samples));
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+    {
+        Sim.clearDiagnosticsHistory();
+    }
+
+    const auto &history = Sim.getDiagnosticsHistory();
+    if (history.empty())
+        return;
+
+    // Drifts are relative to the oldest sample kept.
+    const auto &first = history.front();
+    const auto &last = history.back();
+    const float energyScale = std::max(std::abs(first.getTotalEnergy()), 1e-30f);
+    ImGui::Text("Step %llu, %u live particles", static_cast<unsigned long long>(last.Step), last.Count);
+    ImGui::Text("Energy: %.4e (kinetic %.4e, potential %.4e)", last.getTotalEnergy(), last.Kinetic, last.Potential);
+    ImGui::Text("Energy drift: %+.3e", (last.getTotalEnergy() - first.getTotalEnergy()) / energyScale);
+    ImGui::Text("Momentum: (%.3e, %.3e, %.3e)", last.Momentum.x, last.Momentum.y, last.Momentum.z);
+    ImGui::Text("Angular momentum: (%.3e, %.3e, %.3e)",
+                last.AngularMomentum.x,
+                last.AngularMomentum.y,
+                last.AngularMomentum.z);
+    ImGui::Text("Center of mass: (%.3f, %.3f, %.3f)", last.CenterOfMass.x, last.CenterOfMass.y, last.CenterOfMass.z);
+
+    std::vector<float> values(history.size());
+    const auto plot = [&](const char *label, auto &&value) {
+        std::ranges::transform(history, values.begin(), value);
+        ImGui::PlotLines(label, values.data(), static_cast<int>(values.size()), 0, nullptr, FLT_MAX, FLT_MAX, {0, 60});
+    };
+    plot("Total energy", [](const auto &sample) { return sample.getTotalEnergy(); });
+    plot("Kinetic", [](const auto &sample) { return sample.Kinetic; });
+    plot("Potential", [](const auto &sample) { return sample.Potential; });
+    plot("Energy drift", [&](const auto &sample) {
+        return (sample.getTotalEnergy() - first.getTotalEnergy()) / energyScale;
+    });
+    plot("|Momentum|", [](const auto &sample) { return glm::length(sample.Momentum); });
+    plot("|Angular momentum|", [](const auto &sample) { return glm::length(sample.AngularMomentum); });
+    plot("Center of mass drift", [&](const auto &sample) {
+        return glm::length(sample.CenterOfMass - first.CenterOfMass);
+    });
+}
+
+void tGui::updateMemory()
+{
+    constexpr float MiB = 1024.f * 1024.f;
+    const auto &allocator = Device.getAllocator();
+    ImGui::Text("%u allocations in %u blocks", allocator.getAllocationCount(), allocator.getBlockCount());
+    ImGui::Text("Budget: %s", allocator.hasMemoryBudget() ? "VK_EXT_memory_budget" : "estimated");
+
+    const auto heaps = allocator.getHeapBudgets();
+    for (size_t i = 0; i < heaps.size(); ++i)
+    {
+        const auto &heap = heaps[i];
+        char overlay[96];
+        std::snprintf(overlay,
+                      sizeof(overlay),
+                      "%.0f / %.0f MiB (ours %.0f, %.0f used)",
+                      heap.Usage / MiB,
+                      heap.Budget / MiB,
+                      heap.BlockBytes / MiB,
+                      heap.AllocatedBytes / MiB);
+        ImGui::Text("Heap %zu (%s, %.0f MiB)", i, heap.DeviceLocal ? "device" : "host", heap.Size / MiB);
+        const float fraction = heap.Budget > 0 ? static_cast<float>(heap.Usage) / heap.Budget : 0.f;
+        ImGui::ProgressBar(std::min(fraction, 1.f), {-FLT_MIN, 0}, overlay);
+    }
+
+    if (ImGui::BeginTable("MemoryTags", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+    {
+        ImGui::TableSetupColumn("Tag");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableHeadersRow();
+        for (const auto &usage : allocator.getTagUsage())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(usage.Tag.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", usage.Allocations);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", usage.Bytes / MiB);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void tGui::updateRendering()
+{
+    int rasterizer = static_cast<int>(Rasterizer);
+    const char *rasterizers[] = {"Mesh shader", "Compute"};
+    if (ImGui::Combo("Rasterizer", &rasterizer, rasterizers, IM_ARRAYSIZE(rasterizers)))
+    {
+        Rasterizer = static_cast<tRenderer::tRasterizer>(rasterizer);
+    }
+
+    // The compute rasterizer draws every live particle.
+    ImGui::BeginDisabled(Rasterizer == tRenderer::tRasterizer::Compute);
+    auto culling = Camera.getCulling();
+    bool changed = ImGui::Checkbox("Frustum culling", &culling.Enabled);
+    ImGui::BeginDisabled(!culling.Enabled);
+    const char *lodFormat = culling.LodDistance > 0.f ? "%.0f" : "off";
+    changed |= ImGui::SliderFloat("LOD distance", &culling.LodDistance, 0.f, 500.f, lodFormat);
+    ImGui::EndDisabled();
+    if (changed)
+    {
+        Camera.setCulling(culling);
+    }
+
+    const auto &stats = FrameStats.Cull;
+    const float culledFraction = stats.Clusters > 0 ? static_cast<float>(stats.Culled) / stats.Clusters : 0.f;
+    ImGui::Text("Clusters: %u, culled %u (%.1f%%)", stats.Clusters, stats.Culled, 100.f * culledFraction);
+    ImGui::Text("Mesh groups emitted: %u", stats.MeshGroups);
+    ImGui::Text("Points emitted: %u", stats.Points);
+    ImGui::EndDisabled();
 }
 
 void tGui::recordGuiPass(const vk::raii::CommandBuffer &commandBuffer,
@@ -191,7 +498,7 @@ void tGui::initImGui(const tVulkanDevice &device, const vk::raii::Instance &inst
     initInfo.Device = *device.getLogicalDevice();
     initInfo.QueueFamily = device.getQueueFamily();
     initInfo.Queue = *device.getQueue();
-    initInfo.PipelineCache = VK_NULL_HANDLE;
+    initInfo.PipelineCache = *device.getPipelineCache();
     initInfo.DescriptorPool = *ImGuiPool;
     initInfo.MinImageCount = swapchain.getMinImageCount();
     initInfo.ImageCount = swapchain.getImageCount();
@@ -0,0 +1,392 @@
+#include "engine/tMemoryAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "helpers/memoryAllocation.h"
+
+struct tAllocation::tBlock
+{
+    vk::raii::DeviceMemory Memory{nullptr};
+    uint32_t MemoryType;
+    uint32_t Heap;
+    tMemoryAllocator::tResource Resource;
+    vk::DeviceSize Size;
+    bool Dedicated;
+    void *Mapped{nullptr};
+    // Free ranges, offset to size; neighbours are merged on free.
+    std::map<vk::DeviceSize, vk::DeviceSize> Free;
+    vk::DeviceSize AllocatedBytes{0};
+    uint32_t Allocations{0};
+};
+
+namespace
+{
+vk::DeviceSize alignUp(const vk::DeviceSize value, const vk::DeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+tAllocation::tAllocation(tAllocation &&other) noexcept
+    : Allocator(other.Allocator), Block(other.Block), Offset(other.Offset), Size(other.Size),
+      RangeOffset(other.RangeOffset), Tag(other.Tag)
+{
+    other.Allocator = nullptr;
+    other.Block = nullptr;
+}
+
+tAllocation &tAllocation::operator=(tAllocation &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        Allocator = other.Allocator;
+        Block = other.Block;
+        Offset = other.Offset;
+        Size = other.Size;
+        RangeOffset = other.RangeOffset;
+        Tag = other.Tag;
+        other.Allocator = nullptr;
+        other.Block = nullptr;
+    }
+    return *this;
+}
+
+vk::DeviceMemory tAllocation::getMemory() const
+{
+    return Block != nullptr ? *Block->Memory : vk::DeviceMemory{};
+}
+
+void *tAllocation::getMappedData() const
+{
+    return Block != nullptr && Block->Mapped != nullptr ? static_cast<char *>(Block->Mapped) + Offset : nullptr;
+}
+
+void tAllocation::release()
+{
+    if (Allocator != nullptr)
+    {
+        Allocator->free(*this);
+        Allocator = nullptr;
+        Block = nullptr;
+    }
+}
+
+tMemoryAllocator::tMemoryAllocator(const vk::raii::PhysicalDevice &physicalDevice,
+                                   const vk::raii::Device &device,
+                                   const bool memoryBudgetEnabled)
+    : PhysicalDevice(physicalDevice), Device(device), MemoryBudgetEnabled(memoryBudgetEnabled),
+      MemoryProperties(physicalDevice.getMemoryProperties()),
+      MaxAllocationCount(physicalDevice.getProperties().limits.maxMemoryAllocationCount)
+{
+    spdlog::info("tMemoryAllocator: {} memory types in {} heaps, budget {}",
+                 MemoryProperties.memoryTypeCount,
+                 MemoryProperties.memoryHeapCount,
+                 MemoryBudgetEnabled ? "from VK_EXT_memory_budget" : "estimated");
+}
+
+tMemoryAllocator::~tMemoryAllocator()
+{
+    if (AllocationCount > 0)
+    {
+        spdlog::warn("tMemoryAllocator: {} allocations outlive the allocator", AllocationCount);
+    }
+    spdlog::info("tMemoryAllocator: Destroyed");
+}
+
+tAllocation tMemoryAllocator::allocate(const vk::MemoryRequirements &requirements,
+                                       const vk::MemoryPropertyFlags flags,
+                                       const tResource resource,
+                                       const std::string_view tag)
+{
+    ZoneScopedN("tMemoryAllocator::allocate()");
+    const bool deviceLocalOnly = flags == vk::MemoryPropertyFlagBits::eDeviceLocal;
+    const auto types = rankMemoryTypes(MemoryProperties,
+                                       requirements.memoryTypeBits,
+                                       deviceLocalOnly ? vk::MemoryPropertyFlags{} : flags,
+                                       deviceLocalOnly ? flags : vk::MemoryPropertyFlags{});
+    if (types.empty())
+    {
+        throw std::runtime_error("tMemoryAllocator: No memory type with flags " + vk::to_string(flags) + " for " +
+                                 std::string(tag));
+    }
+
+    std::lock_guard lock{Mutex};
+    tAllocation allocation;
+    auto finish = [&](tBlock *block) {
+        auto tagIt = Tags.find(tag);
+        if (tagIt == Tags.end())
+        {
+            tagIt = Tags.emplace(std::string(tag), tTagTotals{}).first;
+        }
+        tagIt->second.Bytes += requirements.size;
+        ++tagIt->second.Allocations;
+        ++AllocationCount;
+
+        allocation.Allocator = this;
+        allocation.Block = block;
+        allocation.Size = requirements.size;
+        allocation.Tag = &tagIt->first;
+        return std::move(allocation);
+    };
+
+    for (const uint32_t type : types)
+    {
+        for (const auto &block : Blocks)
+        {
+            if (block->MemoryType == type && block->Resource == resource && !block->Dedicated &&
+                subAllocate(*block, requirements, allocation))
+            {
+                return finish(block.get());
+            }
+        }
+    }
+
+    // No room in any block: a new one in the best type that has room in its heap's budget, then in the best type
+    // the driver still hands memory out from.
+    for (const bool withinBudget : {true, false})
+    {
+        for (const uint32_t type : types)
+        {
+            const uint32_t heap = MemoryProperties.memoryTypes[type].heapIndex;
+            const vk::DeviceSize blockSize =
+                std::min(DefaultBlockSize, MemoryProperties.memoryHeaps[heap].size / 8);
+            const bool dedicated = requirements.size > blockSize / 2;
+            const vk::DeviceSize size = dedicated ? requirements.size : blockSize;
+            if (withinBudget && !fitsBudget(heap, size))
+                continue;
+
+            tBlock *block = nullptr;
+            try
+            {
+                block = createBlock(type, resource, size, dedicated);
+            }
+            catch (const vk::OutOfDeviceMemoryError &)
+            {
+                spdlog::warn("tMemoryAllocator: Memory type {} out of device memory", type);
+                continue;
+            }
+            catch (const vk::OutOfHostMemoryError &)
+            {
+                spdlog::warn("tMemoryAllocator: Memory type {} out of host memory", type);
+                continue;
+            }
+
+            if (type != types.front())
+            {
+                spdlog::warn("tMemoryAllocator: {} falls back to memory type {}", tag, type);
+            }
+            subAllocate(*block, requirements, allocation);
+            return finish(block);
+        }
+    }
+    throw std::runtime_error("tMemoryAllocator: Out of memory for " + std::to_string(requirements.size) +
+                             " bytes of " + std::string(tag));
+}
+
+tAllocation tMemoryAllocator::allocate(const vk::raii::Buffer &buffer,
+                                       const vk::MemoryPropertyFlags flags,
+                                       const std::string_view tag)
+{
+    auto allocation = allocate(buffer.getMemoryRequirements(), flags, tResource::Buffer, tag);
+    buffer.bindMemory(allocation.getMemory(), allocation.getOffset());
+    return allocation;
+}
+
+tAllocation tMemoryAllocator::allocate(const vk::raii::Image &image,
+                                       const vk::MemoryPropertyFlags flags,
+                                       const std::string_view tag)
+{
+    auto allocation = allocate(image.getMemoryRequirements(), flags, tResource::Image, tag);
+    image.bindMemory(allocation.getMemory(), allocation.getOffset());
+    return allocation;
+}
+
+std::vector<tMemoryAllocator::tHeapBudget> tMemoryAllocator::getHeapBudgets() const
+{
+    std::lock_guard lock{Mutex};
+    return computeHeapBudgets();
+}
+
+std::vector<tMemoryAllocator::tTagUsage> tMemoryAllocator::getTagUsage() const
+{
+    std::lock_guard lock{Mutex};
+    std::vector<tTagUsage> usage;
+    for (const auto &[tag, totals] : Tags)
+    {
+        if (totals.Allocations > 0)
+        {
+            usage.push_back({tag, totals.Bytes, totals.Allocations});
+        }
+    }
+    std::ranges::stable_sort(usage, std::greater{}, &tTagUsage::Bytes);
+    return usage;
+}
+
+uint32_t tMemoryAllocator::getBlockCount() const
+{
+    std::lock_guard lock{Mutex};
+    return static_cast<uint32_t>(Blocks.size());
+}
+
+uint32_t tMemoryAllocator::getAllocationCount() const
+{
+    std::lock_guard lock{Mutex};
+    return AllocationCount;
+}
+
+std::vector<tMemoryAllocator::tHeapBudget> tMemoryAllocator::computeHeapBudgets() const
+{
+    std::vector<tHeapBudget> budgets(MemoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; ++i)
+    {
+        budgets[i].Size = MemoryProperties.memoryHeaps[i].size;
+        budgets[i].DeviceLocal =
+            static_cast<bool>(MemoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+    }
+    for (const auto &block : Blocks)
+    {
+        budgets[block->Heap].BlockBytes += block->Size;
+        budgets[block->Heap].AllocatedBytes += block->AllocatedBytes;
+    }
+
+    if (MemoryBudgetEnabled)
+    {
+        const auto chain = PhysicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                                                               vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const auto &budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; ++i)
+        {
+            budgets[i].Usage = budget.heapUsage[i];
+            budgets[i].Budget = budget.heapBudget[i];
+        }
+    }
+    else
+    {
+        for (auto &budget : budgets)
+        {
+            budget.Usage = budget.BlockBytes;
+            budget.Budget = budget.Size / 10 * 8;
+        }
+    }
+    return budgets;
+}
+
+bool tMemoryAllocator::subAllocate(tBlock &block,
+                                   const vk::MemoryRequirements &requirements,
+                                   tAllocation &allocation)
+{
+    const vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+    for (auto it = block.Free.begin(); it != block.Free.end(); ++it)
+    {
+        const auto [start, size] = *it;
+        const vk::DeviceSize aligned = alignUp(start, alignment);
+        const vk::DeviceSize end = aligned + requirements.size;
+        if (end > start + size)
+            continue;
+
+        block.Free.erase(it);
+        if (end < start + size)
+        {
+            block.Free.emplace(end, start + size - end);
+        }
+        allocation.RangeOffset = start;
+        allocation.Offset = aligned;
+        block.AllocatedBytes += end - start;
+        ++block.Allocations;
+        return true;
+    }
+    return false;
+}
+
+tAllocation::tBlock *tMemoryAllocator::createBlock(const uint32_t memoryType,
+                                                   const tResource resource,
+                                                   const vk::DeviceSize size,
+                                                   const bool dedicated)
+{
+    if (Blocks.size() >= MaxAllocationCount)
+    {
+        throw std::runtime_error("tMemoryAllocator: maxMemoryAllocationCount reached");
+    }
+
+    // Buffer device addresses are a required feature, so every block can back buffers that use them.
+    vk::MemoryAllocateFlagsInfo flagsInfo{vk::MemoryAllocateFlagBits::eDeviceAddress};
+    vk::MemoryAllocateInfo allocInfo{size, memoryType, &flagsInfo};
+
+    auto block = std::make_unique<tBlock>();
+    block->Memory = vk::raii::DeviceMemory{Device, allocInfo};
+    block->MemoryType = memoryType;
+    block->Heap = MemoryProperties.memoryTypes[memoryType].heapIndex;
+    block->Resource = resource;
+    block->Size = size;
+    block->Dedicated = dedicated;
+    block->Free.emplace(0, size);
+    if (MemoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+    {
+        block->Mapped = block->Memory.mapMemory(0, VK_WHOLE_SIZE);
+    }
+
+    spdlog::debug("tMemoryAllocator: New {}{} block of {} bytes in memory type {}",
+                  dedicated ? "dedicated " : "",
+                  resource == tResource::Buffer ? "buffer" : "image",
+                  size,
+                  memoryType);
+    Blocks.push_back(std::move(block));
+    return Blocks.back().get();
+}
+
+bool tMemoryAllocator::fitsBudget(const uint32_t heap, const vk::DeviceSize size) const
+{
+    const auto budget = computeHeapBudgets()[heap];
+    return budget.Usage + size <= budget.Budget;
+}
+
+void tMemoryAllocator::free(tAllocation &allocation)
+{
+    std::lock_guard lock{Mutex};
+    auto &block = *allocation.Block;
+    const vk::DeviceSize start = allocation.RangeOffset;
+    vk::DeviceSize size = allocation.Offset + allocation.Size - start;
+    block.AllocatedBytes -= size;
+    --block.Allocations;
+
+    auto &tag = Tags.find(*allocation.Tag)->second;
+    tag.Bytes -= allocation.Size;
+    --tag.Allocations;
+    --AllocationCount;
+
+    auto next = block.Free.lower_bound(start);
+    if (next != block.Free.end() && start + size == next->first)
+    {
+        size += next->second;
+        next = block.Free.erase(next);
+    }
+    if (next != block.Free.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == start)
+        {
+            previous->second += size;
+            size = 0;
+        }
+    }
+    if (size > 0)
+    {
+        block.Free.emplace(start, size);
+    }
+
+    // Dedicated blocks go right away; shared ones once empty, unless the last of their kind, which is kept warm for
+    // the buffers recreated on the next resize.
+    if (block.Allocations > 0)
+        return;
+    const auto sameKind = std::ranges::count_if(Blocks, [&](const auto &other) {
+        return !other->Dedicated && other->MemoryType == block.MemoryType && other->Resource == block.Resource;
+    });
+    if (block.Dedicated || sameKind > 1)
+    {
+        std::erase_if(Blocks, [&](const auto &other) { return other.get() == &block; });
+    }
+}
@@ -0,0 +1,180 @@
+#include "engine/tPipelineCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <spdlog/fmt/fmt.h>
+#include <tracy/Tracy.hpp>
+
+namespace
+{
+constexpr std::array<char, 4> Magic{'V', 'C', 'P', 'C'};
+
+// FNV-1a; catches truncated and bit-flipped files, which drivers are not required to reject.
+uint64_t checksum(const std::vector<char> &data)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char byte : data)
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+} // namespace
+
+tPipelineCache::tPipelineCache(const vk::raii::PhysicalDevice &physicalDevice,
+                               const vk::raii::Device &device,
+                               std::filesystem::path path)
+    : Device(device), Properties(physicalDevice.getProperties()), Path(std::move(path))
+{
+    ZoneScopedN("tPipelineCache: tPipelineCache()");
+    spdlog::info("tPipelineCache: Initializing from {}...", Path.empty() ? "nothing" : Path.string());
+    const auto data = load();
+    Loaded = !data.empty();
+    vk::PipelineCacheCreateInfo pcci{};
+    pcci.initialDataSize = data.size();
+    pcci.pInitialData = data.data();
+    Cache = vk::raii::PipelineCache(Device, pcci);
+    spdlog::info("tPipelineCache: Initialized with {} bytes", data.size());
+}
+
+tPipelineCache::~tPipelineCache()
+{
+    save();
+    spdlog::info("tPipelineCache: Destroyed");
+}
+
+std::filesystem::path tPipelineCache::getDefaultPath(const vk::PhysicalDeviceProperties &properties)
+{
+    std::filesystem::path directory;
+    if (const char *cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome != nullptr && *cacheHome != '\0')
+    {
+        directory = cacheHome;
+    }
+    else if (const char *home = std::getenv("HOME"); home != nullptr && *home != '\0')
+    {
+        directory = std::filesystem::path(home) / ".cache";
+    }
+    else
+    {
+        std::error_code error;
+        directory = std::filesystem::temp_directory_path(error);
+    }
+
+    std::string uuid;
+    for (const uint8_t byte : properties.pipelineCacheUUID)
+    {
+        uuid += fmt::format("{:02x}", byte);
+    }
+    return directory / "vulkan-compute" / fmt::format("pipelines-{}.bin", uuid);
+}
+
+bool tPipelineCache::save() const
+{
+    if (Path.empty())
+        return false;
+
+    ZoneScopedN("tPipelineCache: save()");
+    const auto data = Cache.getData();
+    const std::vector<char> bytes(reinterpret_cast<const char *>(data.data()),
+                                  reinterpret_cast<const char *>(data.data()) + data.size());
+    const auto header = createHeader(bytes.size(), checksum(bytes));
+
+    // Several processes may save at once; each writes its own file and the last rename wins whole.
+    std::error_code error;
+    std::filesystem::create_directories(Path.parent_path(), error);
+    auto temporary = Path;
+    temporary += fmt::format(".{:08x}.tmp", std::random_device{}());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file)
+        {
+            spdlog::warn("tPipelineCache: Writing {} failed", temporary.string());
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, Path, error);
+    if (error)
+    {
+        spdlog::warn("tPipelineCache: Replacing {} failed: {}", Path.string(), error.message());
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    spdlog::info("tPipelineCache: Saved {} bytes to {}", bytes.size(), Path.string());
+    return true;
+}
+
+tPipelineCache::tHeader tPipelineCache::createHeader(const uint64_t dataSize, const uint64_t checksum) const
+{
+    tHeader header{};
+    header.Magic = Magic;
+    header.FormatVersion = FormatVersion;
+    header.VendorId = Properties.vendorID;
+    header.DeviceId = Properties.deviceID;
+    header.DriverVersion = Properties.driverVersion;
+    std::memcpy(header.CacheUuid.data(), Properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+    header.DataSize = dataSize;
+    header.Checksum = checksum;
+    return header;
+}
+
+std::vector<char> tPipelineCache::load() const
+{
+    if (Path.empty())
+        return {};
+
+    std::ifstream file(Path, std::ios::binary);
+    if (!file)
+    {
+        spdlog::info("tPipelineCache: No cache at {}, starting empty", Path.string());
+        return {};
+    }
+
+    tHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    const auto expected = createHeader(header.DataSize, header.Checksum);
+    if (!file || std::memcmp(&header, &expected, sizeof(header)) != 0)
+    {
+        spdlog::info("tPipelineCache: Cache at {} is from another device, driver or format, starting empty",
+                     Path.string());
+        return {};
+    }
+
+    // The size is checked against the file before anything is allocated for it.
+    std::error_code error;
+    const auto fileSize = std::filesystem::file_size(Path, error);
+    if (error || fileSize != sizeof(header) + header.DataSize)
+    {
+        spdlog::warn("tPipelineCache: Cache at {} is truncated, starting empty", Path.string());
+        return {};
+    }
+    std::vector<char> data(header.DataSize);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file || checksum(data) != header.Checksum || !isCompatible(data))
+    {
+        spdlog::warn("tPipelineCache: Cache at {} is damaged, starting empty", Path.string());
+        return {};
+    }
+    return data;
+}
+
+bool tPipelineCache::isCompatible(const std::vector<char> &data) const
+{
+    // The driver checks its own header too, but an incompatible blob is only guaranteed to be ignored, not rejected.
+    vk::PipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.headerSize >= sizeof(header) && header.headerVersion == vk::PipelineCacheHeaderVersion::eOne &&
+           header.vendorID == Properties.vendorID && header.deviceID == Properties.deviceID &&
+           header.pipelineCacheUUID == Properties.pipelineCacheUUID;
+}
@@ -1,5 +1,7 @@
 #include "engine/tRenderer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -12,27 +14,90 @@
 #include "engine/tGui.h"
 #include "engine/tSwapchain.h"
 #include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createBuffer.h"
+#include "helpers/createPipeline.h"
 #include "helpers/loadShaders.h"
-#include "sim/constants.h"
 #include "sim/tSim.h"
 
 namespace
 {
 struct ParticlePushConstants
 {
-    vk::DeviceAddress particles;
-    uint32_t numParticles;
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    vk::DeviceAddress renderStream;
+    vk::DeviceAddress counters;
+    vk::DeviceAddress clusterBounds;
+    vk::DeviceAddress cullStats;
+    uint32_t useRenderStream;
+    uint32_t cullingEnabled;
+    float lodDistance;
     uint32_t pad0;
-    uint32_t pad1;
-    uint32_t pad2;
 };
+
+struct SplatPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    vk::DeviceAddress renderStream;
+    vk::DeviceAddress counters;
+    vk::DeviceAddress target;
+    uint32_t useRenderStream;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pad0;
+};
+
+struct CompositePushConstants
+{
+    vk::DeviceAddress target;
+    uint32_t width;
+    uint32_t pad0;
+};
+
+constexpr uint32_t SplatLocalSize = 256;
+// Words of the splat buffer nothing was drawn to.
+constexpr uint32_t EmptySplat = ~0u;
+
+// Queue family ownership transfer of the buffers the graphics pass reads, from the compute to the graphics family.
+// The release half is recorded on the compute queue, the acquire half on the graphics queue. Nothing is handed back:
+// every compute pass rewrites these buffers before graphics reads them again, so their contents need not survive.
+std::array<vk::BufferMemoryBarrier2, 3> createHandOverBarriers(const tPhysics::tParticleBuffers &buffers,
+                                                               const uint32_t computeFamily,
+                                                               const uint32_t graphicsFamily,
+                                                               const bool acquire)
+{
+    vk::BufferMemoryBarrier2 barrier{};
+    if (acquire)
+    {
+        barrier.dstStageMask = vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eTaskShaderEXT |
+                               vk::PipelineStageFlagBits2::eMeshShaderEXT | vk::PipelineStageFlagBits2::eComputeShader;
+        barrier.dstAccessMask = vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderRead;
+    }
+    else
+    {
+        barrier.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer;
+        barrier.srcAccessMask = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eTransferWrite;
+    }
+    barrier.srcQueueFamilyIndex = computeFamily;
+    barrier.dstQueueFamilyIndex = graphicsFamily;
+    barrier.size = VK_WHOLE_SIZE;
+
+    std::array barriers{barrier, barrier, barrier};
+    barriers[0].buffer = *buffers.RenderStream.Buffer;
+    barriers[1].buffer = *buffers.DrawArgs.Buffer;
+    barriers[2].buffer = *buffers.ClusterBounds.Buffer;
+    return barriers;
+}
 } // namespace
 
 tRenderer::tRenderer(
     const tCamera &camera, const tGui &gui, const tVulkanDevice &device, tSwapchain &swapchain, tSim &sim)
     : Camera(camera), Gui(gui), Device(device), LogicalDevice(device.getLogicalDevice()),
-      PhysicalDevice(device.getPhysicalDevice()), Queue(device.getQueue()), Swapchain(swapchain), Sim(sim),
-      TracyContext(Device.getTracyContext()),
+      PhysicalDevice(device.getPhysicalDevice()), Queue(device.getQueue()), ComputeQueue(device.getComputeQueue()),
+      Swapchain(swapchain), Sim(sim), TracyContext(Device.getTracyContext()),
+      ComputeTracyContext(Device.getComputeTracyContext()),
       RecordGraphicsPerFrame(TracyContext != nullptr ? &tRenderer::recordGraphicsCommandBuffer
                                                      : &tRenderer::recordGraphicsCommandBufferNoop)
 {
@@ -40,8 +105,11 @@ tRenderer::tRenderer(
     initSwapchainLayouts();
     createShaderModules();
     createGraphicsPipeline();
+    createSplatPipeline();
     createCommandPool();
     createCommandBuffers();
+    createSplatBuffer();
+    createFrameStatsResources();
     createSyncObjects();
     recordReusableCommandBuffers();
     spdlog::info("tRenderer: Initialized");
@@ -70,18 +138,26 @@ void tRenderer::recreateSwapchain(const vk::Extent2D extent)
 {
     ZoneScopedN("tRenderer: recreateSwapchain()");
     spdlog::info("tRenderer: Recreating swapchain...");
+    const auto start = std::chrono::steady_clock::now();
     waitTimelineValue(LastTimelineValue);
     Queue.waitIdle();
+    ComputeQueue.waitIdle();
 
     Swapchain.recreate(extent);
     initSwapchainLayouts();
-    createGraphicsPipeline();
+    if (Swapchain.getColorFormat() != PipelineColorFormat || Swapchain.getDepthFormat() != PipelineDepthFormat)
+    {
+        createGraphicsPipeline();
+    }
     createCommandBuffers();
+    createSplatBuffer();
+    createFrameStatsResources();
     createSyncObjects();
     recordReusableCommandBuffers();
 
     IxCurrentFrame = 0;
-    spdlog::info("tRenderer: Swapchain recreated");
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info("tRenderer: Swapchain recreated in {:.1f} ms", elapsed.count());
 };
 
 void tRenderer::initSwapchainLayouts()
@@ -137,15 +213,12 @@ void tRenderer::createGraphicsPipeline()
 
     std::array stages{tsci, msci, fsci};
 
-    const auto extent = Swapchain.getExtent();
-    vk::Viewport vp{0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f};
-    vk::Rect2D sc{{0, 0}, extent};
-
+    // Viewport and scissor are dynamic, so a resize keeps the pipelines; only a format change rebuilds them.
     vk::PipelineViewportStateCreateInfo vpState{};
     vpState.viewportCount = 1;
-    vpState.pViewports = &vp;
     vpState.scissorCount = 1;
-    vpState.pScissors = &sc;
+    std::array dynamicStates{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    vk::PipelineDynamicStateCreateInfo dyn({}, dynamicStates);
 
     vk::PipelineRasterizationStateCreateInfo rs{};
     rs.polygonMode = vk::PolygonMode::eFill;
@@ -185,12 +258,38 @@ void tRenderer::createGraphicsPipeline()
     gpi.pMultisampleState = &ms;
     gpi.pDepthStencilState = &ds;
     gpi.pColorBlendState = &cb;
+    gpi.pDynamicState = &dyn;
     gpi.layout = *GraphicsPipelineLayout;
     gpi.renderPass = VK_NULL_HANDLE; // dynamic rendering
     gpi.subpass = 0;
 
-    GraphicsPipeline = vk::raii::Pipeline{LogicalDevice, nullptr, gpi};
-    spdlog::info("tRenderer: Graphics pipeline created");
+    GraphicsPipeline = vk::raii::Pipeline{LogicalDevice, Device.getPipelineCache(), gpi};
+
+    // The compute rasterizer's composite shares every fixed-function state; it reads the splat buffer per pixel.
+    vk::PushConstantRange compositePcRange{vk::ShaderStageFlagBits::eFragment, 0, sizeof(CompositePushConstants)};
+    CompositePipelineLayout =
+        vk::raii::PipelineLayout(LogicalDevice, vk::PipelineLayoutCreateInfo{{}, {}, compositePcRange});
+    msci.module = *CompositeMeshShaderModule;
+    fsci.module = *CompositeFragmentShaderModule;
+    std::array compositeStages{msci, fsci};
+    gpi.stageCount = static_cast<uint32_t>(compositeStages.size());
+    gpi.pStages = compositeStages.data();
+    gpi.layout = *CompositePipelineLayout;
+    CompositePipeline = vk::raii::Pipeline{LogicalDevice, Device.getPipelineCache(), gpi};
+    PipelineColorFormat = Swapchain.getColorFormat();
+    PipelineDepthFormat = Swapchain.getDepthFormat();
+    spdlog::info("tRenderer: Graphics pipelines created");
+}
+
+void tRenderer::createSplatPipeline()
+{
+    spdlog::info("tRenderer: Creating splat pipeline...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(SplatPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *Camera.getDescriptorSetLayout(), pcRange);
+    SplatPipelineLayout = LogicalDevice.createPipelineLayout(plci);
+    const auto &cache = Device.getPipelineCache();
+    SplatPipeline = createComputePipeline(LogicalDevice, cache, SplatPipelineLayout, "pointSplat.comp.spv");
+    spdlog::info("tRenderer: Splat pipeline created");
 }
 
 void tRenderer::createSyncObjects()
@@ -219,6 +318,8 @@ void tRenderer::createSyncObjects()
     vk::SemaphoreTypeCreateInfo timelineTypeInfo{vk::SemaphoreType::eTimeline};
     vk::SemaphoreCreateInfo timelineCreateInfo{{}, &timelineTypeInfo};
     FrameTimeline = vk::raii::Semaphore(LogicalDevice, timelineCreateInfo);
+    ComputeTimeline = vk::raii::Semaphore(LogicalDevice, timelineCreateInfo);
+    LastComputeValue = 0;
     FrameTimelineValues.assign(MAX_FRAMES_IN_FLIGHT, 0);
     ImageTimelineValues.assign(imageCount, 0);
     LastTimelineValue = 0;
@@ -234,6 +335,8 @@ void tRenderer::createShaderModules()
     TaskShaderModule = loadShaderModule(LogicalDevice, "task.task.spv");
     MeshShaderModule = loadShaderModule(LogicalDevice, "mesh.mesh.spv");
     FragmentShaderModule = loadShaderModule(LogicalDevice, "fragment.frag.spv");
+    CompositeMeshShaderModule = loadShaderModule(LogicalDevice, "composite.mesh.spv");
+    CompositeFragmentShaderModule = loadShaderModule(LogicalDevice, "composite.frag.spv");
     spdlog::info("tRenderer: Shader modules created");
 }
 
@@ -242,11 +345,13 @@ void tRenderer::createCommandBuffers()
     spdlog::info("tRenderer: Creating command buffers...");
     CommandBuffers.clear();
     CommandBuffers = vk::raii::CommandBuffers(
-        LogicalDevice, {CommandPool, vk::CommandBufferLevel::ePrimary, Swapchain.getImageCount()});
+        LogicalDevice, {CommandPool, vk::CommandBufferLevel::ePrimary, Swapchain.getImageCount() * tSim::ParitySets});
     GuiCommandBuffers = vk::raii::CommandBuffers(
         LogicalDevice, {CommandPool, vk::CommandBufferLevel::ePrimary, Swapchain.getImageCount()});
     SimCommandBuffers = vk::raii::CommandBuffers(
-        LogicalDevice, {CommandPool, vk::CommandBufferLevel::ePrimary, Swapchain.getImageCount()});
+        LogicalDevice, {ComputeCommandPool, vk::CommandBufferLevel::ePrimary, Swapchain.getImageCount()});
+    RecordedStates.assign(Swapchain.getImageCount() * tSim::ParitySets, {});
+    SubmittedGraphicsBuffers.assign(Swapchain.getImageCount(), 0);
     spdlog::info("tRenderer: Created command buffers");
 }
 
@@ -255,9 +360,71 @@ void tRenderer::createCommandPool()
     spdlog::info("tRenderer: Creating command pool...");
     vk::CommandPoolCreateInfo cpci({vk::CommandPoolCreateFlagBits::eResetCommandBuffer}, Device.getQueueFamily());
     CommandPool = LogicalDevice.createCommandPool(cpci);
+    cpci.queueFamilyIndex = Device.getComputeQueueFamily();
+    ComputeCommandPool = LogicalDevice.createCommandPool(cpci);
     spdlog::info("tRenderer: Command pool created");
 }
 
+void tRenderer::createSplatBuffer()
+{
+    const auto extent = Swapchain.getExtent();
+    SplatBuffer = createStorageBuffer(
+        Device, std::max(extent.width * extent.height, 1u) * vk::DeviceSize{sizeof(uint32_t)}, "tRenderer");
+}
+
+void tRenderer::createFrameStatsResources()
+{
+    spdlog::info("tRenderer: Creating frame stats resources...");
+    const auto imageCount = Swapchain.getImageCount();
+    void *mapped = nullptr;
+    std::tie(CullStatsBuffer, CullStatsMemory, mapped) =
+        createBuffer(Device,
+                     imageCount * sizeof(tCullStats),
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "tRenderer");
+    MappedCullStats = static_cast<tCullStats *>(mapped);
+    std::fill_n(MappedCullStats, imageCount, tCullStats{});
+    CullStatsAddress = LogicalDevice.getBufferAddress(vk::BufferDeviceAddressInfo{*CullStatsBuffer});
+
+    TimestampPool = nullptr;
+    const auto families = PhysicalDevice.getQueueFamilyProperties();
+    if (families[Device.getQueueFamily()].timestampValidBits > 0)
+    {
+        TimestampPool = LogicalDevice.createQueryPool({{}, vk::QueryType::eTimestamp, 2 * imageCount});
+        TimestampPeriod = PhysicalDevice.getProperties().limits.timestampPeriod;
+    }
+    else
+    {
+        spdlog::warn("tRenderer: Graphics queue has no timestamps, particle pass times are not measured");
+    }
+    FrameStats = {};
+    spdlog::info("tRenderer: Frame stats resources created");
+}
+
+void tRenderer::collectFrameStats(const uint32_t ixImage)
+{
+    // The image's last frame has completed, so its slots are final; zeroing the counts before the next submit is
+    // visible to the device without a barrier.
+    if (ImageTimelineValues[ixImage] > 0)
+    {
+        FrameStats.Rasterizer = RecordedStates[SubmittedGraphicsBuffers[ixImage]].Rasterizer;
+        FrameStats.Cull = MappedCullStats[ixImage];
+        if (*TimestampPool)
+        {
+            const auto [result, ticks] = TimestampPool.getResults<uint64_t>(
+                2 * ixImage, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+            if (result == vk::Result::eSuccess && ticks[1] >= ticks[0])
+            {
+                FrameStats.ParticlePassMs = static_cast<float>((ticks[1] - ticks[0]) * TimestampPeriod * 1e-6);
+            }
+        }
+    }
+    MappedCullStats[ixImage] = {};
+}
+
 std::pair<vk::Result, uint32_t> tRenderer::acquireNextImage()
 {
     ZoneScopedN("tRenderer: acquireNextImage()");
@@ -302,6 +469,7 @@ std::pair<vk::Result, uint32_t> tRenderer::synchronizeFrame()
     {
         waitTimelineValue(imageValue);
     }
+    collectFrameStats(ixImage);
     spdlog::trace("tRenderer: Synchronized frame with index {} and image with index {}", IxCurrentFrame, ixImage);
     return acquireResult;
 }
@@ -310,6 +478,8 @@ void tRenderer::submit(const uint32_t ixImage)
 {
     ZoneScopedN("tRenderer: submit()");
     spdlog::trace("tRenderer: Starting submit of command buffer at image index {}", ixImage);
+    // Uploads issued while recording, such as a grown pool's counters, go ahead of the step that uses them.
+    Device.getUploader().flush();
     const uint64_t signalValue = ++LastTimelineValue;
     vk::SemaphoreSubmitInfo wsi(
         ImageAvailable[IxCurrentFrame], 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput, 0);
@@ -317,15 +487,52 @@ void tRenderer::submit(const uint32_t ixImage)
     vk::SemaphoreSubmitInfo timelineSignal(FrameTimeline, signalValue, vk::PipelineStageFlagBits2::eAllCommands, 0);
 
     vk::CommandBufferSubmitInfo simCbsi(SimCommandBuffers[ixImage]);
-    vk::CommandBufferSubmitInfo cbsi(CommandBuffers[ixImage]);
+    vk::CommandBufferSubmitInfo cbsi(CommandBuffers[SubmittedGraphicsBuffers[ixImage]]);
     vk::CommandBufferSubmitInfo guiCbsi(GuiCommandBuffers[ixImage]);
-    std::array bufferInfos{simCbsi, cbsi, guiCbsi};
 
-    std::array waitInfos{wsi};
-    std::array signalInfos{renderSignal, timelineSignal};
-    vk::SubmitInfo2 si{};
-    si.setWaitSemaphoreInfos(waitInfos).setCommandBufferInfos(bufferInfos).setSignalSemaphoreInfos(signalInfos);
-    Queue.submit2(si);
+    if (!Device.hasAsyncCompute())
+    {
+        std::array bufferInfos{simCbsi, cbsi, guiCbsi};
+        std::array waitInfos{wsi};
+        std::array signalInfos{renderSignal, timelineSignal};
+        vk::SubmitInfo2 si{};
+        si.setWaitSemaphoreInfos(waitInfos).setCommandBufferInfos(bufferInfos).setSignalSemaphoreInfos(signalInfos);
+        Queue.submit2(si);
+        Sim.submitReadbacks();
+    }
+    else
+    {
+        // The step only overwrites buffers the graphics pass of two frames ago read; that frame's timeline value
+        // was already waited for on the host, the wait here makes the dependency explicit to the device. The frame
+        // slot IxCurrentFrame last held is that frame only while frames in flight and buffer parities cycle in step;
+        // with more frames in flight it would be an older frame, and compute would race the graphics in between.
+        static_assert(MAX_FRAMES_IN_FLIGHT == tSim::ParitySets);
+        const uint64_t computeValue = ++LastComputeValue;
+        vk::SemaphoreSubmitInfo computeWait(
+            FrameTimeline, FrameTimelineValues[IxCurrentFrame], vk::PipelineStageFlagBits2::eAllCommands, 0);
+        vk::SemaphoreSubmitInfo computeSignal(
+            ComputeTimeline, computeValue, vk::PipelineStageFlagBits2::eAllCommands, 0);
+        vk::SubmitInfo2 computeSi{};
+        computeSi.setWaitSemaphoreInfos(computeWait).setCommandBufferInfos(simCbsi).setSignalSemaphoreInfos(
+            computeSignal);
+        ComputeQueue.submit2(computeSi);
+        Sim.submitReadbacks();
+
+        // Graphics of this frame overlaps the next frame's step; only drawing waits for the particles.
+        vk::SemaphoreSubmitInfo particlesWait(ComputeTimeline,
+                                              computeValue,
+                                              vk::PipelineStageFlagBits2::eDrawIndirect |
+                                                  vk::PipelineStageFlagBits2::eTaskShaderEXT |
+                                                  vk::PipelineStageFlagBits2::eMeshShaderEXT |
+                                                  vk::PipelineStageFlagBits2::eComputeShader,
+                                              0);
+        std::array bufferInfos{cbsi, guiCbsi};
+        std::array waitInfos{wsi, particlesWait};
+        std::array signalInfos{renderSignal, timelineSignal};
+        vk::SubmitInfo2 si{};
+        si.setWaitSemaphoreInfos(waitInfos).setCommandBufferInfos(bufferInfos).setSignalSemaphoreInfos(signalInfos);
+        Queue.submit2(si);
+    }
 
     FrameTimelineValues[IxCurrentFrame] = signalValue;
     ImageTimelineValues[ixImage] = signalValue;
@@ -380,16 +587,31 @@ void tRenderer::recordPerFrameCommandBuffers(const uint32_t ixImage)
     simBuffer.reset();
     simBuffer.begin({});
     // Tracy GPU collection needs a recording command buffer outside a render pass; simBuffer is always recorded.
-    if (TracyContext != nullptr)
+    if (ComputeTracyContext != nullptr)
     {
-        TracyVkCollect(TracyContext, *simBuffer);
+        TracyVkCollect(ComputeTracyContext, *simBuffer);
     }
     {
-        TracyVkNamedZone(TracyContext, tracySimZone, *simBuffer, "Sim Command Buffer", true);
+        TracyVkNamedZone(ComputeTracyContext, tracySimZone, *simBuffer, "Sim Command Buffer", true);
         Sim.recordComputePass(simBuffer, ixImage);
     }
+    if (Device.hasAsyncCompute())
+    {
+        const auto release = createHandOverBarriers(
+            Sim.getParticleBuffers(), Device.getComputeQueueFamily(), Device.getQueueFamily(), false);
+        simBuffer.pipelineBarrier2(vk::DependencyInfo{}.setBufferMemoryBarriers(release));
+    }
     simBuffer.end();
 
+    // Growing the particle pool moves the particle buffers, toggling the render stream changes what the mesh shader
+    // reads and the culling settings are push constants, all of which reusable buffers have baked in. The A/B swap
+    // only changes which of the image's two buffers is submitted.
+    const uint32_t ixBuffer = getGraphicsBufferIndex(ixImage);
+    if (RecordedStates.size() > ixBuffer && RecordedStates[ixBuffer] != getRecordedState())
+    {
+        recordGraphicsCommandBuffer(ixImage);
+    }
+    SubmittedGraphicsBuffers[ixImage] = ixBuffer;
     (this->*RecordGraphicsPerFrame)(ixImage);
 
     const auto &guiBuffer = GuiCommandBuffers[ixImage];
@@ -406,7 +628,8 @@ void tRenderer::recordPerFrameCommandBuffers(const uint32_t ixImage)
 
 void tRenderer::recordGraphicsPass(const vk::raii::CommandBuffer &buffer,
                                    const vk::Image &image,
-                                   const vk::raii::ImageView &imageView)
+                                   const vk::raii::ImageView &imageView,
+                                   const uint32_t ixImage)
 {
     ZoneScopedN("tRenderer: recordGraphicsPass");
     spdlog::trace("tRenderer: Recording graphics pass...");
@@ -444,16 +667,41 @@ void tRenderer::recordGraphicsPass(const vk::raii::CommandBuffer &buffer,
     preBarrier.image = image;
     preBarrier.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
 
+    if (Rasterizer == tRasterizer::Compute)
+    {
+        recordSplatPass(buffer);
+    }
     buffer.pipelineBarrier2({{}, {}, {}, preBarrier});
     buffer.beginRendering(ri);
+    const auto extent = Swapchain.getExtent();
+    buffer.setViewport(0, vk::Viewport{0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f});
+    buffer.setScissor(0, vk::Rect2D{{0, 0}, extent});
+    if (Rasterizer == tRasterizer::Compute)
+    {
+        const CompositePushConstants compositePc{SplatBuffer.Address, Swapchain.getExtent().width, 0u};
+        const vk::PushConstantsInfo pushConstantsInfo{
+            *CompositePipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(compositePc), &compositePc};
+        buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *CompositePipeline);
+        buffer.pushConstants2(pushConstantsInfo);
+        buffer.drawMeshTasksEXT(1, 1, 1);
+        buffer.endRendering();
+        recordParticlePassEnd(buffer, ixImage);
+        return;
+    }
     buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *GraphicsPipeline);
 
-    const ParticlePushConstants particlePc{
-        LogicalDevice.getBufferAddress(vk::BufferDeviceAddressInfo{*Sim.getParticleBuffer()}),
-        NUM_PARTICLES,
-        0u,
-        0u,
-        0u};
+    const auto &particles = Sim.getParticleBuffers();
+    const auto &culling = Camera.getCulling();
+    const ParticlePushConstants particlePc{particles.Positions.Address,
+                                           particles.Velocities.Address,
+                                           particles.RenderStream.Address,
+                                           particles.DrawArgs.Address,
+                                           particles.ClusterBounds.Address,
+                                           CullStatsAddress + ixImage * sizeof(tCullStats),
+                                           Sim.isRenderStreamEnabled() ? 1u : 0u,
+                                           culling.Enabled ? 1u : 0u,
+                                           culling.LodDistance,
+                                           0u};
     const vk::PushConstantsInfo pushConstantsInfo{*GraphicsPipelineLayout,
                                                   vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT,
                                                   0,
@@ -462,29 +710,112 @@ void tRenderer::recordGraphicsPass(const vk::raii::CommandBuffer &buffer,
     buffer.pushConstants2(pushConstantsInfo);
     buffer.bindDescriptorSets(
         vk::PipelineBindPoint::eGraphics, *GraphicsPipelineLayout, 1, *Camera.getDescriptorSet(), {});
-    buffer.drawMeshTasksEXT(1, 1, 1);
+    // One task workgroup per tParticlePool::TaskParticles live slots, counted on the GPU; each culls its clusters.
+    buffer.drawMeshTasksIndirectEXT(*particles.DrawArgs.Buffer,
+                                    tParticlePool::DrawArgsOffset,
+                                    1,
+                                    sizeof(vk::DrawMeshTasksIndirectCommandEXT));
     buffer.endRendering();
+    recordParticlePassEnd(buffer, ixImage);
+}
+
+void tRenderer::recordSplatPass(const vk::raii::CommandBuffer &buffer) const
+{
+    TracyVkNamedZone(TracyContext, tracySplatZone, *buffer, "Point Splat", true);
+    // The previous frame's composite may still read the buffer the clear overwrites.
+    const vk::MemoryBarrier2 clearBarrier{vk::PipelineStageFlagBits2::eFragmentShader,
+                                          vk::AccessFlagBits2::eNone,
+                                          vk::PipelineStageFlagBits2::eTransfer,
+                                          vk::AccessFlagBits2::eTransferWrite};
+    buffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(clearBarrier));
+    buffer.fillBuffer(*SplatBuffer.Buffer, 0, VK_WHOLE_SIZE, EmptySplat);
+    recordTransferToComputeBarrier(buffer);
+
+    const auto &particles = Sim.getParticleBuffers();
+    const auto extent = Swapchain.getExtent();
+    const SplatPushConstants pc{particles.Positions.Address,
+                                particles.Velocities.Address,
+                                particles.RenderStream.Address,
+                                particles.DrawArgs.Address,
+                                SplatBuffer.Address,
+                                Sim.isRenderStreamEnabled() ? 1u : 0u,
+                                extent.width,
+                                extent.height,
+                                0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *SplatPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    buffer.bindPipeline(vk::PipelineBindPoint::eCompute, *SplatPipeline);
+    buffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute, *SplatPipelineLayout, 0, *Camera.getDescriptorSet(), {});
+    buffer.pushConstants2(pushConstantsInfo);
+    // Live slots are only counted on the GPU, so every slot up to the capacity gets an invocation.
+    buffer.dispatch((Sim.getCapacity() + SplatLocalSize - 1) / SplatLocalSize, 1, 1);
+
+    const vk::MemoryBarrier2 compositeBarrier{vk::PipelineStageFlagBits2::eComputeShader,
+                                              vk::AccessFlagBits2::eShaderWrite,
+                                              vk::PipelineStageFlagBits2::eFragmentShader,
+                                              vk::AccessFlagBits2::eShaderRead};
+    buffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(compositeBarrier));
+}
+
+void tRenderer::recordParticlePassEnd(const vk::raii::CommandBuffer &buffer, const uint32_t ixImage) const
+{
+    if (*TimestampPool)
+    {
+        buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *TimestampPool, 2 * ixImage + 1);
+    }
+    const vk::MemoryBarrier2 statsBarrier{vk::PipelineStageFlagBits2::eTaskShaderEXT,
+                                          vk::AccessFlagBits2::eShaderWrite,
+                                          vk::PipelineStageFlagBits2::eHost,
+                                          vk::AccessFlagBits2::eHostRead};
+    buffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(statsBarrier));
     spdlog::trace("tRenderer: Recorded graphics pass");
 }
 
 void tRenderer::recordGraphicsCommandBuffer(const uint32_t ixImage)
 {
     spdlog::trace("tRenderer: Starting recording of command buffer at image index {}", ixImage);
-    const auto &commandBuffer = CommandBuffers[ixImage];
+    const uint32_t ixBuffer = getGraphicsBufferIndex(ixImage);
+    const auto &commandBuffer = CommandBuffers[ixBuffer];
     const auto &image = Swapchain.getImage(ixImage);
     const auto &view = Swapchain.getImageView(ixImage);
     commandBuffer.reset();
+    RecordedStates[ixBuffer] = getRecordedState();
     commandBuffer.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eSimultaneousUse});
+    if (*TimestampPool)
+    {
+        commandBuffer.resetQueryPool(*TimestampPool, 2 * ixImage, 2);
+        commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *TimestampPool, 2 * ixImage);
+    }
     {
         TracyVkNamedZone(TracyContext, tracyGraphicsZone, *commandBuffer, "Graphics Command Buffer", true);
-        commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(ComputeToGraphicsBarrier));
-        recordGraphicsPass(commandBuffer, image, view);
+        if (Device.hasAsyncCompute())
+        {
+            const auto acquire = createHandOverBarriers(
+                Sim.getParticleBuffers(), Device.getComputeQueueFamily(), Device.getQueueFamily(), true);
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setBufferMemoryBarriers(acquire));
+        }
+        else
+        {
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(ComputeToGraphicsBarrier));
+        }
+        recordGraphicsPass(commandBuffer, image, view, ixImage);
     }
 
     commandBuffer.end();
     spdlog::trace("tRenderer: Ended recording of command buffer at image index {}", ixImage);
 }
 
+tRenderer::tRecordedState tRenderer::getRecordedState() const
+{
+    return {Sim.getCapacity(), Sim.isRenderStreamEnabled(), Camera.getCulling(), Rasterizer};
+}
+
+uint32_t tRenderer::getGraphicsBufferIndex(const uint32_t ixImage) const
+{
+    return ixImage * tSim::ParitySets + Sim.getParity();
+}
+
 void tRenderer::waitTimelineValue(const uint64_t value)
 {
     if (value == 0)
@@ -4,7 +4,6 @@
 #include <stdexcept>
 
 #include "engine/tVulkanDevice.h"
-#include "helpers/memoryAllocation.h"
 
 namespace
 {
@@ -24,6 +23,7 @@ void tSwapchain::init(const vk::raii::Instance &instance,
     Device = &device.getLogicalDevice();
     PhysicalDevice = &device.getPhysicalDevice();
     Queue = &device.getQueue();
+    Allocator = &device.getAllocator();
     Surface = &surface;
 
     create(extent);
@@ -129,10 +129,8 @@ void tSwapchain::createDepthResources()
 
     DepthBuffer.Image = Device->createImage(ici);
 
-    const auto allocInfo = getMemoryAllocateInfo(
-        *PhysicalDevice, DepthBuffer.Image.getMemoryRequirements(), vk::MemoryPropertyFlagBits::eDeviceLocal);
-    DepthBuffer.Memory = Device->allocateMemory(allocInfo);
-    DepthBuffer.Image.bindMemory(DepthBuffer.Memory, 0);
+    DepthBuffer.Memory =
+        Allocator->allocate(DepthBuffer.Image, vk::MemoryPropertyFlagBits::eDeviceLocal, "tSwapchain");
 
     vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eDepth;
     if (DepthFormat == vk::Format::eD32SfloatS8Uint || DepthFormat == vk::Format::eD24UnormS8Uint)
@@ -0,0 +1,251 @@
+#include "engine/tUploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/createBuffer.h"
+
+namespace
+{
+// Keeps every chunk's source offset aligned for the copy engines that prefer it.
+constexpr vk::DeviceSize ChunkAlignment = 16;
+
+void beginOneTime(const vk::raii::CommandBuffer &commandBuffer)
+{
+    commandBuffer.reset();
+    commandBuffer.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+}
+} // namespace
+
+tUploader::tUploader(const tVulkanDevice &device)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), ComputeFamily(device.getComputeQueueFamily()),
+      TransferFamily(device.getTransferQueueFamily())
+{
+    void *mapped = nullptr;
+    std::tie(Ring, RingMemory, mapped) =
+        createBuffer(device,
+                     SegmentSize * SegmentCount,
+                     vk::BufferUsageFlagBits::eTransferSrc,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "tUploader");
+    MappedRing = static_cast<char *>(mapped);
+
+    vk::SemaphoreTypeCreateInfo timelineTypeInfo{vk::SemaphoreType::eTimeline};
+    Timeline = vk::raii::Semaphore(LogicalDevice, vk::SemaphoreCreateInfo{{}, &timelineTypeInfo});
+    createCommandBuffers();
+    spdlog::info("tUploader: {} x {} MiB staging ring, copies on the {} queue",
+                 SegmentCount,
+                 SegmentSize >> 20,
+                 usesTransferQueue() ? "transfer" : "compute");
+}
+
+tUploader::~tUploader()
+{
+    if (!Copies.empty())
+    {
+        spdlog::warn("tUploader: Dropping {} copies that were never flushed", Copies.size());
+    }
+    wait(SubmittedValue);
+}
+
+void tUploader::createCommandBuffers()
+{
+    vk::CommandPoolCreateInfo cpci({vk::CommandPoolCreateFlagBits::eResetCommandBuffer}, ComputeFamily);
+    ComputePool = vk::raii::CommandPool(LogicalDevice, cpci);
+    if (usesTransferQueue())
+    {
+        cpci.queueFamilyIndex = TransferFamily;
+        TransferPool = vk::raii::CommandPool(LogicalDevice, cpci);
+    }
+
+    const auto allocate = [this](const vk::raii::CommandPool &pool) {
+        vk::raii::CommandBuffers buffers(LogicalDevice, {*pool, vk::CommandBufferLevel::ePrimary, 1});
+        return std::move(buffers[0]);
+    };
+    for (auto &segment : Segments)
+    {
+        if (usesTransferQueue())
+        {
+            segment.Release = allocate(ComputePool);
+            segment.Copy = allocate(TransferPool);
+            segment.Acquire = allocate(ComputePool);
+        }
+        else
+        {
+            segment.Copy = allocate(ComputePool);
+        }
+    }
+}
+
+uint64_t tUploader::upload(const vk::Buffer destination,
+                           vk::DeviceSize offset,
+                           const void *data,
+                           vk::DeviceSize size)
+{
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        if (Used == SegmentSize)
+        {
+            flush();
+        }
+        const vk::DeviceSize chunk = std::min(size, SegmentSize - Used);
+        const vk::DeviceSize source = Current * SegmentSize + Used;
+        std::memcpy(MappedRing + source, bytes, static_cast<size_t>(chunk));
+        Copies.push_back({destination, vk::BufferCopy{source, offset, chunk}});
+
+        Used = std::min(SegmentSize, (Used + chunk + ChunkAlignment - 1) & ~(ChunkAlignment - 1));
+        bytes += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+    return SubmittedValue + (usesTransferQueue() ? 3 : 1);
+}
+
+uint64_t tUploader::flush()
+{
+    if (Copies.empty())
+    {
+        return SubmittedValue;
+    }
+    ZoneScopedN("tUploader: flush()");
+    using Stage = vk::PipelineStageFlagBits2;
+    using Access = vk::AccessFlagBits2;
+    auto &segment = Segments[Current];
+    const auto record = [this](const vk::raii::CommandBuffer &commandBuffer,
+                               const std::vector<vk::BufferMemoryBarrier2> &before,
+                               const std::vector<vk::BufferMemoryBarrier2> &after,
+                               const bool copy) {
+        beginOneTime(commandBuffer);
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setBufferMemoryBarriers(before));
+        if (copy)
+        {
+            for (const auto &[destination, region] : Copies)
+            {
+                commandBuffer.copyBuffer(*Ring, destination, region);
+            }
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setBufferMemoryBarriers(after));
+        }
+        commandBuffer.end();
+    };
+
+    const auto &computeQueue = Device.getComputeQueue();
+    const uint64_t base = SubmittedValue;
+    if (usesTransferQueue())
+    {
+        // Release after whatever the compute queue did with the destinations so far, copy on the transfer queue,
+        // then acquire back before anything the compute queue does next. The device orders all three; the host
+        // only submits.
+        const auto release =
+            createBarriers(Stage::eAllCommands, Access::eMemoryWrite, Stage::eNone, {}, ComputeFamily, TransferFamily);
+        const auto transferAcquire =
+            createBarriers(Stage::eNone, {}, Stage::eCopy, Access::eTransferWrite, ComputeFamily, TransferFamily);
+        const auto transferRelease =
+            createBarriers(Stage::eCopy, Access::eTransferWrite, Stage::eNone, {}, TransferFamily, ComputeFamily);
+        const auto acquire = createBarriers(Stage::eAllCommands,
+                                           {},
+                                           Stage::eAllCommands,
+                                           Access::eMemoryRead | Access::eMemoryWrite,
+                                           TransferFamily,
+                                           ComputeFamily);
+        record(segment.Release, release, {}, false);
+        record(segment.Copy, transferAcquire, transferRelease, true);
+        record(segment.Acquire, acquire, {}, false);
+        submit(computeQueue, segment.Release, 0, base + 1);
+        submit(Device.getTransferQueue(), segment.Copy, base + 1, base + 2);
+        submit(computeQueue, segment.Acquire, base + 2, base + 3);
+        SubmittedValue = base + 3;
+    }
+    else
+    {
+        const auto before = createBarriers(Stage::eAllCommands,
+                                          Access::eMemoryRead | Access::eMemoryWrite,
+                                          Stage::eCopy,
+                                          Access::eTransferWrite);
+        const auto after = createBarriers(
+            Stage::eCopy, Access::eTransferWrite, Stage::eAllCommands, Access::eMemoryRead | Access::eMemoryWrite);
+        record(segment.Copy, before, after, true);
+        submit(computeQueue, segment.Copy, 0, base + 1);
+        SubmittedValue = base + 1;
+    }
+
+    spdlog::trace("tUploader: Flushed {} copies in segment {} (value {})", Copies.size(), Current, SubmittedValue);
+    segment.Value = SubmittedValue;
+    Copies.clear();
+    advance();
+    return SubmittedValue;
+}
+
+bool tUploader::isComplete(const uint64_t value) const
+{
+    return Timeline.getCounterValue() >= value;
+}
+
+void tUploader::wait(const uint64_t value) const
+{
+    if (value == 0 || isComplete(value))
+    {
+        return;
+    }
+    const vk::Semaphore semaphores[] = {*Timeline};
+    const uint64_t values[] = {value};
+    const auto result = LogicalDevice.waitSemaphores(vk::SemaphoreWaitInfo{{}, 1, semaphores, values}, UINT64_MAX);
+    if (result != vk::Result::eSuccess)
+    {
+        spdlog::warn("tUploader: waitSemaphores returned {}", vk::to_string(result));
+    }
+}
+
+void tUploader::submit(const vk::raii::Queue &queue,
+                       const vk::raii::CommandBuffer &commandBuffer,
+                       const uint64_t waitValue,
+                       const uint64_t signalValue) const
+{
+    vk::CommandBufferSubmitInfo cbsi(commandBuffer);
+    vk::SemaphoreSubmitInfo waitInfo(Timeline, waitValue, vk::PipelineStageFlagBits2::eAllCommands, 0);
+    vk::SemaphoreSubmitInfo signalInfo(Timeline, signalValue, vk::PipelineStageFlagBits2::eAllCommands, 0);
+    vk::SubmitInfo2 si{};
+    si.setCommandBufferInfos(cbsi).setSignalSemaphoreInfos(signalInfo);
+    if (waitValue > 0)
+    {
+        si.setWaitSemaphoreInfos(waitInfo);
+    }
+    queue.submit2(si);
+}
+
+std::vector<vk::BufferMemoryBarrier2> tUploader::createBarriers(const vk::PipelineStageFlags2 srcStage,
+                                                                const vk::AccessFlags2 srcAccess,
+                                                                const vk::PipelineStageFlags2 dstStage,
+                                                                const vk::AccessFlags2 dstAccess,
+                                                                const uint32_t srcFamily,
+                                                                const uint32_t dstFamily) const
+{
+    std::vector<vk::BufferMemoryBarrier2> barriers;
+    for (const auto &copy : Copies)
+    {
+        if (std::ranges::any_of(barriers, [&copy](const auto &barrier) { return barrier.buffer == copy.Destination; }))
+        {
+            continue;
+        }
+        barriers.emplace_back(
+            srcStage, srcAccess, dstStage, dstAccess, srcFamily, dstFamily, copy.Destination, 0, vk::WholeSize);
+    }
+    return barriers;
+}
+
+void tUploader::advance()
+{
+    Current = (Current + 1) % SegmentCount;
+    Used = 0;
+    if (!isComplete(Segments[Current].Value))
+    {
+        ZoneScopedN("tUploader: ring full");
+        spdlog::debug("tUploader: Ring wrapped onto segment {} still in flight, waiting", Current);
+        wait(Segments[Current].Value);
+    }
+}
@@ -13,6 +13,11 @@ constexpr std::array<const char *, 4> DEVICE_EXTENSIONS = {VK_KHR_SWAPCHAIN_EXTE
 
 tVulkanDevice::~tVulkanDevice()
 {
+    if (ComputeTracyContext != nullptr && ComputeTracyContext != TracyContext)
+    {
+        TracyVkDestroy(ComputeTracyContext);
+    }
+    ComputeTracyContext = nullptr;
     if (TracyContext != nullptr)
     {
         TracyVkDestroy(TracyContext);
@@ -21,22 +26,34 @@ tVulkanDevice::~tVulkanDevice()
     spdlog::info("tVulkanDevice: Destroyed");
 }
 
-void tVulkanDevice::init(const vk::raii::Instance &instance, const vk::SurfaceKHR &surface, const bool enableValidation)
+void tVulkanDevice::init(const vk::raii::Instance &instance,
+                         const vk::SurfaceKHR &surface,
+                         const bool enableValidation,
+                         const bool enableAsyncCompute,
+                         const bool persistPipelineCache)
 {
     spdlog::info("tVulkanDevice: Initializing...");
     ValidationEnabled = enableValidation;
+    AsyncComputeEnabled = enableAsyncCompute;
+    PipelineCachePersisted = persistPipelineCache;
     Surface = surface;
     pickPhysicalDevice(instance);
+    pickComputeQueueFamily();
+    pickTransferQueueFamily();
     createLogicalDevice();
+    createPipelineCache();
+    createAllocator();
     createCommandPool();
+    createUploader();
     initTracyContext();
     spdlog::info("tVulkanDevice: Initialized");
 }
 
-vk::raii::CommandBuffer tVulkanDevice::beginSingleTimeCommands() const
+vk::raii::CommandBuffer tVulkanDevice::beginSingleTimeCommands(const tQueueType queue) const
 {
     spdlog::trace("tVulkanDevice: Starting single time command...");
-    vk::CommandBufferAllocateInfo cbai(*CommandPool, vk::CommandBufferLevel::ePrimary, 1);
+    const auto &pool = queue == tQueueType::Graphics ? CommandPool : ComputeCommandPool;
+    vk::CommandBufferAllocateInfo cbai(*pool, vk::CommandBufferLevel::ePrimary, 1);
     vk::raii::CommandBuffers commandBuffers(Device, cbai);
     vk::raii::CommandBuffer commandBuffer = std::move(commandBuffers[0]);
 
@@ -48,10 +65,14 @@ vk::raii::CommandBuffer tVulkanDevice::beginSingleTimeCommands() const
     return commandBuffer;
 }
 
-void tVulkanDevice::endSingleTimeCommands(vk::raii::CommandBuffer &commandBuffer) const
+void tVulkanDevice::endSingleTimeCommands(vk::raii::CommandBuffer &commandBuffer, const tQueueType queue) const
 {
     spdlog::trace("tVulkanDevice: Ending single time command...");
     commandBuffer.end();
+    if (queue == tQueueType::Compute)
+    {
+        Uploader->flush();
+    }
     vk::CommandBufferSubmitInfo cbsi{};
     cbsi.commandBuffer = commandBuffer;
 
@@ -59,8 +80,14 @@ void tVulkanDevice::endSingleTimeCommands(vk::raii::CommandBuffer &commandBuffer
     si.commandBufferInfoCount = 1;
     si.pCommandBufferInfos = &cbsi;
 
-    Queue.submit2(si);
-    Queue.waitIdle();
+    // Waiting on a fence rather than the queue leaves frames in flight on it alone.
+    const vk::raii::Fence fence{Device, vk::FenceCreateInfo{}};
+    const auto &target = queue == tQueueType::Graphics ? Queue : ComputeQueue;
+    target.submit2(si, *fence);
+    if (Device.waitForFences(*fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("tVulkanDevice: Waiting for single time command failed");
+    }
     commandBuffer.clear();
     spdlog::trace("tVulkanDevice: Ended single time command");
 }
@@ -177,13 +204,61 @@ void tVulkanDevice::pickPhysicalDevice(const vk::raii::Instance &instance)
     throw std::runtime_error("No suitable GPU with GRAPHICS+COMPUTE+PRESENT found.");
 }
 
+void tVulkanDevice::pickComputeQueueFamily()
+{
+    ComputeQueueFamily = QueueFamily;
+    if (!AsyncComputeEnabled)
+    {
+        spdlog::info("tVulkanDevice: Async compute disabled, simulation runs on the graphics queue");
+        return;
+    }
+
+    const auto queueFamilies = PhysicalDevice.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i)
+    {
+        const auto flags = queueFamilies[i].queueFlags;
+        if ((flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics))
+        {
+            ComputeQueueFamily = i;
+            spdlog::info("tVulkanDevice: Using compute-only family {} for the simulation", i);
+            return;
+        }
+    }
+    spdlog::info("tVulkanDevice: No compute-only queue family, simulation runs on the graphics queue");
+}
+
+void tVulkanDevice::pickTransferQueueFamily()
+{
+    TransferQueueFamily = ComputeQueueFamily;
+    const auto queueFamilies = PhysicalDevice.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i)
+    {
+        const auto flags = queueFamilies[i].queueFlags;
+        if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics) &&
+            !(flags & vk::QueueFlagBits::eCompute))
+        {
+            TransferQueueFamily = i;
+            spdlog::info("tVulkanDevice: Using transfer-only family {} for uploads", i);
+            return;
+        }
+    }
+    spdlog::info("tVulkanDevice: No transfer-only queue family, uploads run on the compute queue");
+}
+
 void tVulkanDevice::createLogicalDevice()
 {
     spdlog::info("tVulkanDevice: Creating logical device...");
     float priority = 1.0f;
 
-    vk::DeviceQueueCreateInfo qci;
-    qci.setQueueFamilyIndex(QueueFamily).setQueueCount(1).setPQueuePriorities(&priority);
+    std::vector qcis{vk::DeviceQueueCreateInfo{{}, QueueFamily, 1, &priority}};
+    if (hasAsyncCompute())
+    {
+        qcis.emplace_back(vk::DeviceQueueCreateFlags{}, ComputeQueueFamily, 1, &priority);
+    }
+    if (hasTransferQueue())
+    {
+        qcis.emplace_back(vk::DeviceQueueCreateFlags{}, TransferQueueFamily, 1, &priority);
+    }
 
     vk::DeviceCreateInfo dci{};
     vk::PhysicalDeviceMeshShaderFeaturesEXT msf{};
@@ -201,22 +276,59 @@ void tVulkanDevice::createLogicalDevice()
     drf.pNext = &s2f;
     m4f.pNext = &drf;
     bdaf.pNext = &m4f;
-    dci.setQueueCreateInfos(qci).setPEnabledExtensionNames(DEVICE_EXTENSIONS);
+    // VK_EXT_memory_budget is optional; without it the allocator estimates the budget from its own blocks.
+    std::vector<const char *> extensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+    for (const auto &extension : PhysicalDevice.enumerateDeviceExtensionProperties())
+    {
+        if (std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+        {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            MemoryBudgetEnabled = true;
+        }
+    }
+    dci.setQueueCreateInfos(qcis).setPEnabledExtensionNames(extensions);
     dci.pNext = &bdaf;
 
     Device = vk::raii::Device(PhysicalDevice, dci);
     Queue = Device.getQueue(QueueFamily, 0);
+    ComputeQueue = Device.getQueue(ComputeQueueFamily, 0);
+    TransferQueue = Device.getQueue(TransferQueueFamily, 0);
     spdlog::info("tVulkanDevice: Created logical device");
 }
 
+void tVulkanDevice::createPipelineCache()
+{
+    spdlog::info("tVulkanDevice: Creating pipeline cache...");
+    const auto path = PipelineCachePersisted ? tPipelineCache::getDefaultPath(PhysicalDevice.getProperties())
+                                             : std::filesystem::path{};
+    PipelineCache = std::make_unique<tPipelineCache>(PhysicalDevice, Device, path);
+    spdlog::info("tVulkanDevice: Pipeline cache created ({})", PipelineCache->wasLoaded() ? "warm" : "cold");
+}
+
 void tVulkanDevice::createCommandPool()
 {
     spdlog::info("tVulkanDevice: Creating command pool...");
     vk::CommandPoolCreateInfo cpci({vk::CommandPoolCreateFlagBits::eResetCommandBuffer}, QueueFamily);
     CommandPool = vk::raii::CommandPool(Device, cpci);
+    cpci.queueFamilyIndex = ComputeQueueFamily;
+    ComputeCommandPool = vk::raii::CommandPool(Device, cpci);
     spdlog::info("tVulkanDevice: Command pool created");
 }
 
+void tVulkanDevice::createAllocator()
+{
+    spdlog::info("tVulkanDevice: Creating memory allocator...");
+    Allocator = std::make_unique<tMemoryAllocator>(PhysicalDevice, Device, MemoryBudgetEnabled);
+    spdlog::info("tVulkanDevice: Memory allocator created");
+}
+
+void tVulkanDevice::createUploader()
+{
+    spdlog::info("tVulkanDevice: Creating uploader...");
+    Uploader = std::make_unique<tUploader>(*this);
+    spdlog::info("tVulkanDevice: Uploader created");
+}
+
 void tVulkanDevice::initTracyContext()
 {
 #if defined(TRACY_ENABLE)
@@ -230,6 +342,21 @@ void tVulkanDevice::initTracyContext()
         constexpr char name[] = "MainQueue";
         TracyVkContextName(TracyContext, name, sizeof(name) - 1);
     }
+
+    ComputeTracyContext = TracyContext;
+    if (hasAsyncCompute())
+    {
+        vk::CommandBufferAllocateInfo computeCbai(*ComputeCommandPool, vk::CommandBufferLevel::ePrimary, 1);
+        vk::raii::CommandBuffers computeCommandBuffers(Device, computeCbai);
+        ComputeTracyCommandBuffer = std::move(computeCommandBuffers[0]);
+
+        ComputeTracyContext = TracyVkContext(*PhysicalDevice, *Device, *ComputeQueue, *ComputeTracyCommandBuffer);
+        if (ComputeTracyContext != nullptr)
+        {
+            constexpr char name[] = "ComputeQueue";
+            TracyVkContextName(ComputeTracyContext, name, sizeof(name) - 1);
+        }
+    }
 #endif
 }
 
@@ -0,0 +1,47 @@
+#include "helpers/barriers.h"
+
+void recordComputeBarrier(const vk::raii::CommandBuffer &commandBuffer)
+{
+    const vk::MemoryBarrier2 barrier{vk::PipelineStageFlagBits2::eComputeShader,
+                                     vk::AccessFlagBits2::eShaderWrite,
+                                     vk::PipelineStageFlagBits2::eComputeShader,
+                                     vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(barrier));
+}
+
+void recordComputeToIndirectBarrier(const vk::raii::CommandBuffer &commandBuffer)
+{
+    const auto dstStages = vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader;
+    const auto dstAccess = vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderRead |
+                           vk::AccessFlagBits2::eShaderWrite;
+    const vk::MemoryBarrier2 barrier{
+        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderWrite, dstStages, dstAccess};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(barrier));
+}
+
+void recordTransferToComputeBarrier(const vk::raii::CommandBuffer &commandBuffer)
+{
+    const vk::MemoryBarrier2 barrier{vk::PipelineStageFlagBits2::eTransfer,
+                                     vk::AccessFlagBits2::eTransferWrite,
+                                     vk::PipelineStageFlagBits2::eComputeShader,
+                                     vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(barrier));
+}
+
+void recordComputeToTransferBarrier(const vk::raii::CommandBuffer &commandBuffer)
+{
+    const vk::MemoryBarrier2 barrier{vk::PipelineStageFlagBits2::eComputeShader,
+                                     vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+                                     vk::PipelineStageFlagBits2::eTransfer,
+                                     vk::AccessFlagBits2::eTransferWrite};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(barrier));
+}
+
+void recordComputeToHostBarrier(const vk::raii::CommandBuffer &commandBuffer)
+{
+    const vk::MemoryBarrier2 barrier{vk::PipelineStageFlagBits2::eComputeShader,
+                                     vk::AccessFlagBits2::eShaderWrite,
+                                     vk::PipelineStageFlagBits2::eHost,
+                                     vk::AccessFlagBits2::eHostRead};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(barrier));
+}
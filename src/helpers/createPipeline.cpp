@@ -0,0 +1,14 @@
+#include "helpers/createPipeline.h"
+
+#include "helpers/loadShaders.h"
+
+vk::raii::Pipeline createComputePipeline(const vk::raii::Device &device,
+                                         const vk::raii::PipelineCache &cache,
+                                         const vk::raii::PipelineLayout &layout,
+                                         const std::string &shaderFileName)
+{
+    const auto shader = loadShaderModule(device, shaderFileName);
+    vk::PipelineShaderStageCreateInfo stageInfo({}, vk::ShaderStageFlagBits::eCompute, shader, "main");
+    vk::ComputePipelineCreateInfo cpci({}, stageInfo, layout);
+    return device.createComputePipeline(cache, cpci);
+}
@@ -1,23 +1,44 @@
 #include "helpers/memoryAllocation.h"
 
-vk::MemoryAllocateInfo getMemoryAllocateInfo(const vk::raii::PhysicalDevice &PhysicalDevice,
-                                             vk::MemoryRequirements memoryRequirements,
-                                             vk::MemoryPropertyFlags requirementsMask,
-                                             const void *pNext)
+#include <algorithm>
+#include <bit>
+
+std::vector<uint32_t> rankMemoryTypes(const vk::PhysicalDeviceMemoryProperties &memoryProperties,
+                                      const uint32_t memoryTypeBits,
+                                      const vk::MemoryPropertyFlags required,
+                                      const vk::MemoryPropertyFlags preferred)
 {
-    auto memoryTypeBits = memoryRequirements.memoryTypeBits;
-    const auto memoryProperties = PhysicalDevice.getMemoryProperties();
-    uint32_t ixType = UINT32_MAX;
-    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    const vk::MemoryPropertyFlags special =
+        vk::MemoryPropertyFlagBits::eLazilyAllocated | vk::MemoryPropertyFlagBits::eProtected;
+    const vk::MemoryPropertyFlags wanted = required | preferred;
+
+    struct tCandidate
+    {
+        uint32_t Index;
+        bool Preferred;
+        int Extra;
+    };
+    std::vector<tCandidate> candidates;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
     {
-        if ((memoryTypeBits & 1) &&
-            ((memoryProperties.memoryTypes[i].propertyFlags & requirementsMask) == requirementsMask))
-        {
-            ixType = i;
-            break;
-        }
-        memoryTypeBits >>= 1;
+        const auto flags = memoryProperties.memoryTypes[i].propertyFlags;
+        if (!(memoryTypeBits & (1u << i)) || (flags & required) != required || (flags & special & ~required))
+            continue;
+        const auto extra = static_cast<uint32_t>(flags & ~wanted);
+        candidates.push_back({i, (flags & preferred) == preferred, std::popcount(extra)});
     }
 
-    return {memoryRequirements.size, ixType, pNext};
+    std::stable_sort(candidates.begin(), candidates.end(), [](const tCandidate &a, const tCandidate &b) {
+        if (a.Preferred != b.Preferred)
+            return a.Preferred;
+        return a.Extra < b.Extra;
+    });
+
+    std::vector<uint32_t> ranked;
+    ranked.reserve(candidates.size());
+    for (const auto &candidate : candidates)
+    {
+        ranked.push_back(candidate.Index);
+    }
+    return ranked;
 }
@@ -1,6 +1,11 @@
+#include <chrono>
 #include <cstdlib>
+#include <string_view>
 
 #include "loggerConfig.h"
+#include "sim/initialParticles.h"
+#include "sim/tCpuBarnesHut.h"
+#include "sim/tCpuPhysics.h"
 #include "tApp.h"
 
 void initLogging()
@@ -10,10 +15,92 @@ void initLogging()
     spdlog::set_level(logLevel);
 }
 
-int main()
+// Headless run of the CPU backend for machines without a Vulkan device, e.g. `vulkan-compute --cpu 100`.
+int runCpu(const uint32_t steps)
+{
+    tCpuPhysics physics{};
+    physics.updateParams({1e-3f});
+    double interactionsPerSecond = 0.0;
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+        physics.step();
+        interactionsPerSecond += physics.getInteractionsPerSecond();
+    }
+    spdlog::info("main: {} CPU steps of {} particles on {} threads, {:.3e} pair interactions/s",
+                 steps,
+                 physics.getCount(),
+                 physics.getThreadCount(),
+                 steps > 0 ? interactionsPerSecond / steps : 0.0);
+    return EXIT_SUCCESS;
+}
+
+// Initial model by name, the shell for anything else.
+tInitialConditions::tModel parseModel(const std::string_view name)
+{
+    using tModel = tInitialConditions::tModel;
+    if (name == "plummer")
+        return tModel::Plummer;
+    if (name == "hernquist")
+        return tModel::Hernquist;
+    if (name == "disk")
+        return tModel::Disk;
+    if (name == "merger")
+        return tModel::Merger;
+    if (name == "lattice")
+        return tModel::Lattice;
+    return tModel::Shell;
+}
+
+// Headless Barnes-Hut run for large particle counts, e.g. `vulkan-compute --cpu-tree 10 1000000 merger`.
+int runCpuTree(const uint32_t steps, const uint32_t count, const tInitialConditions &conditions)
+{
+    const auto generationStart = std::chrono::steady_clock::now();
+    auto particles = createInitialParticles(count, conditions);
+    const std::chrono::duration<double> generation = std::chrono::steady_clock::now() - generationStart;
+    spdlog::info("main: Generated {} initial particles in {:.3f} s", count, generation.count());
+    tCpuBarnesHut tree{};
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+        tree.step(particles, 1e-3f);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info("main: {} Barnes-Hut steps of {} particles on {} threads, {:.3f} s per step",
+                 steps,
+                 count,
+                 tree.getThreadCount(),
+                 steps > 0 ? elapsed.count() / steps : 0.0);
+    return EXIT_SUCCESS;
+}
+
+uint32_t parseArgument(const int argc, char **argv, const int index, const uint32_t fallback)
+{
+    return argc > index ? static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10)) : fallback;
+}
+
+int main(int argc, char **argv)
 {
     initLogging();
 
+    const std::string_view mode = argc > 1 ? argv[1] : "";
+    if (mode == "--cpu" || mode == "--cpu-tree")
+    {
+        try
+        {
+            if (mode == "--cpu")
+                return runCpu(parseArgument(argc, argv, 2, 100));
+            tInitialConditions conditions{};
+            conditions.Model = parseModel(argc > 4 ? argv[4] : "");
+            return runCpuTree(
+                parseArgument(argc, argv, 2, 10), parseArgument(argc, argv, 3, NUM_PARTICLES), conditions);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::critical("main: CPU run failed: {}", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
     tApp app{};
 
     try
@@ -28,4 +115,4 @@ int main()
 
     spdlog::info("main: Exited app successully");
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
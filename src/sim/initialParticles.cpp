@@ -0,0 +1,252 @@
+#include "sim/initialParticles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include <glm/glm.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "sim/tPhilox.h"
+#include "sim/tThreadPool.h"
+
+namespace
+{
+// Same constant as the force kernels.
+constexpr double Gravity = 1e-5;
+// Particles per parallelFor chunk; generation is a few hundred flops per particle, so chunks stay short.
+constexpr size_t ChunkSize = 16384;
+
+using tModel = tInitialConditions::tModel;
+
+glm::dvec3 isotropic(tPhilox &rng, const double length)
+{
+    const double z = 2.0 * rng.nextFloat() - 1.0;
+    const double phi = 2.0 * std::numbers::pi * rng.nextFloat();
+    const double s = std::sqrt(std::max(1.0 - z * z, 0.0));
+    return length * glm::dvec3(s * std::cos(phi), s * std::sin(phi), z);
+}
+
+// Box-Muller, one of the pair per call so the draws per particle stay easy to mirror on the GPU.
+double gaussian(tPhilox &rng)
+{
+    const double u = rng.nextFloatOpen();
+    const double v = rng.nextFloat();
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * std::numbers::pi * v);
+}
+
+glm::dvec3 rotateX(const glm::dvec3 &v, const double angle)
+{
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    return {v.x, c * v.y - s * v.z, s * v.y + c * v.z};
+}
+
+// The models below are mirrored draw for draw by initialParticles.comp; keep the two in sync.
+struct tState
+{
+    glm::dvec3 Position;
+    glm::dvec3 Velocity;
+};
+
+tState shell(tPhilox &rng)
+{
+    const double x = 2.0 * rng.nextFloat() - 1.0;
+    const double y = 2.0 * rng.nextFloat() - 1.0;
+    const double z = 2.0 * rng.nextFloat() - 1.0;
+    const glm::dvec3 position = glm::normalize(glm::dvec3(x * 2.0, y * 1.4, z)) * 2.0;
+    const glm::dvec3 velocity = glm::normalize(glm::cross(position, glm::dvec3(0.9, 2.0, 0.7))) * 0.2;
+    return {position, velocity};
+}
+
+// Aarseth, Henon & Wielen (1974): radius from the inverse cumulative mass, speed by rejection from the distribution
+// function g(q) = q^2 (1 - q^2)^3.5 in units of the local escape speed.
+tState plummer(tPhilox &rng, const tInitialConditions &conditions, const double mass)
+{
+    const double a = conditions.ScaleRadius;
+    const double rMax = conditions.TruncationRadius * a;
+    double r = 0.0;
+    do
+    {
+        const double m = rng.nextFloatOpen();
+        r = a / std::sqrt(std::pow(m, -2.0 / 3.0) - 1.0);
+    } while (r > rMax);
+
+    double q = 0.0;
+    for (;;)
+    {
+        q = rng.nextFloat();
+        const double g = 0.1 * rng.nextFloat();
+        if (g < q * q * std::pow(1.0 - q * q, 3.5))
+            break;
+    }
+    const double escape = std::sqrt(2.0 * Gravity * mass / std::sqrt(r * r + a * a));
+    return {isotropic(rng, r), isotropic(rng, q * escape)};
+}
+
+// 12 a sigma^2 / (G M) of the Hernquist sphere at r = x a. Beyond the scale radius the closed form is a difference
+// of two terms growing like x^3 and loses every digit in single precision; there it is summed as
+// 12 x u^2 sum_j u^j / (j + 5) with u = 1 / (1 + x) instead, the series left after the cancelling terms.
+double hernquistJeans(const double x)
+{
+    if (x < 1.0)
+        return 12.0 * x * std::pow(1.0 + x, 3.0) * std::log(1.0 + 1.0 / x) -
+               x / (1.0 + x) * (25.0 + 52.0 * x + 42.0 * x * x + 12.0 * x * x * x);
+
+    const double u = 1.0 / (1.0 + x);
+    double sum = 0.0;
+    for (int j = 39; j >= 0; --j)
+    {
+        sum = sum * u + 1.0 / (j + 5);
+    }
+    return 12.0 * x * u * u * sum;
+}
+
+// Hernquist (1990): radius from M(r) = M r^2 / (r + a)^2, Gaussian velocities of the isotropic Jeans dispersion,
+// eq. 10, redrawn above the escape speed.
+tState hernquist(tPhilox &rng, const tInitialConditions &conditions, const double mass)
+{
+    const double a = conditions.ScaleRadius;
+    const double rMax = conditions.TruncationRadius * a;
+    double r = 0.0;
+    do
+    {
+        const double s = std::sqrt(static_cast<double>(rng.nextFloatOpen()));
+        r = a * s / (1.0 - s);
+    } while (r > rMax);
+
+    const double sigma = std::sqrt(std::max(Gravity * mass / (12.0 * a) * hernquistJeans(r / a), 0.0));
+    const double escape = std::sqrt(2.0 * Gravity * mass / (r + a));
+    glm::dvec3 velocity;
+    do
+    {
+        velocity = sigma * glm::dvec3(gaussian(rng), gaussian(rng), gaussian(rng));
+    } while (glm::length(velocity) >= escape);
+    return {isotropic(rng, r), velocity};
+}
+
+// Radius in units of the scale length is Gamma(2)-distributed, the sum of two exponentials; the height inverts the
+// sech^2 cumulative tanh.
+tState disk(tPhilox &rng, const tInitialConditions &conditions, const double mass, const double inclination)
+{
+    const double scale = conditions.ScaleRadius;
+    const double xMax = conditions.TruncationRadius;
+    double x = 0.0;
+    do
+    {
+        x = -std::log(static_cast<double>(rng.nextFloatOpen())) - std::log(static_cast<double>(rng.nextFloatOpen()));
+    } while (x > xMax);
+    const double radius = x * scale;
+    const double height =
+        conditions.DiskScaleHeight * std::atanh(2.0 * static_cast<double>(rng.nextFloatOpen()) - 1.0);
+    const double phi = 2.0 * std::numbers::pi * rng.nextFloat();
+
+    // Enclosed mass of the truncated disk, treated as spherical for the circular speed.
+    const double enclosed = mass * (1.0 - (1.0 + x) * std::exp(-x)) / (1.0 - (1.0 + xMax) * std::exp(-xMax));
+    const double circular = std::sqrt(Gravity * enclosed / std::max(radius, 1e-6 * scale));
+    const double dispersion = conditions.DiskDispersion * circular;
+
+    const glm::dvec3 position{radius * std::cos(phi), radius * std::sin(phi), height};
+    const glm::dvec3 velocity =
+        glm::dvec3(-circular * std::sin(phi), circular * std::cos(phi), 0.0) +
+        dispersion * glm::dvec3(gaussian(rng), gaussian(rng), gaussian(rng));
+    return {rotateX(position, inclination), rotateX(velocity, inclination)};
+}
+
+// Particles [0, count / 2) form the first galaxy. The two centres start on a parabolic orbit about their common
+// centre of mass: relative position (sqrt(d^2 - b^2), b, 0), relative velocity sqrt(2 G M / d) along -x.
+tState merger(tPhilox &rng,
+              const tInitialConditions &conditions,
+              const uint32_t index,
+              const uint32_t count,
+              const double particleMass)
+{
+    const uint32_t firstCount = count / 2;
+    const double firstMass = firstCount * particleMass;
+    const double secondMass = (count - firstCount) * particleMass;
+    const double totalMass = firstMass + secondMass;
+
+    const double separation = conditions.MergerSeparation;
+    const double impact = std::min<double>(conditions.MergerImpactParameter, separation);
+    const glm::dvec3 relativePosition{std::sqrt(separation * separation - impact * impact), impact, 0.0};
+    const glm::dvec3 relativeVelocity{-std::sqrt(2.0 * Gravity * totalMass / separation), 0.0, 0.0};
+
+    const bool second = index >= firstCount;
+    const double galaxyMass = second ? secondMass : firstMass;
+    const double inclination = conditions.DiskInclination + (second ? conditions.MergerInclination : 0.f);
+    // Each centre sits at its partner's mass fraction of the relative vector from the centre of mass.
+    const double offset = second ? firstMass / totalMass : -secondMass / totalMass;
+
+    auto state = disk(rng, conditions, galaxyMass, inclination);
+    state.Position += offset * relativePosition;
+    state.Velocity += offset * relativeVelocity;
+    return state;
+}
+
+// Sites per axis of the smallest cube holding count sites.
+uint32_t latticeSide(const uint32_t count)
+{
+    auto n = static_cast<uint64_t>(std::cbrt(static_cast<double>(count)));
+    while (n * n * n < count)
+        ++n;
+    while (n > 1 && (n - 1) * (n - 1) * (n - 1) >= count)
+        --n;
+    return static_cast<uint32_t>(n);
+}
+
+tState lattice(const tInitialConditions &conditions, const uint32_t index, const uint32_t side)
+{
+    const glm::dvec3 site(index % side, index / side % side, index / side / side);
+    const double spacing = static_cast<double>(conditions.ScaleRadius) / side;
+    return {(site + 0.5) * spacing - 0.5 * conditions.ScaleRadius, glm::dvec3(0.0)};
+}
+} // namespace
+
+std::vector<tParticle> createInitialParticles(const uint32_t count)
+{
+    return createInitialParticles(count, tInitialConditions{});
+}
+
+std::vector<tParticle> createInitialParticles(const uint32_t count,
+                                              const tInitialConditions &conditions,
+                                              const uint32_t threadCount)
+{
+    ZoneScopedN("createInitialParticles()");
+    std::vector<tParticle> particles(count);
+    const double mass = static_cast<double>(count) * conditions.ParticleMass;
+    const uint32_t side = latticeSide(count);
+
+    tThreadPool pool{threadCount};
+    pool.parallelFor(0, count, ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto index = static_cast<uint32_t>(i);
+            tPhilox rng{conditions.Seed, index};
+            tState state;
+            switch (conditions.Model)
+            {
+            case tModel::Plummer:
+                state = plummer(rng, conditions, mass);
+                break;
+            case tModel::Hernquist:
+                state = hernquist(rng, conditions, mass);
+                break;
+            case tModel::Disk:
+                state = disk(rng, conditions, mass, conditions.DiskInclination);
+                break;
+            case tModel::Merger:
+                state = merger(rng, conditions, index, count, conditions.ParticleMass);
+                break;
+            case tModel::Lattice:
+                state = lattice(conditions, index, side);
+                break;
+            default:
+                state = shell(rng);
+                break;
+            }
+            particles[i].Position = glm::vec4(glm::vec3(state.Position), conditions.ParticleMass);
+            particles[i].Velocity = glm::vec4(glm::vec3(state.Velocity), 0.f);
+        }
+    });
+    return particles;
+}
@@ -0,0 +1,155 @@
+#include "sim/tBarnesHut.h"
+
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct BarnesHutPushConstants
+{
+    vk::DeviceAddress keys;
+    vk::DeviceAddress values;
+    vk::DeviceAddress bounds;
+    vk::DeviceAddress children;
+    vk::DeviceAddress parents;
+    vk::DeviceAddress nodeMass;
+    vk::DeviceAddress boxMin;
+    vk::DeviceAddress boxMax;
+    vk::DeviceAddress visitCounts;
+    uint32_t numParticles;
+    float openingAngle;
+    vk::DeviceAddress accelerations;
+    vk::DeviceAddress activeIndices;
+    vk::DeviceAddress activeCount;
+    uint32_t useActiveList;
+    uint32_t pad0;
+};
+
+// Bounds are stored as order-preserving uints: min xyz at [0, 3), max xyz at [4, 7).
+constexpr vk::DeviceSize BoundsHalfSize = 4 * sizeof(uint32_t);
+} // namespace
+
+tBarnesHut::tBarnesHut(const tVulkanDevice &device,
+                       const vk::raii::DescriptorSetLayout &descriptorLayout,
+                       const uint32_t numParticles)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      NumParticles(numParticles), NumNodes(2 * numParticles - 1)
+{
+    spdlog::info("tBarnesHut: Initializing for {} particles...", NumParticles);
+    createBuffers();
+    createPipelines(descriptorLayout);
+    Sort = std::make_unique<tRadixSort>(Device, NumParticles);
+    spdlog::info("tBarnesHut: Initialized");
+}
+
+void tBarnesHut::recordBarnesHutPass(const vk::raii::CommandBuffer &commandBuffer,
+                                     const vk::raii::DescriptorSet &set,
+                                     const vk::DeviceAddress accelerations,
+                                     const tActiveList &active) const
+{
+    ZoneScopedN("tBarnesHut: recordBarnesHutPass()");
+    spdlog::trace("tBarnesHut: Recording Barnes-Hut pass...");
+    TracyVkNamedZone(TracyContext, tracyBarnesHutZone, *commandBuffer, "Barnes-Hut", true);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.fillBuffer(*Bounds.Buffer, 0, BoundsHalfSize, 0xFFFFFFFFu);
+    commandBuffer.fillBuffer(*Bounds.Buffer, BoundsHalfSize, BoundsHalfSize, 0u);
+    commandBuffer.fillBuffer(*VisitCounts.Buffer, 0, VK_WHOLE_SIZE, 0u);
+    recordTransferToComputeBarrier(commandBuffer);
+
+    dispatch(commandBuffer, BoundsPipeline, set, NumParticles, LocalSize, accelerations, {});
+    recordComputeBarrier(commandBuffer);
+    dispatch(commandBuffer, MortonPipeline, set, NumParticles, LocalSize, accelerations, {});
+    recordComputeBarrier(commandBuffer);
+
+    Sort->recordSort(commandBuffer, Keys.Address, Values.Address, NumParticles, MortonBits);
+
+    dispatch(commandBuffer, BuildPipeline, set, NumParticles - 1, LocalSize, accelerations, {});
+    recordComputeBarrier(commandBuffer);
+    dispatch(commandBuffer, SummarizePipeline, set, NumParticles, LocalSize, accelerations, {});
+    recordComputeBarrier(commandBuffer);
+    dispatch(commandBuffer, ForcePipeline, set, NumParticles, ForceLocalSize, accelerations, active);
+    spdlog::trace("tBarnesHut: Recorded Barnes-Hut pass");
+}
+
+void tBarnesHut::createBuffers()
+{
+    spdlog::info("tBarnesHut: Creating buffers...");
+    const uint32_t numInternal = std::max(NumParticles - 1, 1u);
+    Keys = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tBarnesHut");
+    Values = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tBarnesHut");
+    Bounds = createStorageBuffer(Device, 2 * BoundsHalfSize, "tBarnesHut");
+    Children = createStorageBuffer(Device, numInternal * sizeof(glm::uvec2), "tBarnesHut");
+    Parents = createStorageBuffer(Device, NumNodes * sizeof(uint32_t), "tBarnesHut");
+    NodeMass = createStorageBuffer(Device, NumNodes * sizeof(glm::vec4), "tBarnesHut");
+    BoxMin = createStorageBuffer(Device, NumNodes * sizeof(glm::vec4), "tBarnesHut");
+    BoxMax = createStorageBuffer(Device, NumNodes * sizeof(glm::vec4), "tBarnesHut");
+    VisitCounts = createStorageBuffer(Device, numInternal * sizeof(uint32_t), "tBarnesHut");
+    spdlog::info("tBarnesHut: Buffers created");
+}
+
+void tBarnesHut::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tBarnesHut: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(BarnesHutPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    BoundsPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "bhBounds.comp.spv");
+    MortonPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "bhMorton.comp.spv");
+    BuildPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "bhBuild.comp.spv");
+    SummarizePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "bhSummarize.comp.spv");
+    ForcePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "bhForce.comp.spv");
+    spdlog::info("tBarnesHut: Compute pipelines created");
+}
+
+void tBarnesHut::dispatch(const vk::raii::CommandBuffer &commandBuffer,
+                          const vk::raii::Pipeline &pipeline,
+                          const vk::raii::DescriptorSet &set,
+                          const uint32_t count,
+                          const uint32_t localSize,
+                          const vk::DeviceAddress accelerations,
+                          const tActiveList &active) const
+{
+    if (count == 0)
+        return;
+
+    // The radix sort binds its own layout in between, so set and push constants are re-bound every time.
+    const BarnesHutPushConstants pc{Keys.Address,
+                                    Values.Address,
+                                    Bounds.Address,
+                                    Children.Address,
+                                    Parents.Address,
+                                    NodeMass.Address,
+                                    BoxMin.Address,
+                                    BoxMax.Address,
+                                    VisitCounts.Address,
+                                    NumParticles,
+                                    OpeningAngle,
+                                    accelerations,
+                                    active.Indices,
+                                    active.Count,
+                                    active.isAll() ? 0u : 1u,
+                                    0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PipelineLayout, 0, *set, {});
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    if (active.isAll())
+    {
+        commandBuffer.dispatch((count + localSize - 1) / localSize, 1, 1);
+    }
+    else
+    {
+        commandBuffer.dispatchIndirect(active.Dispatch, active.DispatchOffset);
+    }
+}
@@ -0,0 +1,169 @@
+#include "sim/tBlockTimesteps.h"
+
+#include <algorithm>
+#include <bit>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct KickPushConstants
+{
+    vk::DeviceAddress accelerations;
+    vk::DeviceAddress levels;
+    vk::DeviceAddress activeIndices;
+    vk::DeviceAddress activeCount;
+    vk::DeviceAddress renderStream;
+    uint32_t useActiveList;
+    uint32_t kickFlags;
+    uint32_t syncTime;
+    uint32_t maxLevel;
+    float accuracy;
+    uint32_t writeRenderStream;
+};
+
+struct CompactPushConstants
+{
+    vk::DeviceAddress levels;
+    vk::DeviceAddress offsets;
+    vk::DeviceAddress activeIndices;
+    vk::DeviceAddress dispatch;
+    vk::DeviceAddress particleCount;
+    uint32_t numParticles;
+    uint32_t minLevel;
+    uint32_t pad0;
+    uint32_t pad1;
+};
+
+// The active count sits at the start of the dispatch buffer, the vk::DispatchIndirectCommand 16 bytes in.
+constexpr vk::DeviceSize DispatchArgsOffset = 4 * sizeof(uint32_t);
+constexpr vk::DeviceSize DispatchBufferSize = 8 * sizeof(uint32_t);
+} // namespace
+
+tBlockTimesteps::tBlockTimesteps(const tVulkanDevice &device,
+                                 const vk::raii::DescriptorSetLayout &descriptorLayout,
+                                 const uint32_t numParticles,
+                                 const tParams &params)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      NumParticles(numParticles)
+{
+    spdlog::info("tBlockTimesteps: Initializing...");
+    setParams(params);
+    createBuffers();
+    createPipelines(descriptorLayout);
+    Scan = std::make_unique<tPrefixScan>(Device, NumParticles);
+    spdlog::info("tBlockTimesteps: Initialized");
+}
+
+void tBlockTimesteps::setParams(const tParams &params)
+{
+    Params = params;
+    Params.Levels = std::clamp(Params.Levels, 1u, MaxLevels);
+}
+
+void tBlockTimesteps::recordKick(const vk::raii::CommandBuffer &commandBuffer,
+                                 const vk::raii::DescriptorSet &set,
+                                 const vk::DeviceAddress accelerations,
+                                 const uint32_t syncTime,
+                                 const uint32_t kickFlags,
+                                 const tActiveList &active,
+                                 const vk::DeviceAddress renderStream) const
+{
+    ZoneScopedN("tBlockTimesteps: recordKick()");
+    TracyVkNamedZone(TracyContext, tracyBlockKickZone, *commandBuffer, "Block Kick", true);
+    const KickPushConstants pc{accelerations,
+                               Levels.Address,
+                               active.Indices,
+                               active.Count,
+                               renderStream,
+                               active.isAll() ? 0u : 1u,
+                               kickFlags,
+                               syncTime,
+                               Params.Levels - 1,
+                               Params.Accuracy,
+                               renderStream != 0 ? 1u : 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *KickPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, KickPipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, KickPipelineLayout, 0, *set, {});
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatchIndirect(active.Dispatch, active.DispatchOffset);
+}
+
+tActiveList tBlockTimesteps::recordCompaction(const vk::raii::CommandBuffer &commandBuffer,
+                                              const uint32_t syncTime,
+                                              const tActiveList &live) const
+{
+    ZoneScopedN("tBlockTimesteps: recordCompaction()");
+    TracyVkNamedZone(TracyContext, tracyCompactionZone, *commandBuffer, "Active List Compaction", true);
+    const CompactPushConstants pc{Levels.Address,
+                                  Offsets.Address,
+                                  ActiveIndices.Address,
+                                  Dispatch.Address,
+                                  live.Count,
+                                  NumParticles,
+                                  minActiveLevel(syncTime, Params.Levels - 1),
+                                  0u,
+                                  0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *CompactPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    const uint32_t groups = (NumParticles + LocalSize - 1) / LocalSize;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FlagsPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+
+    Scan->recordScan(commandBuffer, Offsets.Address, NumParticles);
+
+    // The scan binds its own layout, so push constants are re-pushed.
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, CompactPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeToIndirectBarrier(commandBuffer);
+
+    return {ActiveIndices.Address, Dispatch.Address, *Dispatch.Buffer, DispatchArgsOffset};
+}
+
+uint32_t tBlockTimesteps::minActiveLevel(const uint32_t syncTime, const uint32_t maxLevel)
+{
+    // Level k steps every 2^(maxLevel - k) substeps, so it is active when that divides syncTime.
+    const auto alignment = static_cast<uint32_t>(std::countr_zero(syncTime));
+    return maxLevel - std::min(alignment, maxLevel);
+}
+
+void tBlockTimesteps::createBuffers()
+{
+    spdlog::info("tBlockTimesteps: Creating buffers...");
+    Levels = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tBlockTimesteps");
+    Offsets = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tBlockTimesteps");
+    ActiveIndices = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tBlockTimesteps");
+    Dispatch =
+        createStorageBuffer(Device, DispatchBufferSize, "tBlockTimesteps", vk::BufferUsageFlagBits::eIndirectBuffer);
+    // Levels start undefined: tSim always reassigns them from fresh forces before the first block step, so a
+    // resize never has to wait on a fill.
+    spdlog::info("tBlockTimesteps: Buffers created");
+}
+
+void tBlockTimesteps::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tBlockTimesteps: Creating compute pipelines...");
+    vk::PushConstantRange kickRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(KickPushConstants)};
+    vk::PipelineLayoutCreateInfo kickPlci({}, *setLayout, kickRange);
+    KickPipelineLayout = LogicalDevice.createPipelineLayout(kickPlci);
+
+    vk::PushConstantRange compactRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(CompactPushConstants)};
+    vk::PipelineLayoutCreateInfo compactPlci({}, {}, compactRange);
+    CompactPipelineLayout = LogicalDevice.createPipelineLayout(compactPlci);
+
+    const auto &cache = Device.getPipelineCache();
+    KickPipeline = createComputePipeline(LogicalDevice, cache, KickPipelineLayout, "blockKick.comp.spv");
+    FlagsPipeline = createComputePipeline(LogicalDevice, cache, CompactPipelineLayout, "blockFlags.comp.spv");
+    CompactPipeline = createComputePipeline(LogicalDevice, cache, CompactPipelineLayout, "blockCompact.comp.spv");
+    spdlog::info("tBlockTimesteps: Compute pipelines created");
+}
@@ -0,0 +1,151 @@
+#include "sim/tCellGrid.h"
+
+#include <cmath>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct GridPushConstants
+{
+    glm::vec4 origin; // xyz = grid origin, w = 1 / cell size
+    glm::uvec4 dims;  // xyz = cells per axis, w = particle count
+    vk::DeviceAddress cellIds;
+    vk::DeviceAddress cellCount;
+    vk::DeviceAddress cellStart;
+    vk::DeviceAddress cellCursor;
+    vk::DeviceAddress sortedIndices;
+};
+} // namespace
+
+tCellGrid::tCellGrid(const tVulkanDevice &device,
+                     const vk::raii::DescriptorSetLayout &descriptorLayout,
+                     const uint32_t numParticles,
+                     const tParams &params)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      NumParticles(numParticles), Params(params),
+      CellTotal(params.Dimensions.x * params.Dimensions.y * params.Dimensions.z)
+{
+    spdlog::info(
+        "tCellGrid: Initializing {}x{}x{} grid...", Params.Dimensions.x, Params.Dimensions.y, Params.Dimensions.z);
+    createBuffers();
+    createPipelines(descriptorLayout);
+    Scan = std::make_unique<tPrefixScan>(Device, CellTotal);
+    spdlog::info("tCellGrid: Initialized");
+}
+
+void tCellGrid::recordBuildPass(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set) const
+{
+    ZoneScopedN("tCellGrid: recordBuildPass()");
+    spdlog::trace("tCellGrid: Recording grid build...");
+    TracyVkNamedZone(TracyContext, tracyCellGridZone, *commandBuffer, "Cell Grid Build", true);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.fillBuffer(*CellCount.Buffer, 0, VK_WHOLE_SIZE, 0u);
+    commandBuffer.fillBuffer(*CellCursor.Buffer, 0, VK_WHOLE_SIZE, 0u);
+    recordTransferToComputeBarrier(commandBuffer);
+
+    dispatch(commandBuffer, CountPipeline, set);
+
+    const vk::MemoryBarrier2 countToCopy{vk::PipelineStageFlagBits2::eComputeShader,
+                                         vk::AccessFlagBits2::eShaderWrite,
+                                         vk::PipelineStageFlagBits2::eTransfer,
+                                         vk::AccessFlagBits2::eTransferRead};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(countToCopy));
+    commandBuffer.copyBuffer(*CellCount.Buffer, *CellStart.Buffer, vk::BufferCopy{0, 0, CellTotal * sizeof(uint32_t)});
+    recordTransferToComputeBarrier(commandBuffer);
+
+    Scan->recordScan(commandBuffer, CellStart.Address, CellTotal);
+
+    dispatch(commandBuffer, ScatterPipeline, set);
+    recordComputeBarrier(commandBuffer);
+    spdlog::trace("tCellGrid: Recorded grid build");
+}
+
+uint32_t tCellGrid::cellIndex(const glm::vec3 &position, const tParams &params)
+{
+    const float invCellSize = 1.0f / params.CellSize;
+    const glm::vec3 scaled = (position - params.Origin) * invCellSize;
+    const glm::ivec3 cell =
+        glm::clamp(glm::ivec3(glm::floor(scaled)), glm::ivec3(0), glm::ivec3(params.Dimensions) - 1);
+    return static_cast<uint32_t>(cell.x) +
+           params.Dimensions.x * (static_cast<uint32_t>(cell.y) + params.Dimensions.y * static_cast<uint32_t>(cell.z));
+}
+
+tCellGrid::tReference tCellGrid::buildReference(const std::vector<tParticle> &particles, const tParams &params)
+{
+    const uint32_t cellTotal = params.Dimensions.x * params.Dimensions.y * params.Dimensions.z;
+    tReference reference{};
+    reference.CellCount.assign(cellTotal, 0);
+    reference.CellStart.assign(cellTotal, 0);
+    reference.SortedIndices.resize(particles.size());
+
+    std::vector<uint32_t> cellIds(particles.size());
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        cellIds[i] = cellIndex(glm::vec3(particles[i].Position), params);
+        ++reference.CellCount[cellIds[i]];
+    }
+
+    uint32_t running = 0;
+    for (uint32_t c = 0; c < cellTotal; ++c)
+    {
+        reference.CellStart[c] = running;
+        running += reference.CellCount[c];
+    }
+
+    std::vector<uint32_t> cursor(reference.CellStart);
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        reference.SortedIndices[cursor[cellIds[i]]++] = static_cast<uint32_t>(i);
+    }
+    return reference;
+}
+
+void tCellGrid::createBuffers()
+{
+    spdlog::info("tCellGrid: Creating buffers...");
+    CellIds = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tCellGrid");
+    CellCount = createStorageBuffer(Device, CellTotal * sizeof(uint32_t), "tCellGrid");
+    CellStart = createStorageBuffer(Device, CellTotal * sizeof(uint32_t), "tCellGrid");
+    CellCursor = createStorageBuffer(Device, CellTotal * sizeof(uint32_t), "tCellGrid");
+    SortedIndices = createStorageBuffer(Device, NumParticles * sizeof(uint32_t), "tCellGrid");
+    spdlog::info("tCellGrid: Buffers created");
+}
+
+void tCellGrid::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tCellGrid: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(GridPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    CountPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "gridCount.comp.spv");
+    ScatterPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "gridScatter.comp.spv");
+    spdlog::info("tCellGrid: Compute pipelines created");
+}
+
+void tCellGrid::dispatch(const vk::raii::CommandBuffer &commandBuffer,
+                         const vk::raii::Pipeline &pipeline,
+                         const vk::raii::DescriptorSet &set) const
+{
+    const GridPushConstants pc{glm::vec4(Params.Origin, 1.0f / Params.CellSize),
+                               glm::uvec4(Params.Dimensions, NumParticles),
+                               CellIds.Address,
+                               CellCount.Address,
+                               CellStart.Address,
+                               CellCursor.Address,
+                               SortedIndices.Address};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PipelineLayout, 0, *set, {});
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch((NumParticles + LocalSize - 1) / LocalSize, 1, 1);
+}
@@ -0,0 +1,370 @@
+#include "sim/tCpuBarnesHut.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <tracy/Tracy.hpp>
+
+namespace
+{
+// Same constants as bhForce.comp.
+constexpr float Gravity = 1e-5f;
+constexpr float MinDistSqr = 1e-1f;
+constexpr float MaxDistSqr = 1e6f;
+
+// Spreads the low 21 bits of v so that two zero bits follow each of them.
+uint64_t spreadBits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+void accumulate(glm::vec3 &acceleration, const glm::vec4 &self, const glm::vec4 &other)
+{
+    const glm::vec3 dir = glm::vec3(other) - glm::vec3(self);
+    const float distSqr = std::clamp(glm::dot(dir, dir), MinDistSqr, MaxDistSqr);
+    const float invDist = 1.f / std::sqrt(distSqr);
+    acceleration += other.w * dir * (invDist * invDist * invDist);
+}
+} // namespace
+
+tCpuBarnesHut::tCpuBarnesHut(const uint32_t threadCount) : Pool(threadCount)
+{
+    spdlog::info("tCpuBarnesHut: Initialized with {} threads", Pool.getThreadCount());
+}
+
+std::vector<glm::vec3> tCpuBarnesHut::computeAccelerations(const std::vector<tParticle> &particles)
+{
+    ZoneScopedN("tCpuBarnesHut: computeAccelerations()");
+    std::vector<glm::vec3> accelerations(particles.size(), glm::vec3(0.f));
+    if (particles.empty())
+        return accelerations;
+
+    sortParticles(particles);
+    buildTree();
+
+    // Walking in Morton order keeps consecutive walks on the same branches.
+    Pool.parallelFor(0, particles.size(), ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t s = begin; s < end; ++s)
+        {
+            // Free slots have no mass and stay parked where they were killed.
+            if (SortedPositions[s].w > 0.f)
+            {
+                accelerations[Order[s]] = Gravity * walk(static_cast<uint32_t>(s));
+            }
+        }
+    });
+    return accelerations;
+}
+
+void tCpuBarnesHut::step(std::vector<tParticle> &particles, const float deltaTime)
+{
+    ZoneScopedN("tCpuBarnesHut: step()");
+    const auto accelerations = computeAccelerations(particles);
+    Pool.parallelFor(0, particles.size(), ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto &p = particles[i];
+            p.Velocity += glm::vec4(deltaTime * accelerations[i], 0.f);
+            p.Position += glm::vec4(deltaTime * glm::vec3(p.Velocity), 0.f);
+        }
+    });
+}
+
+void tCpuBarnesHut::sortParticles(const std::vector<tParticle> &particles)
+{
+    ZoneScopedN("tCpuBarnesHut: sortParticles()");
+    const size_t count = particles.size();
+
+    // Bounds, one partial box per chunk.
+    const size_t boundChunks = (count + ChunkSize - 1) / ChunkSize;
+    std::vector<glm::vec3> chunkMin(boundChunks, glm::vec3(std::numeric_limits<float>::max()));
+    std::vector<glm::vec3> chunkMax(boundChunks, glm::vec3(std::numeric_limits<float>::lowest()));
+    Pool.parallelFor(0, count, ChunkSize, [&](const size_t begin, const size_t end) {
+        const size_t chunk = begin / ChunkSize;
+        for (size_t i = begin; i < end; ++i)
+        {
+            chunkMin[chunk] = glm::min(chunkMin[chunk], glm::vec3(particles[i].Position));
+            chunkMax[chunk] = glm::max(chunkMax[chunk], glm::vec3(particles[i].Position));
+        }
+    });
+    glm::vec3 lo = chunkMin[0];
+    glm::vec3 hi = chunkMax[0];
+    for (size_t c = 1; c < boundChunks; ++c)
+    {
+        lo = glm::min(lo, chunkMin[c]);
+        hi = glm::max(hi, chunkMax[c]);
+    }
+    // A cube, slightly enlarged so the largest coordinate still quantizes inside it.
+    const glm::vec3 extent = hi - lo;
+    RootMin = lo;
+    RootSize = std::max(std::max(extent.x, std::max(extent.y, extent.z)) * (1.f + 1e-5f), 1e-6f);
+
+    Keys.resize(count);
+    Order.resize(count);
+    KeysScratch.resize(count);
+    OrderScratch.resize(count);
+    const float scale = static_cast<float>(1u << MortonBits) / RootSize;
+    const auto maxCell = static_cast<float>((1u << MortonBits) - 1);
+    Pool.parallelFor(0, count, ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::vec3 q = glm::clamp((glm::vec3(particles[i].Position) - RootMin) * scale, 0.f, maxCell);
+            Keys[i] = spreadBits(static_cast<uint64_t>(q.x)) << 2 | spreadBits(static_cast<uint64_t>(q.y)) << 1 |
+                      spreadBits(static_cast<uint64_t>(q.z));
+            Order[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // LSD radix sort: per-chunk digit histograms, a digit-major scan, then every chunk scatters its keys in order.
+    // Stable, so the result does not depend on the thread count.
+    constexpr uint32_t Buckets = 1u << RadixBits;
+    const size_t chunks = (count + SortChunkSize - 1) / SortChunkSize;
+    std::vector<uint32_t> offsets(chunks * Buckets);
+    for (uint32_t pass = 0; pass < RadixPasses; ++pass)
+    {
+        const uint32_t shift = pass * RadixBits;
+        Pool.parallelFor(0, chunks, 1, [&](const size_t begin, const size_t end) {
+            for (size_t c = begin; c < end; ++c)
+            {
+                uint32_t *histogram = &offsets[c * Buckets];
+                std::fill(histogram, histogram + Buckets, 0u);
+                for (size_t i = c * SortChunkSize; i < std::min(count, (c + 1) * SortChunkSize); ++i)
+                {
+                    ++histogram[(Keys[i] >> shift) & (Buckets - 1)];
+                }
+            }
+        });
+
+        // Skip passes where every key has the same digit, e.g. the top bits of a small box.
+        bool uniform = false;
+        uint32_t sum = 0;
+        for (uint32_t digit = 0; digit < Buckets; ++digit)
+        {
+            uint32_t digitTotal = 0;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                const uint32_t n = offsets[c * Buckets + digit];
+                offsets[c * Buckets + digit] = sum;
+                sum += n;
+                digitTotal += n;
+            }
+            uniform = uniform || digitTotal == count;
+        }
+        if (uniform)
+            continue;
+
+        Pool.parallelFor(0, chunks, 1, [&](const size_t begin, const size_t end) {
+            for (size_t c = begin; c < end; ++c)
+            {
+                uint32_t *offset = &offsets[c * Buckets];
+                for (size_t i = c * SortChunkSize; i < std::min(count, (c + 1) * SortChunkSize); ++i)
+                {
+                    const uint32_t destination = offset[(Keys[i] >> shift) & (Buckets - 1)]++;
+                    KeysScratch[destination] = Keys[i];
+                    OrderScratch[destination] = Order[i];
+                }
+            }
+        });
+        Keys.swap(KeysScratch);
+        Order.swap(OrderScratch);
+    }
+
+    SortedPositions.resize(count);
+    Pool.parallelFor(0, count, ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t s = begin; s < end; ++s)
+        {
+            SortedPositions[s] = particles[Order[s]].Position;
+        }
+    });
+}
+
+void tCpuBarnesHut::buildTree()
+{
+    ZoneScopedN("tCpuBarnesHut: buildTree()");
+    const auto count = static_cast<uint32_t>(Keys.size());
+    Nodes.clear();
+    Nodes.push_back({glm::vec4(0.f), RootMin, RootSize, 0, count, 0, 0});
+
+    // The top levels serially, until every cell left is small enough to be one task among several per thread.
+    const size_t taskSize = std::max<size_t>(Params.LeafSize + 1, count / (8 * Pool.getThreadCount()));
+    const auto tasks = splitCells(Nodes, {0, 0}, taskSize);
+    const size_t topCount = Nodes.size();
+
+    // Every task builds and summarizes its subtree into its own array, rooted at index 0.
+    std::vector<std::vector<tNode>> subtrees(tasks.size());
+    Pool.parallelFor(0, tasks.size(), 1, [&](const size_t begin, const size_t end) {
+        for (size_t t = begin; t < end; ++t)
+        {
+            auto &local = subtrees[t];
+            local.push_back(Nodes[tasks[t].Node]);
+            splitCells(local, {0, tasks[t].Level}, 0);
+            for (size_t i = local.size(); i-- > 0;)
+            {
+                summarize(local[i], local);
+            }
+        }
+    });
+
+    // Splice: each subtree root replaces its cell, the rest is appended with shifted child indices.
+    std::vector<size_t> offsets(tasks.size());
+    size_t total = topCount;
+    for (size_t t = 0; t < tasks.size(); ++t)
+    {
+        offsets[t] = total;
+        total += subtrees[t].size() - 1;
+    }
+    Nodes.resize(total);
+    Pool.parallelFor(0, tasks.size(), 1, [&](const size_t begin, const size_t end) {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const auto &local = subtrees[t];
+            for (size_t i = 0; i < local.size(); ++i)
+            {
+                tNode node = local[i];
+                if (node.ChildCount > 0)
+                {
+                    node.FirstChild = static_cast<uint32_t>(offsets[t] + node.FirstChild - 1);
+                }
+                Nodes[i == 0 ? tasks[t].Node : offsets[t] + i - 1] = node;
+            }
+        }
+    });
+
+    // Children always follow their parent, so a reverse sweep over the top nodes sees children first. Spliced
+    // subtree roots are summarized again from their children, which gives the same result.
+    for (size_t i = topCount; i-- > 0;)
+    {
+        summarize(Nodes[i], Nodes);
+    }
+}
+
+std::vector<tCpuBarnesHut::tCell> tCpuBarnesHut::splitCells(std::vector<tNode> &nodes,
+                                                             const tCell root,
+                                                             const size_t deferBelow) const
+{
+    std::vector<tCell> deferred;
+    std::vector<tCell> pending{root};
+    while (!pending.empty())
+    {
+        const tCell cell = pending.back();
+        pending.pop_back();
+
+        const tNode node = nodes[cell.Node];
+        const uint32_t count = node.End - node.Begin;
+        // At the last level every key in the cell is equal, so it cannot be split further.
+        if (count <= Params.LeafSize || cell.Level == MortonBits)
+            continue;
+        if (count < deferBelow)
+        {
+            deferred.push_back(cell);
+            continue;
+        }
+
+        // Keys in the cell share every digit above this level, so its children are consecutive ranges.
+        const uint32_t shift = 3 * (MortonBits - 1 - cell.Level);
+        const float childSize = 0.5f * node.CellSize;
+        const auto firstChild = static_cast<uint32_t>(nodes.size());
+        uint32_t childBegin = node.Begin;
+        for (uint32_t digit = 0; digit < 8 && childBegin < node.End; ++digit)
+        {
+            const auto childEnd = static_cast<uint32_t>(
+                std::partition_point(Keys.begin() + childBegin,
+                                     Keys.begin() + node.End,
+                                     [&](const uint64_t key) { return ((key >> shift) & 7) <= digit; }) -
+                Keys.begin());
+            if (childEnd == childBegin)
+                continue;
+            const glm::vec3 corner(static_cast<float>(digit >> 2 & 1),
+                                   static_cast<float>(digit >> 1 & 1),
+                                   static_cast<float>(digit & 1));
+            nodes.push_back({glm::vec4(0.f), node.CellMin + childSize * corner, childSize, childBegin, childEnd, 0, 0});
+            childBegin = childEnd;
+        }
+        nodes[cell.Node].FirstChild = firstChild;
+        nodes[cell.Node].ChildCount = static_cast<uint32_t>(nodes.size()) - firstChild;
+        for (uint32_t child = firstChild; child < nodes.size(); ++child)
+        {
+            pending.push_back({child, cell.Level + 1});
+        }
+    }
+    return deferred;
+}
+
+void tCpuBarnesHut::summarize(tNode &node, const std::vector<tNode> &nodes) const
+{
+    glm::vec3 weighted(0.f);
+    float mass = 0.f;
+    const auto add = [&](const glm::vec4 &p) {
+        weighted += p.w * glm::vec3(p);
+        mass += p.w;
+    };
+    if (node.ChildCount == 0)
+    {
+        for (uint32_t i = node.Begin; i < node.End; ++i)
+        {
+            add(SortedPositions[i]);
+        }
+    }
+    else
+    {
+        for (uint32_t i = node.FirstChild; i < node.FirstChild + node.ChildCount; ++i)
+        {
+            add(nodes[i].CenterOfMass);
+        }
+    }
+    const glm::vec3 center = mass > 0.f ? weighted / mass : node.CellMin + 0.5f * node.CellSize;
+    node.CenterOfMass = glm::vec4(center, mass);
+}
+
+glm::vec3 tCpuBarnesHut::walk(const uint32_t sorted) const
+{
+    const glm::vec4 self = SortedPositions[sorted];
+    const glm::vec3 position(self);
+    const float theta2 = Params.OpeningAngle * Params.OpeningAngle;
+
+    // Depth first: at most 7 siblings wait per level plus the 8 children just pushed.
+    std::array<uint32_t, StackSize> stack;
+    uint32_t top = 0;
+    stack[top++] = 0;
+
+    glm::vec3 acceleration(0.f);
+    while (top > 0)
+    {
+        const tNode &node = Nodes[stack[--top]];
+        if (node.ChildCount == 0)
+        {
+            for (uint32_t j = node.Begin; j < node.End; ++j)
+            {
+                if (j != sorted)
+                {
+                    accumulate(acceleration, self, SortedPositions[j]);
+                }
+            }
+            continue;
+        }
+
+        const glm::vec3 dir = glm::vec3(node.CenterOfMass) - position;
+        const glm::vec3 cellMax = node.CellMin + node.CellSize;
+        // Never accept a cell that contains the particle itself, whatever the opening angle.
+        const bool inside = glm::all(glm::greaterThanEqual(position, node.CellMin)) &&
+                            glm::all(glm::lessThanEqual(position, cellMax));
+        if (inside || node.CellSize * node.CellSize >= theta2 * glm::dot(dir, dir))
+        {
+            for (uint32_t child = node.FirstChild + node.ChildCount; child-- > node.FirstChild;)
+            {
+                stack[top++] = child;
+            }
+            continue;
+        }
+        accumulate(acceleration, self, node.CenterOfMass);
+    }
+    return acceleration;
+}
@@ -0,0 +1,305 @@
+#include "sim/tCpuPhysics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <tracy/Tracy.hpp>
+
+#include "sim/initialParticles.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_PHYSICS_X86 1
+#endif
+
+namespace
+{
+// Same constants as forceNaive.comp.
+constexpr float Gravity = 1e-5f;
+constexpr float MinDistSqr = 1e-1f;
+constexpr float MaxDistSqr = 1e6f;
+
+struct tForceView
+{
+    const float *X;
+    const float *Y;
+    const float *Z;
+    const float *M;
+    float *AccX;
+    float *AccY;
+    float *AccZ;
+    size_t Sources;
+};
+
+using tForceFn = void (*)(const tForceView &view, size_t begin, size_t end);
+
+// Sums over every source, including the target itself: its offset is zero, so it adds nothing.
+void accumulateScalar(const tForceView &view, const size_t begin, const size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        float ax = 0.f;
+        float ay = 0.f;
+        float az = 0.f;
+        for (size_t j = 0; j < view.Sources; ++j)
+        {
+            const float dx = view.X[j] - view.X[i];
+            const float dy = view.Y[j] - view.Y[i];
+            const float dz = view.Z[j] - view.Z[i];
+            const float distSqr = std::clamp(dx * dx + dy * dy + dz * dz, MinDistSqr, MaxDistSqr);
+            const float invDist = 1.f / std::sqrt(distSqr);
+            const float s = view.M[j] * invDist * invDist * invDist;
+            ax += dx * s;
+            ay += dy * s;
+            az += dz * s;
+        }
+        view.AccX[i] = Gravity * ax;
+        view.AccY[i] = Gravity * ay;
+        view.AccZ[i] = Gravity * az;
+    }
+}
+
+#if defined(CPU_PHYSICS_X86)
+// 8 targets per register, every source broadcast; begin and end are multiples of 8.
+__attribute__((target("avx2,fma"))) void accumulateAvx2(const tForceView &view, const size_t begin, const size_t end)
+{
+    const __m256 minDist = _mm256_set1_ps(MinDistSqr);
+    const __m256 maxDist = _mm256_set1_ps(MaxDistSqr);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 gravity = _mm256_set1_ps(Gravity);
+    for (size_t i = begin; i < end; i += 8)
+    {
+        const __m256 xi = _mm256_loadu_ps(view.X + i);
+        const __m256 yi = _mm256_loadu_ps(view.Y + i);
+        const __m256 zi = _mm256_loadu_ps(view.Z + i);
+        __m256 ax = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps();
+        __m256 az = _mm256_setzero_ps();
+        for (size_t j = 0; j < view.Sources; ++j)
+        {
+            const __m256 dx = _mm256_sub_ps(_mm256_set1_ps(view.X[j]), xi);
+            const __m256 dy = _mm256_sub_ps(_mm256_set1_ps(view.Y[j]), yi);
+            const __m256 dz = _mm256_sub_ps(_mm256_set1_ps(view.Z[j]), zi);
+            __m256 distSqr = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+            distSqr = _mm256_min_ps(_mm256_max_ps(distSqr, minDist), maxDist);
+            // 12-bit estimate plus one Newton step: r * (1.5 - 0.5 * d * r^2).
+            __m256 invDist = _mm256_rsqrt_ps(distSqr);
+            const __m256 halfDist = _mm256_mul_ps(half, distSqr);
+            invDist = _mm256_mul_ps(
+                invDist, _mm256_fnmadd_ps(halfDist, _mm256_mul_ps(invDist, invDist), threeHalves));
+            const __m256 invDist3 = _mm256_mul_ps(invDist, _mm256_mul_ps(invDist, invDist));
+            const __m256 s = _mm256_mul_ps(_mm256_set1_ps(view.M[j]), invDist3);
+            ax = _mm256_fmadd_ps(dx, s, ax);
+            ay = _mm256_fmadd_ps(dy, s, ay);
+            az = _mm256_fmadd_ps(dz, s, az);
+        }
+        _mm256_storeu_ps(view.AccX + i, _mm256_mul_ps(gravity, ax));
+        _mm256_storeu_ps(view.AccY + i, _mm256_mul_ps(gravity, ay));
+        _mm256_storeu_ps(view.AccZ + i, _mm256_mul_ps(gravity, az));
+    }
+}
+
+// 16 targets per register; begin and end are multiples of 16.
+__attribute__((target("avx512f"))) void accumulateAvx512(const tForceView &view, const size_t begin, const size_t end)
+{
+    const __m512 minDist = _mm512_set1_ps(MinDistSqr);
+    const __m512 maxDist = _mm512_set1_ps(MaxDistSqr);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 gravity = _mm512_set1_ps(Gravity);
+    for (size_t i = begin; i < end; i += 16)
+    {
+        const __m512 xi = _mm512_loadu_ps(view.X + i);
+        const __m512 yi = _mm512_loadu_ps(view.Y + i);
+        const __m512 zi = _mm512_loadu_ps(view.Z + i);
+        __m512 ax = _mm512_setzero_ps();
+        __m512 ay = _mm512_setzero_ps();
+        __m512 az = _mm512_setzero_ps();
+        for (size_t j = 0; j < view.Sources; ++j)
+        {
+            const __m512 dx = _mm512_sub_ps(_mm512_set1_ps(view.X[j]), xi);
+            const __m512 dy = _mm512_sub_ps(_mm512_set1_ps(view.Y[j]), yi);
+            const __m512 dz = _mm512_sub_ps(_mm512_set1_ps(view.Z[j]), zi);
+            __m512 distSqr = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+            distSqr = _mm512_min_ps(_mm512_max_ps(distSqr, minDist), maxDist);
+            // 14-bit estimate plus one Newton step.
+            __m512 invDist = _mm512_rsqrt14_ps(distSqr);
+            const __m512 halfDist = _mm512_mul_ps(half, distSqr);
+            invDist = _mm512_mul_ps(
+                invDist, _mm512_fnmadd_ps(halfDist, _mm512_mul_ps(invDist, invDist), threeHalves));
+            const __m512 invDist3 = _mm512_mul_ps(invDist, _mm512_mul_ps(invDist, invDist));
+            const __m512 s = _mm512_mul_ps(_mm512_set1_ps(view.M[j]), invDist3);
+            ax = _mm512_fmadd_ps(dx, s, ax);
+            ay = _mm512_fmadd_ps(dy, s, ay);
+            az = _mm512_fmadd_ps(dz, s, az);
+        }
+        _mm512_storeu_ps(view.AccX + i, _mm512_mul_ps(gravity, ax));
+        _mm512_storeu_ps(view.AccY + i, _mm512_mul_ps(gravity, ay));
+        _mm512_storeu_ps(view.AccZ + i, _mm512_mul_ps(gravity, az));
+    }
+}
+#endif
+
+tForceFn getForceFunction(const tCpuPhysics::tKernel kernel)
+{
+    switch (kernel)
+    {
+#if defined(CPU_PHYSICS_X86)
+    case tCpuPhysics::tKernel::Avx2:
+        return accumulateAvx2;
+    case tCpuPhysics::tKernel::Avx512:
+        return accumulateAvx512;
+#endif
+    default:
+        return accumulateScalar;
+    }
+}
+
+const char *getKernelName(const tCpuPhysics::tKernel kernel)
+{
+    switch (kernel)
+    {
+    case tCpuPhysics::tKernel::Avx2:
+        return "AVX2";
+    case tCpuPhysics::tKernel::Avx512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+} // namespace
+
+tCpuPhysics::tCpuPhysics(const uint32_t count, const uint32_t threadCount)
+    : Kernel(getBestKernel()), Pool(threadCount)
+{
+    spdlog::info("tCpuPhysics: Initializing {} particles with the {} kernel...", count, getKernelName(Kernel));
+    setParticles(createInitialParticles(count));
+    spdlog::info("tCpuPhysics: Initialized");
+}
+
+bool tCpuPhysics::isSupported(const tKernel kernel)
+{
+    switch (kernel)
+    {
+    case tKernel::Scalar:
+        return true;
+#if defined(CPU_PHYSICS_X86)
+    case tKernel::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case tKernel::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+tCpuPhysics::tKernel tCpuPhysics::getBestKernel()
+{
+    for (const auto kernel : {tKernel::Avx512, tKernel::Avx2})
+    {
+        if (isSupported(kernel))
+            return kernel;
+    }
+    return tKernel::Scalar;
+}
+
+void tCpuPhysics::setKernel(const tKernel kernel)
+{
+    Kernel = isSupported(kernel) ? kernel : getBestKernel();
+    if (Kernel != kernel)
+    {
+        spdlog::warn("tCpuPhysics: {} kernel unsupported, using {}", getKernelName(kernel), getKernelName(Kernel));
+    }
+}
+
+void tCpuPhysics::computeAccelerations()
+{
+    ZoneScopedN("tCpuPhysics: computeAccelerations()");
+    const auto start = std::chrono::steady_clock::now();
+    const tForceView view{
+        PosX.data(), PosY.data(), PosZ.data(), Mass.data(), AccX.data(), AccY.data(), AccZ.data(), Count};
+    const tForceFn accumulate = getForceFunction(Kernel);
+    Pool.parallelFor(0, PosX.size(), ChunkSize, [&](const size_t begin, const size_t end) {
+        accumulate(view, begin, end);
+        // Free slots have no mass and stay parked where they were killed.
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (Mass[i] == 0.f)
+            {
+                AccX[i] = AccY[i] = AccZ[i] = 0.f;
+            }
+        }
+    });
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double pairs = static_cast<double>(Count) * static_cast<double>(Count);
+    InteractionsPerSecond = elapsed.count() > 0.0 ? pairs / elapsed.count() : 0.0;
+}
+
+void tCpuPhysics::step()
+{
+    ZoneScopedN("tCpuPhysics: step()");
+    computeAccelerations();
+    const float dt = Params.DeltaTime;
+    Pool.parallelFor(0, Count, ChunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            VelX[i] += dt * AccX[i];
+            VelY[i] += dt * AccY[i];
+            VelZ[i] += dt * AccZ[i];
+            PosX[i] += dt * VelX[i];
+            PosY[i] += dt * VelY[i];
+            PosZ[i] += dt * VelZ[i];
+        }
+    });
+}
+
+std::vector<tParticle> tCpuPhysics::getParticles() const
+{
+    std::vector<tParticle> particles(Count);
+    for (size_t i = 0; i < Count; ++i)
+    {
+        particles[i].Position = glm::vec4(PosX[i], PosY[i], PosZ[i], Mass[i]);
+        particles[i].Velocity = glm::vec4(VelX[i], VelY[i], VelZ[i], 0.f);
+    }
+    return particles;
+}
+
+void tCpuPhysics::setParticles(const std::vector<tParticle> &particles)
+{
+    resize(static_cast<uint32_t>(particles.size()));
+    for (size_t i = 0; i < Count; ++i)
+    {
+        const auto &p = particles[i];
+        PosX[i] = p.Position.x;
+        PosY[i] = p.Position.y;
+        PosZ[i] = p.Position.z;
+        Mass[i] = p.Position.w;
+        VelX[i] = p.Velocity.x;
+        VelY[i] = p.Velocity.y;
+        VelZ[i] = p.Velocity.z;
+    }
+}
+
+std::vector<glm::vec3> tCpuPhysics::getAccelerations() const
+{
+    std::vector<glm::vec3> accelerations(Count);
+    for (size_t i = 0; i < Count; ++i)
+    {
+        accelerations[i] = glm::vec3(AccX[i], AccY[i], AccZ[i]);
+    }
+    return accelerations;
+}
+
+void tCpuPhysics::resize(const uint32_t count)
+{
+    Count = count;
+    const size_t padded = (static_cast<size_t>(count) + Padding - 1) / Padding * Padding;
+    for (auto *array : {&PosX, &PosY, &PosZ, &Mass, &VelX, &VelY, &VelZ, &AccX, &AccY, &AccZ})
+    {
+        array->assign(padded, 0.f);
+    }
+}
@@ -0,0 +1,175 @@
+#include "sim/tDiagnostics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct DiagnosticsPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    vk::DeviceAddress particleCount;
+    vk::DeviceAddress blockRecords;
+    vk::DeviceAddress result;
+    uint32_t blockCount;
+    uint32_t potentialSamples;
+};
+
+// Same as forceNaive.comp.
+constexpr double Gravity = 1e-5;
+constexpr double MinDistSqr = 1e-1;
+constexpr double MaxDistSqr = 1e6;
+} // namespace
+
+tDiagnostics::tSample tDiagnostics::tSample::fromRecord(const tRecord &record, const uint64_t step)
+{
+    tSample sample;
+    sample.Step = step;
+    sample.Kinetic = record.Energy.x;
+    sample.Potential = record.Energy.y;
+    sample.Mass = record.Energy.z;
+    sample.Count = static_cast<uint32_t>(record.Energy.w);
+    sample.Momentum = glm::vec3(record.Momentum);
+    sample.AngularMomentum = glm::vec3(record.AngularMomentum);
+    if (sample.Mass > 0.f)
+    {
+        sample.CenterOfMass = glm::vec3(record.MassMoment) / sample.Mass;
+    }
+    return sample;
+}
+
+tDiagnostics::tDiagnostics(const tVulkanDevice &device, const uint32_t maxCapacity, const uint32_t readbackSlots)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      MaxCapacity(maxCapacity), ReadbackSlots(readbackSlots)
+{
+    spdlog::info("tDiagnostics: Initializing for up to {} slots...", MaxCapacity);
+    createBuffers();
+    createPipelines();
+    spdlog::info("tDiagnostics: Initialized");
+}
+
+void tDiagnostics::recordDiagnostics(const vk::raii::CommandBuffer &commandBuffer,
+                                     const tPhysics::tParticleBuffers &buffers,
+                                     const uint32_t capacity,
+                                     const vk::DeviceAddress particleCount,
+                                     const uint32_t potentialSamples,
+                                     const uint32_t slot) const
+{
+    ZoneScopedN("tDiagnostics: recordDiagnostics()");
+    if (capacity > MaxCapacity)
+        throw std::runtime_error("tDiagnostics: capacity exceeds the one the diagnostics were created with");
+
+    TracyVkNamedZone(TracyContext, tracyDiagnosticsZone, *commandBuffer, "Diagnostics", true);
+    const uint32_t blocks = (capacity + LocalSize - 1) / LocalSize;
+    const DiagnosticsPushConstants pc{buffers.Positions.Address,
+                                      buffers.Velocities.Address,
+                                      particleCount,
+                                      BlockRecords.Address,
+                                      Result.Address,
+                                      blocks,
+                                      potentialSamples};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, BlocksPipeline);
+    commandBuffer.dispatch(blocks, 1, 1);
+    recordComputeBarrier(commandBuffer);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, CombinePipeline);
+    commandBuffer.dispatch(1, 1, 1);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.copyBuffer(
+        *Result.Buffer, *ReadbackBuffer, vk::BufferCopy{0, slot * sizeof(tRecord), sizeof(tRecord)});
+    // The next reduction overwrites the result only after this copy.
+    recordTransferToComputeBarrier(commandBuffer);
+}
+
+tDiagnostics::tRecord tDiagnostics::readRecord(const uint32_t slot) const
+{
+    tRecord record;
+    std::memcpy(&record, static_cast<const char *>(MappedReadback) + slot * sizeof(tRecord), sizeof(record));
+    return record;
+}
+
+tDiagnostics::tRecord tDiagnostics::computeRecord(const std::vector<tParticle> &particles,
+                                                  const uint32_t potentialSamples)
+{
+    const auto count = static_cast<uint32_t>(particles.size());
+    // Same sampling as diagnosticsBlocks.comp.
+    const uint32_t stride =
+        potentialSamples > 0 ? std::max((count + potentialSamples - 1) / potentialSamples, 1u) : 0u;
+
+    glm::dvec4 energy{0.0};
+    glm::dvec3 momentum{0.0};
+    glm::dvec3 angularMomentum{0.0};
+    glm::dvec3 massMoment{0.0};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const glm::dvec3 position{particles[i].Position};
+        const glm::dvec3 velocity{particles[i].Velocity};
+        const double mass = particles[i].Position.w;
+        energy.x += 0.5 * mass * glm::dot(velocity, velocity);
+        energy.z += mass;
+        energy.w += mass > 0.0 ? 1.0 : 0.0;
+        momentum += mass * velocity;
+        angularMomentum += mass * glm::cross(position, velocity);
+        massMoment += mass * position;
+
+        if (stride == 0 || i % stride != 0 || mass <= 0.0)
+            continue;
+        double phi = 0.0;
+        for (uint32_t j = 0; j < count; ++j)
+        {
+            if (j == i)
+                continue;
+            const glm::dvec3 dir = glm::dvec3(particles[j].Position) - position;
+            phi += particles[j].Position.w / std::sqrt(std::clamp(glm::dot(dir, dir), MinDistSqr, MaxDistSqr));
+        }
+        energy.y += stride * -0.5 * Gravity * mass * phi;
+    }
+    return tRecord{glm::vec4(energy),
+                   glm::vec4(glm::vec3(momentum), 0.f),
+                   glm::vec4(glm::vec3(angularMomentum), 0.f),
+                   glm::vec4(glm::vec3(massMoment), 0.f)};
+}
+
+void tDiagnostics::createBuffers()
+{
+    spdlog::info("tDiagnostics: Creating buffers...");
+    const uint32_t blocks = (MaxCapacity + LocalSize - 1) / LocalSize;
+    BlockRecords = createStorageBuffer(Device, blocks * sizeof(tRecord), "tDiagnostics");
+    Result = createStorageBuffer(Device, sizeof(tRecord), "tDiagnostics");
+    std::tie(ReadbackBuffer, ReadbackMemory, MappedReadback) =
+        createBuffer(Device,
+                     ReadbackSlots * sizeof(tRecord),
+                     vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "tDiagnostics");
+    std::memset(MappedReadback, 0, ReadbackSlots * sizeof(tRecord));
+    spdlog::info("tDiagnostics: Buffers created");
+}
+
+void tDiagnostics::createPipelines()
+{
+    spdlog::info("tDiagnostics: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(DiagnosticsPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    BlocksPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "diagnosticsBlocks.comp.spv");
+    CombinePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "diagnosticsCombine.comp.spv");
+    spdlog::info("tDiagnostics: Compute pipelines created");
+}
@@ -0,0 +1,187 @@
+#include "sim/tEwaldTable.h"
+
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include <glm/gtc/packing.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/createBuffer.h"
+#include "sim/tThreadPool.h"
+
+namespace
+{
+// Splitting between the real-space and Fourier sums for a unit box. With it, images farther than RealCutoff and wave
+// vectors longer than sqrt(MaxWaveNumberSqr) each add less than 1e-10.
+constexpr double Alpha = 2.0;
+constexpr double RealCutoff = 2.6;
+constexpr int MaxWaveNumberSqr = 10;
+constexpr int Images = 3;
+} // namespace
+
+tEwaldTable::tEwaldTable(const tVulkanDevice &device)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), PhysicalDevice(device.getPhysicalDevice())
+{
+    spdlog::info("tEwaldTable: Initializing {}^3 texels...", Size);
+    createImage();
+    uploadTable();
+    spdlog::info("tEwaldTable: Initialized");
+}
+
+glm::dvec3 tEwaldTable::computeCorrection(const glm::dvec3 &r)
+{
+    // Gradient of the Ewald potential plus r / |r|^3, which cancels the Newtonian part of the n = 0 term.
+    const double pi = std::numbers::pi;
+    glm::dvec3 sum{0.0};
+    for (int nx = -Images; nx <= Images; ++nx)
+    {
+        for (int ny = -Images; ny <= Images; ++ny)
+        {
+            for (int nz = -Images; nz <= Images; ++nz)
+            {
+                const glm::dvec3 s = r - glm::dvec3(nx, ny, nz);
+                const double rho = glm::length(s);
+                const double gaussian = 2.0 * Alpha * rho / std::sqrt(pi) * std::exp(-Alpha * Alpha * rho * rho);
+                if (nx == 0 && ny == 0 && nz == 0)
+                {
+                    if (rho > 0.0)
+                        sum += s / (rho * rho * rho) * (std::erf(Alpha * rho) - gaussian);
+                }
+                else if (rho < RealCutoff)
+                {
+                    sum -= s / (rho * rho * rho) * (std::erfc(Alpha * rho) + gaussian);
+                }
+
+                const int k2 = nx * nx + ny * ny + nz * nz;
+                if (k2 > 0 && k2 <= MaxWaveNumberSqr)
+                {
+                    const glm::dvec3 k(nx, ny, nz);
+                    sum -= 2.0 * k / static_cast<double>(k2) * std::exp(-pi * pi * k2 / (Alpha * Alpha)) *
+                           std::sin(2.0 * pi * glm::dot(k, r));
+                }
+            }
+        }
+    }
+    // The pull towards the neighbour is along r, the opposite of the potential gradient in the self - other
+    // separation the sums are written in.
+    return -sum;
+}
+
+std::vector<glm::vec4> tEwaldTable::computeTable(const uint32_t threadCount)
+{
+    std::vector<glm::vec4> table(Size * Size * Size);
+    const double step = 0.5 / (Size - 1);
+    tThreadPool pool{threadCount};
+    pool.parallelFor(0, table.size(), Size * Size, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::dvec3 r{static_cast<double>(i % Size) * step,
+                               static_cast<double>(i / Size % Size) * step,
+                               static_cast<double>(i / (Size * Size)) * step};
+            table[i] = glm::vec4(glm::vec3(computeCorrection(r)), 0.f);
+        }
+    });
+    return table;
+}
+
+void tEwaldTable::createImage()
+{
+    spdlog::info("tEwaldTable: Creating image...");
+    const auto linear = vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    if (!(PhysicalDevice.getFormatProperties(Format).optimalTilingFeatures & linear))
+    {
+        Format = vk::Format::eR16G16B16A16Sfloat;
+    }
+
+    vk::ImageCreateInfo ici({},
+                            vk::ImageType::e3D,
+                            Format,
+                            vk::Extent3D(Size, Size, Size),
+                            1,
+                            1,
+                            vk::SampleCountFlagBits::e1,
+                            vk::ImageTiling::eOptimal,
+                            vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                            vk::SharingMode::eExclusive,
+                            0,
+                            nullptr,
+                            vk::ImageLayout::eUndefined);
+    Image = LogicalDevice.createImage(ici);
+
+    Memory = Device.getAllocator().allocate(Image, vk::MemoryPropertyFlagBits::eDeviceLocal, "tEwaldTable");
+
+    vk::ImageViewCreateInfo ivci(
+        {}, *Image, vk::ImageViewType::e3D, Format, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    ImageView = LogicalDevice.createImageView(ivci);
+
+    // Separations beyond half the box never occur after the minimum-image wrap; clamping only guards rounding.
+    vk::SamplerCreateInfo sci{};
+    sci.magFilter = vk::Filter::eLinear;
+    sci.minFilter = vk::Filter::eLinear;
+    sci.mipmapMode = vk::SamplerMipmapMode::eNearest;
+    sci.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    sci.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    sci.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+    Sampler = LogicalDevice.createSampler(sci);
+    spdlog::info("tEwaldTable: Image created as {}", vk::to_string(Format));
+}
+
+void tEwaldTable::uploadTable()
+{
+    spdlog::info("tEwaldTable: Computing and uploading the table...");
+    // The table only depends on Size, so every instance shares the first one's.
+    static const auto table = computeTable();
+    std::vector<uint16_t> halfTable;
+    const void *data = table.data();
+    vk::DeviceSize size = table.size() * sizeof(glm::vec4);
+    if (Format == vk::Format::eR16G16B16A16Sfloat)
+    {
+        halfTable.reserve(table.size() * 4);
+        for (const auto &texel : table)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                halfTable.push_back(glm::packHalf1x16(texel[c]));
+            }
+        }
+        data = halfTable.data();
+        size = halfTable.size() * sizeof(uint16_t);
+    }
+
+    auto [staging, stagingMemory, mapped] =
+        createBuffer(Device,
+                     size,
+                     vk::BufferUsageFlagBits::eTransferSrc,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     data,
+                     "tEwaldTable");
+
+    auto commandBuffer = Device.beginSingleTimeCommands();
+    vk::ImageMemoryBarrier2 toTransfer{};
+    toTransfer.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+    toTransfer.srcAccessMask = vk::AccessFlagBits2::eNone;
+    toTransfer.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    toTransfer.dstAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    toTransfer.oldLayout = vk::ImageLayout::eUndefined;
+    toTransfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    toTransfer.image = *Image;
+    toTransfer.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, toTransfer));
+
+    const vk::BufferImageCopy region{
+        0, 0, 0, {vk::ImageAspectFlagBits::eColor, 0, 0, 1}, {0, 0, 0}, vk::Extent3D(Size, Size, Size)};
+    commandBuffer.copyBufferToImage(*staging, *Image, vk::ImageLayout::eTransferDstOptimal, region);
+
+    vk::ImageMemoryBarrier2 toShader = toTransfer;
+    toShader.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    toShader.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    toShader.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+    toShader.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+    toShader.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    toShader.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo({}, {}, {}, toShader));
+    Device.endSingleTimeCommands(commandBuffer);
+    spdlog::info("tEwaldTable: Table uploaded");
+}
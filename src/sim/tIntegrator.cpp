@@ -0,0 +1,120 @@
+#include "sim/tIntegrator.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct IntegratorPushConstants
+{
+    vk::DeviceAddress accelerations;
+    vk::DeviceAddress particleCount;
+    vk::DeviceAddress renderStream;
+    float kick;
+    float drift;
+    uint32_t writeRenderStream;
+    uint32_t pad0;
+};
+} // namespace
+
+tIntegrator::tIntegrator(const tVulkanDevice &device,
+                         const vk::raii::DescriptorSetLayout &descriptorLayout,
+                         const uint32_t numParticles,
+                         const tScheme scheme)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      NumParticles(numParticles), Scheme(scheme), Stages(buildStages(scheme))
+{
+    spdlog::info("tIntegrator: Initializing...");
+    createBuffers();
+    createPipelines(descriptorLayout);
+    spdlog::info("tIntegrator: Initialized");
+}
+
+void tIntegrator::setScheme(const tScheme scheme)
+{
+    Scheme = scheme;
+    Stages = buildStages(scheme);
+}
+
+void tIntegrator::recordStage(const vk::raii::CommandBuffer &commandBuffer,
+                              const vk::raii::DescriptorSet &set,
+                              const tStage &stage,
+                              const tActiveList &live,
+                              const vk::DeviceAddress renderStream) const
+{
+    ZoneScopedN("tIntegrator: recordStage()");
+    spdlog::trace("tIntegrator: Recording stage kick {} drift {}...", stage.Kick, stage.Drift);
+    TracyVkNamedZone(TracyContext, tracyIntegratorZone, *commandBuffer, "Integrator Stage", true);
+
+    const auto &pipeline = stage.Type == tStageType::Kick ? KickPipeline : DriftPipeline;
+    const IntegratorPushConstants pc{
+        Accelerations.Address, live.Count, renderStream, stage.Kick, stage.Drift, renderStream != 0 ? 1u : 0u, 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PipelineLayout, 0, *set, {});
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatchIndirect(live.Dispatch, live.DispatchOffset);
+    spdlog::trace("tIntegrator: Recorded stage");
+}
+
+std::vector<tIntegrator::tStage> tIntegrator::buildStages(const tScheme scheme)
+{
+    using enum tStageType;
+    switch (scheme)
+    {
+    case tScheme::SemiImplicitEuler:
+        // v += a dt, then x += v dt, fused into one pass.
+        return {{Force}, {Drift, 1.f, 1.f}};
+    case tScheme::LeapfrogKdk:
+        return {{Kick, 0.5f}, {Drift, 0.f, 1.f}, {Force}, {Kick, 0.5f}};
+    case tScheme::VelocityVerlet:
+        // x += v dt + a dt^2 / 2 is the first half kick fused into the drift.
+        return {{Drift, 0.5f, 1.f}, {Force}, {Kick, 0.5f}};
+    case tScheme::Yoshida4:
+    {
+        // Triple jump of three KDK steps with weights w1, w0, w1; adjacent half kicks are merged.
+        const float cbrt2 = std::cbrt(2.f);
+        const float w1 = 1.f / (2.f - cbrt2);
+        const float w0 = -cbrt2 / (2.f - cbrt2);
+        return {{Kick, 0.5f * w1},
+                {Drift, 0.f, w1},
+                {Force},
+                {Kick, 0.5f * (w1 + w0)},
+                {Drift, 0.f, w0},
+                {Force},
+                {Kick, 0.5f * (w0 + w1)},
+                {Drift, 0.f, w1},
+                {Force},
+                {Kick, 0.5f * w1}};
+    }
+    }
+    throw std::runtime_error("tIntegrator: Unknown integration scheme");
+}
+
+void tIntegrator::createBuffers()
+{
+    spdlog::info("tIntegrator: Creating buffers...");
+    Accelerations = createStorageBuffer(Device, NumParticles * sizeof(glm::vec4), "tIntegrator");
+    spdlog::info("tIntegrator: Buffers created");
+}
+
+void tIntegrator::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tIntegrator: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(IntegratorPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    KickPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "kick.comp.spv");
+    DriftPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "drift.comp.spv");
+    spdlog::info("tIntegrator: Compute pipelines created");
+}
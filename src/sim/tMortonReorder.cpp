@@ -0,0 +1,116 @@
+#include "sim/tMortonReorder.h"
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+#include "sim/tParticlePool.h"
+
+namespace
+{
+struct ReorderPushConstants
+{
+    vk::DeviceAddress sourcePositions;
+    vk::DeviceAddress sourceVelocities;
+    vk::DeviceAddress destinationPositions;
+    vk::DeviceAddress destinationVelocities;
+    vk::DeviceAddress keys;
+    vk::DeviceAddress values;
+    vk::DeviceAddress bounds;
+    vk::DeviceAddress counters;
+    vk::DeviceAddress sourceIds;
+    vk::DeviceAddress destinationIds;
+    uint32_t capacity;
+    uint32_t pad0;
+};
+
+// Bounds are stored as order-preserving uints: min xyz at [0, 3), max xyz at [4, 7).
+constexpr vk::DeviceSize BoundsHalfSize = 4 * sizeof(uint32_t);
+} // namespace
+
+tMortonReorder::tMortonReorder(const tVulkanDevice &device, const uint32_t capacity)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      Capacity(capacity)
+{
+    spdlog::info("tMortonReorder: Initializing for {} slots...", Capacity);
+    createBuffers();
+    createPipelines();
+    Sort = std::make_unique<tRadixSort>(Device, Capacity);
+    spdlog::info("tMortonReorder: Initialized");
+}
+
+void tMortonReorder::recordReorder(const vk::raii::CommandBuffer &commandBuffer,
+                                   const vk::raii::DescriptorSet &set,
+                                   const tPhysics::tParticleBuffers &source,
+                                   const tPhysics::tParticleBuffers &destination,
+                                   const tParticlePool &pool) const
+{
+    ZoneScopedN("tMortonReorder: recordReorder()");
+    TracyVkNamedZone(TracyContext, tracyReorderZone, *commandBuffer, "Morton Reorder", true);
+    const ReorderPushConstants pc{source.Positions.Address,
+                                  source.Velocities.Address,
+                                  destination.Positions.Address,
+                                  destination.Velocities.Address,
+                                  Keys.Address,
+                                  Values.Address,
+                                  Bounds.Address,
+                                  pool.getCountAddress(),
+                                  pool.getIdsAddress(),
+                                  ScratchIds.Address,
+                                  Capacity,
+                                  0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    const uint32_t groups = (Capacity + LocalSize - 1) / LocalSize;
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.fillBuffer(*Bounds.Buffer, 0, BoundsHalfSize, 0xFFFFFFFFu);
+    commandBuffer.fillBuffer(*Bounds.Buffer, BoundsHalfSize, BoundsHalfSize, 0u);
+    recordTransferToComputeBarrier(commandBuffer);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, BoundsPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, KeysPipeline);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+
+    Sort->recordSort(commandBuffer, Keys.Address, Values.Address, Capacity, KeyBits);
+
+    // The sort binds its own layout, so push constants are re-pushed.
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, GatherPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.copyBuffer(
+        *ScratchIds.Buffer, *pool.getIdsBuffer(), vk::BufferCopy{0, 0, Capacity * sizeof(uint32_t)});
+    recordTransferToComputeBarrier(commandBuffer);
+    pool.recordArgumentRefresh(commandBuffer, set);
+}
+
+void tMortonReorder::createBuffers()
+{
+    spdlog::info("tMortonReorder: Creating buffers...");
+    Keys = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tMortonReorder");
+    Values = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tMortonReorder");
+    Bounds = createStorageBuffer(Device, 2 * BoundsHalfSize, "tMortonReorder");
+    ScratchIds = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tMortonReorder");
+    spdlog::info("tMortonReorder: Buffers created");
+}
+
+void tMortonReorder::createPipelines()
+{
+    spdlog::info("tMortonReorder: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(ReorderPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    BoundsPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "reorderBounds.comp.spv");
+    KeysPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "reorderKeys.comp.spv");
+    GatherPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "reorderGather.comp.spv");
+    spdlog::info("tMortonReorder: Compute pipelines created");
+}
@@ -0,0 +1,211 @@
+#include "sim/tParticleMesh.h"
+
+#include <bit>
+#include <numbers>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct ParticleMeshPushConstants
+{
+    glm::vec4 origin; // xyz = box origin, w = cells per unit length
+    vk::DeviceAddress density;
+    vk::DeviceAddress field;
+    vk::DeviceAddress acceleration;
+    uint32_t gridSize;
+    uint32_t numParticles;
+    float massScale; // fixed-point units per unit mass, for 64-bit cell masses
+    float boxSize;
+    uint32_t axis;
+    int32_t direction;
+    uint32_t log2GridSize;
+    uint32_t pad0;
+    vk::DeviceAddress particleAccelerations;
+};
+
+// Cell masses are 64-bit fixed point. Every cell holds at most the total mass, so 2^62 units for it can never overflow,
+// and a particle's deposit keeps its full float precision down to 2^-38 of the total.
+float fixedPointScale(const float totalMass)
+{
+    return 4611686018427387904.0f / std::max(totalMass, 1e-6f);
+}
+
+uint32_t validatedLog2(const uint32_t gridSize)
+{
+    if (!std::has_single_bit(gridSize) || gridSize < 2 || gridSize > tParticleMesh::MaxGridSize)
+        throw std::runtime_error("tParticleMesh: grid size must be a power of two in [2, MaxGridSize]");
+    return static_cast<uint32_t>(std::countr_zero(gridSize));
+}
+} // namespace
+
+tParticleMesh::tParticleMesh(const tVulkanDevice &device,
+                             const vk::raii::DescriptorSetLayout &descriptorLayout,
+                             const uint32_t numParticles,
+                             const float totalMass,
+                             const tParams &params)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      NumParticles(numParticles), MassScale(fixedPointScale(totalMass)), Params(params),
+      Log2GridSize(validatedLog2(params.GridSize)), CellTotal(params.GridSize * params.GridSize * params.GridSize)
+{
+    spdlog::info("tParticleMesh: Initializing {}^3 mesh...", Params.GridSize);
+    createBuffers();
+    createPipelines(descriptorLayout);
+    spdlog::info("tParticleMesh: Initialized");
+}
+
+void tParticleMesh::recordParticleMeshPass(const vk::raii::CommandBuffer &commandBuffer,
+                                           const vk::raii::DescriptorSet &set,
+                                           const vk::DeviceAddress accelerations) const
+{
+    ZoneScopedN("tParticleMesh: recordParticleMeshPass()");
+    spdlog::trace("tParticleMesh: Recording particle-mesh pass...");
+    TracyVkNamedZone(TracyContext, tracyParticleMeshZone, *commandBuffer, "Particle Mesh", true);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.fillBuffer(*Density.Buffer, 0, VK_WHOLE_SIZE, 0u);
+    recordTransferToComputeBarrier(commandBuffer);
+
+    dispatchParticles(commandBuffer, DepositPipeline, set, accelerations);
+    recordComputeBarrier(commandBuffer);
+    dispatchCells(commandBuffer, ConvertPipeline);
+    recordComputeBarrier(commandBuffer);
+
+    recordFft(commandBuffer, Field.Address, 1);
+    dispatchCells(commandBuffer, PoissonPipeline);
+    recordComputeBarrier(commandBuffer);
+    recordFft(commandBuffer, Field.Address, -1);
+
+    dispatchCells(commandBuffer, GradientPipeline);
+    recordComputeBarrier(commandBuffer);
+    dispatchParticles(commandBuffer, InterpolatePipeline, set, accelerations);
+    spdlog::trace("tParticleMesh: Recorded particle-mesh pass");
+}
+
+void tParticleMesh::recordFft(const vk::raii::CommandBuffer &commandBuffer,
+                              const vk::DeviceAddress data,
+                              const int direction) const
+{
+    ZoneScopedN("tParticleMesh: recordFft()");
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FftPipeline);
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        pushConstants(commandBuffer, data, axis, direction);
+        commandBuffer.dispatch(Params.GridSize, Params.GridSize, 1);
+        recordComputeBarrier(commandBuffer);
+    }
+}
+
+std::vector<std::complex<float>> tParticleMesh::dftReference(const std::vector<std::complex<float>> &data,
+                                                             const uint32_t gridSize,
+                                                             const int direction)
+{
+    const size_t n = gridSize;
+    std::vector<std::complex<double>> current(data.begin(), data.end());
+    std::vector<std::complex<double>> line(n);
+    const size_t strides[] = {1, n, n * n};
+
+    for (const auto stride : strides)
+    {
+        for (size_t ix = 0; ix < current.size(); ++ix)
+        {
+            // Visit every line once, from its first element along this axis.
+            if ((ix / stride) % n != 0)
+                continue;
+
+            for (size_t k = 0; k < n; ++k)
+            {
+                std::complex<double> sum{0.0, 0.0};
+                for (size_t j = 0; j < n; ++j)
+                {
+                    const double angle = -2.0 * std::numbers::pi * direction * static_cast<double>(j * k) / n;
+                    sum += current[ix + j * stride] * std::polar(1.0, angle);
+                }
+                line[k] = sum;
+            }
+            for (size_t k = 0; k < n; ++k)
+            {
+                current[ix + k * stride] = line[k];
+            }
+        }
+    }
+
+    return {current.begin(), current.end()};
+}
+
+void tParticleMesh::createBuffers()
+{
+    spdlog::info("tParticleMesh: Creating buffers...");
+    Density = createStorageBuffer(Device, CellTotal * sizeof(uint64_t), "tParticleMesh");
+    Field = createStorageBuffer(Device, CellTotal * sizeof(glm::vec2), "tParticleMesh");
+    Acceleration = createStorageBuffer(Device, CellTotal * sizeof(glm::vec4), "tParticleMesh");
+    spdlog::info("tParticleMesh: Buffers created");
+}
+
+void tParticleMesh::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tParticleMesh: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(ParticleMeshPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    DepositPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmDeposit.comp.spv");
+    ConvertPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmConvert.comp.spv");
+    FftPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmFft.comp.spv");
+    PoissonPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmPoisson.comp.spv");
+    GradientPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmGradient.comp.spv");
+    InterpolatePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "pmInterpolate.comp.spv");
+    spdlog::info("tParticleMesh: Compute pipelines created");
+}
+
+void tParticleMesh::dispatchParticles(const vk::raii::CommandBuffer &commandBuffer,
+                                      const vk::raii::Pipeline &pipeline,
+                                      const vk::raii::DescriptorSet &set,
+                                      const vk::DeviceAddress accelerations) const
+{
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PipelineLayout, 0, *set, {});
+    pushConstants(commandBuffer, Field.Address, 0, 1, accelerations);
+    commandBuffer.dispatch((NumParticles + LocalSize - 1) / LocalSize, 1, 1);
+}
+
+void tParticleMesh::dispatchCells(const vk::raii::CommandBuffer &commandBuffer,
+                                  const vk::raii::Pipeline &pipeline) const
+{
+    // One row of groups per z slice keeps large grids under the 65535 group limit.
+    const uint32_t sliceCells = Params.GridSize * Params.GridSize;
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    pushConstants(commandBuffer, Field.Address, 0, 1);
+    commandBuffer.dispatch((sliceCells + LocalSize - 1) / LocalSize, Params.GridSize, 1);
+}
+
+void tParticleMesh::pushConstants(const vk::raii::CommandBuffer &commandBuffer,
+                                  const vk::DeviceAddress field,
+                                  const uint32_t axis,
+                                  const int direction,
+                                  const vk::DeviceAddress particleAccelerations) const
+{
+    const float cellsPerUnit = static_cast<float>(Params.GridSize) / Params.BoxSize;
+    const ParticleMeshPushConstants pc{glm::vec4(Params.Origin, cellsPerUnit),
+                                       Density.Address,
+                                       field,
+                                       Acceleration.Address,
+                                       Params.GridSize,
+                                       NumParticles,
+                                       MassScale,
+                                       Params.BoxSize,
+                                       axis,
+                                       direction,
+                                       Log2GridSize,
+                                       0u,
+                                       particleAccelerations};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+}
@@ -0,0 +1,272 @@
+#include "sim/tParticlePool.h"
+
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct PoolPushConstants
+{
+    vk::DeviceAddress counters;
+    vk::DeviceAddress freeList;
+    vk::DeviceAddress ids;
+    uint32_t capacity;
+    uint32_t emitCount;
+    uint32_t seed;
+    float killRadius;
+    float emitRadius;
+    uint32_t orderedFreeList;
+};
+
+struct FreeListPushConstants
+{
+    vk::DeviceAddress counters;
+    vk::DeviceAddress freeList;
+    vk::DeviceAddress ids;
+    vk::DeviceAddress flags;
+    uint32_t capacity;
+    uint32_t pad0;
+};
+
+// Emitted particles start on the shell the initial set is normalized to.
+constexpr float EmitRadius = 2.f;
+} // namespace
+
+tParticlePool::tParticlePool(const tVulkanDevice &device,
+                             const vk::raii::DescriptorSetLayout &descriptorLayout,
+                             const uint32_t count,
+                             const uint32_t capacity,
+                             const uint32_t readbackSlots)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      ReadbackSlots(readbackSlots), Capacity(capacity)
+{
+    spdlog::info("tParticlePool: Initializing {} of {} slots...", count, Capacity);
+    createBuffers(count);
+    createPipelines(descriptorLayout);
+    spdlog::info("tParticlePool: Initialized");
+}
+
+void tParticlePool::recordKillAndEmit(const vk::raii::CommandBuffer &commandBuffer,
+                                      const vk::raii::DescriptorSet &set,
+                                      const float killRadius,
+                                      const uint32_t emitCount,
+                                      const uint32_t seed,
+                                      const bool orderedFreeList) const
+{
+    ZoneScopedN("tParticlePool: recordKillAndEmit()");
+    TracyVkNamedZone(TracyContext, tracyPoolZone, *commandBuffer, "Particle Pool", true);
+    bindAndPush(commandBuffer, set, killRadius, emitCount, seed, orderedFreeList);
+
+    if (killRadius > 0.f)
+    {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, KillPipeline);
+        commandBuffer.dispatchIndirect(*Counters.Buffer, DispatchArgsOffset);
+        recordComputeBarrier(commandBuffer);
+        if (orderedFreeList)
+        {
+            recordFreeListRebuild(commandBuffer);
+            bindAndPush(commandBuffer, set, killRadius, emitCount, seed, orderedFreeList);
+        }
+    }
+
+    if (emitCount > 0)
+    {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, EmitPipeline);
+        commandBuffer.dispatch((emitCount + LocalSize - 1) / LocalSize, 1, 1);
+        recordComputeBarrier(commandBuffer);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FinalizePipeline);
+        commandBuffer.dispatch(1, 1, 1);
+    }
+    recordComputeToIndirectBarrier(commandBuffer);
+}
+
+void tParticlePool::recordArgumentRefresh(const vk::raii::CommandBuffer &commandBuffer,
+                                          const vk::raii::DescriptorSet &set) const
+{
+    bindAndPush(commandBuffer, set, 0.f, 0u, 0u, false);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FinalizePipeline);
+    commandBuffer.dispatch(1, 1, 1);
+    recordComputeToIndirectBarrier(commandBuffer);
+}
+
+void tParticlePool::bindAndPush(const vk::raii::CommandBuffer &commandBuffer,
+                                const vk::raii::DescriptorSet &set,
+                                const float killRadius,
+                                const uint32_t emitCount,
+                                const uint32_t seed,
+                                const bool orderedFreeList) const
+{
+    const PoolPushConstants pc{Counters.Address,
+                               FreeList.Address,
+                               Ids.Address,
+                               Capacity,
+                               emitCount,
+                               seed,
+                               killRadius,
+                               EmitRadius,
+                               orderedFreeList ? 1u : 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PipelineLayout, 0, *set, {});
+    commandBuffer.pushConstants2(pushConstantsInfo);
+}
+
+void tParticlePool::recordFreeListRebuild(const vk::raii::CommandBuffer &commandBuffer) const
+{
+    // Flags, scan and scatter over every slot: no atomics, so the order only depends on which slots are free.
+    const FreeListPushConstants pc{Counters.Address, FreeList.Address, Ids.Address, FreeFlags.Address, Capacity, 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    const uint32_t groups = (Capacity + LocalSize - 1) / LocalSize;
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FreeFlagsPipeline);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+
+    Scan->recordScan(commandBuffer, FreeFlags.Address, Capacity);
+
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, FreeCompactPipeline);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+}
+
+void tParticlePool::recordReadback(const vk::raii::CommandBuffer &commandBuffer, const uint32_t slot) const
+{
+    const vk::MemoryBarrier2 countersToCopy{vk::PipelineStageFlagBits2::eComputeShader,
+                                            vk::AccessFlagBits2::eShaderWrite,
+                                            vk::PipelineStageFlagBits2::eTransfer,
+                                            vk::AccessFlagBits2::eTransferRead};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(countersToCopy));
+    commandBuffer.copyBuffer(
+        *Counters.Buffer, *ReadbackBuffer, vk::BufferCopy{0, slot * sizeof(tCounters), sizeof(tCounters)});
+}
+
+void tParticlePool::recordCounterSnapshot(const vk::raii::CommandBuffer &commandBuffer,
+                                          const vk::raii::Buffer &destination) const
+{
+    commandBuffer.copyBuffer(*Counters.Buffer, *destination, vk::BufferCopy{0, 0, CounterWords * sizeof(uint32_t)});
+}
+
+tParticlePool::tCounters tParticlePool::readCounters(const uint32_t slot) const
+{
+    tCounters counters;
+    std::memcpy(&counters, static_cast<const char *>(MappedReadback) + slot * sizeof(tCounters), sizeof(tCounters));
+    return counters;
+}
+
+std::shared_ptr<void> tParticlePool::grow(const uint32_t capacity)
+{
+    spdlog::info("tParticlePool: Growing from {} to {} slots", Capacity, capacity);
+    using tRetired = std::tuple<tStorageBuffer, tStorageBuffer, tStorageBuffer, std::unique_ptr<tPrefixScan>>;
+    auto retired =
+        std::make_shared<tRetired>(std::move(FreeList), std::move(Ids), std::move(FreeFlags), std::move(Scan));
+    GrowthFreeList = *std::get<0>(*retired).Buffer;
+    GrowthIds = *std::get<1>(*retired).Buffer;
+    GrowthSourceSize = Capacity * sizeof(uint32_t);
+    Capacity = capacity;
+    FreeList = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tParticlePool");
+    Ids = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tParticlePool");
+    FreeFlags = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tParticlePool");
+    Scan = std::make_unique<tPrefixScan>(Device, Capacity);
+    return retired;
+}
+
+void tParticlePool::recordGrowth(const vk::raii::CommandBuffer &commandBuffer) const
+{
+    if (!GrowthFreeList)
+        return;
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.copyBuffer(GrowthFreeList, *FreeList.Buffer, vk::BufferCopy{0, 0, GrowthSourceSize});
+    commandBuffer.copyBuffer(GrowthIds, *Ids.Buffer, vk::BufferCopy{0, 0, GrowthSourceSize});
+    commandBuffer.fillBuffer(*Ids.Buffer, GrowthSourceSize, VK_WHOLE_SIZE, InvalidId);
+    recordTransferToComputeBarrier(commandBuffer);
+    GrowthFreeList = nullptr;
+    GrowthIds = nullptr;
+}
+
+void tParticlePool::createBuffers(const uint32_t count)
+{
+    spdlog::info("tParticlePool: Creating buffers...");
+    const uint32_t groups = (count + tActiveList::LocalSize - 1) / tActiveList::LocalSize;
+    const uint32_t tasks = (count + TaskParticles - 1) / TaskParticles;
+    const std::array<uint32_t, CounterWords> counters{count, 0u, count, 0u, groups, 1u, 1u, 0u, tasks, 1u, 1u, 0u};
+
+    vk::raii::Buffer buffer{nullptr};
+    tAllocation memory{nullptr};
+    std::tie(buffer, memory, std::ignore) =
+        createBuffer(Device,
+                     sizeof(counters),
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                         vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferSrc |
+                         vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eDeviceLocal,
+                     counters.data(),
+                     "tParticlePool");
+    Counters.Address = LogicalDevice.getBufferAddress(vk::BufferDeviceAddressInfo{*buffer});
+    Counters.Buffer = std::move(buffer);
+    Counters.Memory = std::move(memory);
+
+    FreeList = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tParticlePool");
+    FreeFlags = createStorageBuffer(Device, Capacity * sizeof(uint32_t), "tParticlePool");
+    Scan = std::make_unique<tPrefixScan>(Device, Capacity);
+
+    // The initial particles are numbered by slot.
+    std::vector<uint32_t> ids(Capacity, InvalidId);
+    std::iota(ids.begin(), ids.begin() + count, 0u);
+    std::tie(buffer, memory, std::ignore) =
+        createBuffer(Device,
+                     Capacity * sizeof(uint32_t),
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                         vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eDeviceLocal,
+                     ids.data(),
+                     "tParticlePool");
+    Ids.Address = LogicalDevice.getBufferAddress(vk::BufferDeviceAddressInfo{*buffer});
+    Ids.Buffer = std::move(buffer);
+    Ids.Memory = std::move(memory);
+
+    std::tie(ReadbackBuffer, ReadbackMemory, MappedReadback) =
+        createBuffer(Device,
+                     ReadbackSlots * sizeof(tCounters),
+                     vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "tParticlePool");
+    for (uint32_t slot = 0; slot < ReadbackSlots; ++slot)
+    {
+        const tCounters initial{count, 0u};
+        std::memcpy(static_cast<char *>(MappedReadback) + slot * sizeof(tCounters), &initial, sizeof(initial));
+    }
+    spdlog::info("tParticlePool: Buffers created");
+}
+
+void tParticlePool::createPipelines(const vk::raii::DescriptorSetLayout &setLayout)
+{
+    spdlog::info("tParticlePool: Creating compute pipelines...");
+    static_assert(sizeof(FreeListPushConstants) <= sizeof(PoolPushConstants));
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(PoolPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    KillPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "poolKill.comp.spv");
+    EmitPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "poolEmit.comp.spv");
+    FinalizePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "poolFinalize.comp.spv");
+    FreeFlagsPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "poolFreeFlags.comp.spv");
+    FreeCompactPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "poolFreeCompact.comp.spv");
+    spdlog::info("tParticlePool: Compute pipelines created");
+}
@@ -0,0 +1,242 @@
+#include "sim/tParticleReadback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct GatherPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    vk::DeviceAddress ids;
+    vk::DeviceAddress particleCount;
+    vk::DeviceAddress readback;
+    vk::DeviceAddress readbackIds;
+    uint32_t first;
+    uint32_t stride;
+    uint32_t maxRecords;
+    uint32_t pad0;
+};
+
+constexpr vk::DeviceSize RecordSize = sizeof(tParticle) + sizeof(uint32_t);
+} // namespace
+
+tParticleReadback::tParticleReadback(const tVulkanDevice &device, const uint32_t slots)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      Slots(slots)
+{
+    spdlog::info("tParticleReadback: Initializing with {} slots...", slots);
+    createPipeline();
+    vk::SemaphoreTypeCreateInfo timelineTypeInfo{vk::SemaphoreType::eTimeline};
+    Timeline = vk::raii::Semaphore(LogicalDevice, vk::SemaphoreCreateInfo{{}, &timelineTypeInfo});
+    spdlog::info("tParticleReadback: Initialized");
+}
+
+tParticleReadback::~tParticleReadback()
+{
+    // The GPU may still write into slots in flight; their callbacks are dropped.
+    const vk::Semaphore semaphores[] = {*Timeline};
+    const uint64_t values[] = {LastValue};
+    if (LogicalDevice.waitSemaphores(vk::SemaphoreWaitInfo{{}, 1, semaphores, values}, UINT64_MAX) !=
+        vk::Result::eSuccess)
+    {
+        spdlog::warn("tParticleReadback: Waiting for slots in flight failed");
+    }
+    spdlog::info("tParticleReadback: Destroyed");
+}
+
+void tParticleReadback::request(const tRequest &request, tCallback callback)
+{
+    if (request.Stride == 0)
+        throw std::invalid_argument("tParticleReadback: stride must be at least 1");
+    Pending.push_back({request, std::move(callback)});
+}
+
+bool tParticleReadback::isIdle() const
+{
+    return Pending.empty() &&
+           std::ranges::all_of(Slots, [](const tSlot &slot) { return slot.State == tState::Free; });
+}
+
+void tParticleReadback::recordReadbacks(const vk::raii::CommandBuffer &commandBuffer,
+                                        const tPhysics::tParticleBuffers &buffers,
+                                        const vk::DeviceAddress ids,
+                                        const uint32_t capacity,
+                                        const vk::DeviceAddress particleCount,
+                                        const uint64_t step)
+{
+    if (Pending.empty())
+        return;
+
+    ZoneScopedN("tParticleReadback: recordReadbacks()");
+    TracyVkNamedZone(TracyContext, tracyReadbackZone, *commandBuffer, "Particle Readback", true);
+    bool recorded = false;
+    for (auto &slot : Slots)
+    {
+        if (Pending.empty())
+            break;
+        if (slot.State != tState::Free)
+            continue;
+
+        auto [request, callback] = std::move(Pending.front());
+        Pending.pop_front();
+        // The live count is only known on the GPU, so the slot holds whatever the capacity allows.
+        const uint32_t available =
+            request.First < capacity ? (capacity - request.First + request.Stride - 1) / request.Stride : 0u;
+        const uint32_t maxRecords = std::min(request.Count, available);
+        reserve(slot, maxRecords);
+        slot.State = tState::Recorded;
+        slot.Step = step;
+        slot.Request = request;
+        slot.Callback = std::move(callback);
+        slot.MaxRecords = maxRecords;
+
+        const GatherPushConstants pc{buffers.Positions.Address,
+                                     buffers.Velocities.Address,
+                                     ids,
+                                     particleCount,
+                                     slot.Address,
+                                     slot.Address + HeaderSize + maxRecords * sizeof(tParticle),
+                                     request.First,
+                                     request.Stride,
+                                     maxRecords,
+                                     0u};
+        const vk::PushConstantsInfo pushConstantsInfo{
+            *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+        commandBuffer.pushConstants2(pushConstantsInfo);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, GatherPipeline);
+        commandBuffer.dispatch(std::max((maxRecords + LocalSize - 1) / LocalSize, 1u), 1, 1);
+        recorded = true;
+    }
+    if (recorded)
+    {
+        recordComputeToHostBarrier(commandBuffer);
+    }
+}
+
+void tParticleReadback::submit()
+{
+    const bool recorded =
+        std::ranges::any_of(Slots, [](const tSlot &slot) { return slot.State == tState::Recorded; });
+    if (!recorded)
+        return;
+
+    // Signal operations cover all work submitted to the queue before them, so an empty batch suffices.
+    ++LastValue;
+    for (auto &slot : Slots)
+    {
+        if (slot.State == tState::Recorded)
+        {
+            slot.State = tState::InFlight;
+            slot.Value = LastValue;
+        }
+    }
+    vk::SemaphoreSubmitInfo signalInfo(Timeline, LastValue, vk::PipelineStageFlagBits2::eAllCommands, 0);
+    vk::SubmitInfo2 si{};
+    si.setSignalSemaphoreInfos(signalInfo);
+    Device.getComputeQueue().submit2(si);
+}
+
+void tParticleReadback::poll()
+{
+    if (std::ranges::none_of(Slots, [](const tSlot &slot) { return slot.State == tState::InFlight; }))
+        return;
+
+    ZoneScopedN("tParticleReadback: poll()");
+    const uint64_t completed = Timeline.getCounterValue();
+    // Oldest first, so consumers see snapshots in step order.
+    std::vector<tSlot *> ready;
+    for (auto &slot : Slots)
+    {
+        if (slot.State == tState::InFlight && slot.Value <= completed)
+        {
+            ready.push_back(&slot);
+        }
+    }
+    std::ranges::sort(ready, [](const tSlot *a, const tSlot *b) { return a->Value < b->Value; });
+
+    for (auto *slot : ready)
+    {
+        uint32_t written = 0;
+        std::memcpy(&written, slot->Mapped, sizeof(written));
+        written = std::min(written, slot->MaxRecords);
+        const auto *particles = reinterpret_cast<const tParticle *>(slot->Mapped + HeaderSize);
+        const auto *ids = reinterpret_cast<const uint32_t *>(slot->Mapped + HeaderSize +
+                                                             slot->MaxRecords * sizeof(tParticle));
+        auto callback = std::move(slot->Callback);
+        const tSnapshot snapshot{slot->Step, slot->Request, {particles, written}, {ids, written}};
+        slot->State = tState::Free;
+        slot->Callback = nullptr;
+        if (callback)
+        {
+            callback(snapshot);
+        }
+    }
+}
+
+void tParticleReadback::drain()
+{
+    const vk::Semaphore semaphores[] = {*Timeline};
+    const uint64_t values[] = {LastValue};
+    if (LogicalDevice.waitSemaphores(vk::SemaphoreWaitInfo{{}, 1, semaphores, values}, UINT64_MAX) !=
+        vk::Result::eSuccess)
+    {
+        throw std::runtime_error("tParticleReadback: Waiting for slots in flight failed");
+    }
+    poll();
+}
+
+void tParticleReadback::reserve(tSlot &slot, const uint32_t records) const
+{
+    const vk::DeviceSize size = HeaderSize + std::max(records, 1u) * RecordSize;
+    if (slot.Size >= size)
+        return;
+
+    // Reads from uncached memory crawl, so the host-cached types come first; every desktop driver has one that is
+    // also coherent.
+    const vk::DeviceSize capacity = std::max(size, 2 * slot.Size);
+    const auto usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+    const auto coherent = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+    void *mapped = nullptr;
+    slot.Buffer = nullptr;
+    slot.Memory = nullptr;
+    try
+    {
+        std::tie(slot.Buffer, slot.Memory, mapped) =
+            createBuffer(Device,
+                         capacity,
+                         usage,
+                         vk::SharingMode::eExclusive,
+                         coherent | vk::MemoryPropertyFlagBits::eHostCached,
+                         nullptr,
+                         "tParticleReadback");
+    }
+    catch (const std::runtime_error &)
+    {
+        spdlog::warn("tParticleReadback: No host-cached coherent memory, reading back from uncached memory");
+        std::tie(slot.Buffer, slot.Memory, mapped) = createBuffer(
+            Device, capacity, usage, vk::SharingMode::eExclusive, coherent, nullptr, "tParticleReadback");
+    }
+    slot.Size = capacity;
+    slot.Mapped = static_cast<const char *>(mapped);
+    slot.Address = LogicalDevice.getBufferAddress(vk::BufferDeviceAddressInfo{*slot.Buffer});
+}
+
+void tParticleReadback::createPipeline()
+{
+    spdlog::info("tParticleReadback: Creating compute pipeline...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(GatherPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+    const auto &cache = Device.getPipelineCache();
+    GatherPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "readbackGather.comp.spv");
+    spdlog::info("tParticleReadback: Compute pipeline created");
+}
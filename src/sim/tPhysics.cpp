@@ -1,54 +1,158 @@
 #include "sim/tPhysics.h"
 
-#include <random>
+#include <algorithm>
+#include <stdexcept>
 
 #include <tracy/Tracy.hpp>
 
 #include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
 #include "helpers/createBuffer.h"
+#include "helpers/createPipeline.h"
 #include "helpers/loadShaders.h"
 #include "sim/constants.h"
-#include "sim/tParticle.h"
+#include "sim/tParticlePool.h"
 
-tPhysics::tPhysics(const tVulkanDevice &device, const vk::raii::DescriptorSetLayout &descriptorLayout)
+namespace
+{
+struct ForcePushConstants
+{
+    vk::DeviceAddress accelerations;
+    vk::DeviceAddress activeIndices;
+    vk::DeviceAddress activeCount;
+    vk::DeviceAddress particleCount;
+    uint32_t useActiveList;
+    uint32_t pad0;
+};
+
+struct InitialPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t model;
+    uint32_t seedLo;
+    uint32_t seedHi;
+    float particleMass;
+    float scaleRadius;
+    float truncationRadius;
+    float diskScaleHeight;
+    float diskDispersion;
+    float diskInclination;
+    float mergerSeparation;
+    float mergerImpactParameter;
+    float mergerInclination;
+};
+
+struct ClusterBoundsPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress bounds;
+    vk::DeviceAddress particleCount;
+    uint32_t clusterCount;
+    uint32_t pad0;
+};
+
+constexpr uint32_t InitialLocalSize = 256;
+} // namespace
+
+tPhysics::tPhysics(const tVulkanDevice &device,
+                   const vk::raii::DescriptorSetLayout &descriptorLayout,
+                   const uint32_t capacity,
+                   const tKernel kernel,
+                   const tInitialConditions &initialConditions)
     : Device(device), LogicalDevice(device.getLogicalDevice()), PhysicalDevice(device.getPhysicalDevice()),
-      TracyContext(device.getTracyContext())
+      TracyContext(device.getComputeTracyContext()), Kernel(kernel), Capacity(std::max(capacity, NUM_PARTICLES)),
+      InitialConditions(initialConditions)
 {
-    spdlog::info("tPhysics: Initializing...");
+    // Fixed-point mass deposits are scaled by getMaxTotalMass().
+    if (InitialConditions.ParticleMass > MaxParticleMass)
+        throw std::invalid_argument("tPhysics: initial particle mass exceeds MaxParticleMass");
+    spdlog::info("tPhysics: Initializing for {} slots...", Capacity);
     createShaderModules();
     createPhysicsPipeline(descriptorLayout);
+    createInitialPipeline();
+    createClusterBoundsPipeline();
     createBuffers();
     spdlog::info("tPhysics: Initialized");
 }
 
-void tPhysics::swapParticleBuffers()
-{
-    spdlog::trace("tPhysics: Swapping read/write particle buffers...");
-    std::swap(ParticleBufferA, ParticleBufferB);
-    spdlog::trace("tPhysics: Swapped read/write particle buffers");
-}
-
 void tPhysics::updateParams(const tPhysics::tParams &params)
 {
     ZoneScopedN("tPhysics: updateParams()");
     spdlog::trace("tPhysics: Updating params...");
-    CachedParams.DeltaTime = params.DeltaTime;
+    CachedParams = params;
     std::memcpy(MappedParamsData, &CachedParams, sizeof(tParams));
     spdlog::trace("tPhysics: Updated params");
 }
 
-void tPhysics::recordPhysicsPass(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set) const
+void tPhysics::recordPhysicsPass(const vk::raii::CommandBuffer &commandBuffer,
+                                 const vk::raii::DescriptorSet &set,
+                                 const vk::DeviceAddress accelerations,
+                                 const vk::DeviceAddress particleCount,
+                                 const tActiveList &active) const
 {
     ZoneScopedN("tPhysics: recordPhysicsPass()");
     spdlog::trace("tPhysics: Recording physics pass...");
     TracyVkNamedZone(TracyContext, tracyPhysicsZone, *commandBuffer, "Physics Dispatch", true);
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, PhysicsPipeline);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, getActivePipeline());
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, PhysicsPipelineLayout, 0, *set, {});
-    const uint32_t dispatchX = (NUM_PARTICLES + LocalSize - 1) / LocalSize;
-    commandBuffer.dispatch(dispatchX, 1, 1);
+    const ForcePushConstants pc{
+        accelerations, active.Indices, active.Count, particleCount, active.isAll() ? 0u : 1u, 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PhysicsPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatchIndirect(active.Dispatch, active.DispatchOffset);
     spdlog::trace("tPhysics: Recorded compute pass");
 }
 
+void tPhysics::recordClusterBounds(const vk::raii::CommandBuffer &commandBuffer,
+                                   const vk::DeviceAddress particleCount) const
+{
+    ZoneScopedN("tPhysics: recordClusterBounds()");
+    TracyVkNamedZone(TracyContext, tracyClusterBoundsZone, *commandBuffer, "Cluster Bounds", true);
+    const auto &buffers = getBuffersB();
+    const ClusterBoundsPushConstants pc{
+        buffers.Positions.Address, buffers.ClusterBounds.Address, particleCount, getClusterCount(), 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *ClusterBoundsPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, ClusterBoundsPipeline);
+    // One workgroup of ClusterSize invocations per cluster.
+    commandBuffer.dispatch(getClusterCount(), 1, 1);
+}
+
+std::shared_ptr<void> tPhysics::grow(const uint32_t capacity)
+{
+    spdlog::info("tPhysics: Growing from {} to {} slots", Capacity, capacity);
+    auto retired = std::make_shared<std::array<tParticleBuffers, 2>>(std::move(Buffers));
+    GrowthPositions = *(*retired)[Parity].Positions.Buffer;
+    GrowthVelocities = *(*retired)[Parity].Velocities.Buffer;
+    GrowthSourceSize = Capacity * sizeof(glm::vec4);
+    Capacity = capacity;
+    createParticleBuffers();
+    return retired;
+}
+
+void tPhysics::recordGrowth(const vk::raii::CommandBuffer &commandBuffer) const
+{
+    if (!GrowthPositions)
+        return;
+
+    // New slots are free: no mass, parked at the origin.
+    const vk::BufferCopy region{0, 0, GrowthSourceSize};
+    const auto &buffers = getBuffersA();
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.copyBuffer(GrowthPositions, *buffers.Positions.Buffer, region);
+    commandBuffer.copyBuffer(GrowthVelocities, *buffers.Velocities.Buffer, region);
+    commandBuffer.fillBuffer(*buffers.Positions.Buffer, GrowthSourceSize, VK_WHOLE_SIZE, 0u);
+    commandBuffer.fillBuffer(*buffers.Velocities.Buffer, GrowthSourceSize, VK_WHOLE_SIZE, 0u);
+    recordTransferToComputeBarrier(commandBuffer);
+    GrowthPositions = nullptr;
+    GrowthVelocities = nullptr;
+}
+
 void tPhysics::createBuffers()
 {
     spdlog::info("tPhysics: Creating buffers...");
@@ -58,54 +162,113 @@ void tPhysics::createBuffers()
                      vk::BufferUsageFlagBits::eUniformBuffer,
                      vk::SharingMode::eExclusive,
                      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                     nullptr);
-
-    std::vector<tParticle> particles(NUM_PARTICLES);
-    std::mt19937 rng(12345);
-    std::uniform_real_distribution<float> dist(-1.f, 1.f);
-    for (auto &p : particles)
-    {
-        glm::vec3 pos = glm::normalize(glm::vec3(dist(rng) * 2.0f, dist(rng) * 1.4f, dist(rng))) * 2.0f;
-        glm::vec3 vel = glm::normalize(glm::cross(pos, glm::vec3(0.9, 2.0, 0.7))) * 0.2f;
-        p.Position = glm::vec4(pos, 1.0f);
-        p.Velocity = glm::vec4(vel, 0.0f);
-    }
-
-    std::tie(ParticleBufferA, ParticleMemoryA, std::ignore) =
-        createBuffer(Device,
-                     NUM_PARTICLES * sizeof(tParticle),
-                     vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
-                         vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress,
-                     vk::SharingMode::eExclusive,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     particles.data());
-
-    std::tie(ParticleBufferB, ParticleMemoryB, std::ignore) =
-        createBuffer(Device,
-                     NUM_PARTICLES * sizeof(tParticle),
-                     vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
-                         vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress,
-                     vk::SharingMode::eExclusive,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal,
-                     nullptr);
+                     nullptr,
+                     "tPhysics");
+    createParticleBuffers();
     spdlog::info("tPhysics: Buffers created");
 }
 
+void tPhysics::createParticleBuffers()
+{
+    Buffers[0] = createParticleBufferSet();
+    Buffers[1] = createParticleBufferSet();
+    // Without a growth source this is the initial set, generated in place.
+    if (!GrowthPositions)
+        generateInitialParticles();
+}
+
+tPhysics::tParticleBuffers tPhysics::createParticleBufferSet() const
+{
+    const vk::BufferUsageFlags indirect = vk::BufferUsageFlagBits::eIndirectBuffer;
+    tParticleBuffers buffers;
+    buffers.Positions = createStorageBuffer(Device, Capacity * sizeof(glm::vec4), "tPhysics", indirect);
+    buffers.Velocities = createStorageBuffer(Device, Capacity * sizeof(glm::vec4), "tPhysics", indirect);
+    buffers.RenderStream = createStorageBuffer(Device, Capacity * RenderStreamStride, "tPhysics", indirect);
+    buffers.DrawArgs =
+        createStorageBuffer(Device, tParticlePool::CounterWords * sizeof(uint32_t), "tPhysics", indirect);
+    buffers.ClusterBounds = createStorageBuffer(Device, getClusterCount() * sizeof(glm::vec4), "tPhysics");
+    return buffers;
+}
+
+void tPhysics::generateInitialParticles()
+{
+    ZoneScopedN("tPhysics: generateInitialParticles()");
+    const uint32_t count = std::min<uint32_t>(Capacity, NUM_PARTICLES);
+    spdlog::info("tPhysics: Generating {} initial particles on the GPU...", count);
+    const auto &conditions = InitialConditions;
+    const InitialPushConstants pc{getBuffersA().Positions.Address,
+                                  getBuffersA().Velocities.Address,
+                                  count,
+                                  Capacity,
+                                  static_cast<uint32_t>(conditions.Model),
+                                  static_cast<uint32_t>(conditions.Seed),
+                                  static_cast<uint32_t>(conditions.Seed >> 32),
+                                  conditions.ParticleMass,
+                                  conditions.ScaleRadius,
+                                  conditions.TruncationRadius,
+                                  conditions.DiskScaleHeight,
+                                  conditions.DiskDispersion,
+                                  conditions.DiskInclination,
+                                  conditions.MergerSeparation,
+                                  conditions.MergerImpactParameter,
+                                  conditions.MergerInclination};
+
+    auto commandBuffer = Device.beginSingleTimeCommands();
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, InitialPipeline);
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *InitialPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch((Capacity + InitialLocalSize - 1) / InitialLocalSize, 1, 1);
+    Device.endSingleTimeCommands(commandBuffer);
+    spdlog::info("tPhysics: Initial particles generated");
+}
+
 void tPhysics::createPhysicsPipeline(const vk::raii::DescriptorSetLayout &setLayout)
 {
-    spdlog::info("tPhysics: Creating compute pipeline...");
-    vk::PipelineLayoutCreateInfo plci({}, *setLayout);
+    spdlog::info("tPhysics: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(ForcePushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, *setLayout, pcRange);
     PhysicsPipelineLayout = LogicalDevice.createPipelineLayout(plci);
 
-    vk::PipelineShaderStageCreateInfo stageInfo({}, vk::ShaderStageFlagBits::eCompute, PhysicsShader, "main");
-    vk::ComputePipelineCreateInfo cpci({}, stageInfo, PhysicsPipelineLayout);
-    PhysicsPipeline = LogicalDevice.createComputePipeline(nullptr, cpci);
-    spdlog::info("tPhysics: Compute pipeline created");
+    // Both kernels share the layout, so switching at runtime is a different bind only.
+    vk::PipelineShaderStageCreateInfo naiveStage({}, vk::ShaderStageFlagBits::eCompute, NaiveShader, "main");
+    vk::ComputePipelineCreateInfo naiveCpci({}, naiveStage, PhysicsPipelineLayout);
+    NaivePipeline = LogicalDevice.createComputePipeline(Device.getPipelineCache(), naiveCpci);
+
+    vk::PipelineShaderStageCreateInfo tiledStage({}, vk::ShaderStageFlagBits::eCompute, TiledShader, "main");
+    vk::ComputePipelineCreateInfo tiledCpci({}, tiledStage, PhysicsPipelineLayout);
+    TiledPipeline = LogicalDevice.createComputePipeline(Device.getPipelineCache(), tiledCpci);
+    spdlog::info("tPhysics: Compute pipelines created");
+}
+
+void tPhysics::createInitialPipeline()
+{
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(InitialPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    InitialPipelineLayout = LogicalDevice.createPipelineLayout(plci);
+    const auto &cache = Device.getPipelineCache();
+    InitialPipeline = createComputePipeline(LogicalDevice, cache, InitialPipelineLayout, "initialParticles.comp.spv");
+}
+
+void tPhysics::createClusterBoundsPipeline()
+{
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(ClusterBoundsPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    ClusterBoundsPipelineLayout = LogicalDevice.createPipelineLayout(plci);
+    const auto &cache = Device.getPipelineCache();
+    ClusterBoundsPipeline =
+        createComputePipeline(LogicalDevice, cache, ClusterBoundsPipelineLayout, "clusterBounds.comp.spv");
 }
 
 void tPhysics::createShaderModules()
 {
-    spdlog::info("tPhysics: Creating shader module...");
-    PhysicsShader = loadShaderModule(LogicalDevice, "forceNaive.comp.spv");
+    spdlog::info("tPhysics: Creating shader modules...");
+    NaiveShader = loadShaderModule(LogicalDevice, "forceNaive.comp.spv");
+    TiledShader = loadShaderModule(LogicalDevice, "forceTiled.comp.spv");
     spdlog::info("tPhysics: Shader modules created");
 }
+
+const vk::raii::Pipeline &tPhysics::getActivePipeline() const
+{
+    return Kernel == tKernel::Tiled ? TiledPipeline : NaivePipeline;
+}
@@ -0,0 +1,99 @@
+#include "sim/tPrefixScan.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct ScanPushConstants
+{
+    vk::DeviceAddress data;
+    vk::DeviceAddress blockSums;
+    uint32_t count;
+    uint32_t pad0;
+};
+
+uint32_t blockCount(const uint32_t count)
+{
+    return (count + tPrefixScan::BlockSize - 1) / tPrefixScan::BlockSize;
+}
+} // namespace
+
+tPrefixScan::tPrefixScan(const tVulkanDevice &device, const uint32_t maxCount)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), MaxCount(maxCount)
+{
+    spdlog::info("tPrefixScan: Initializing for up to {} values...", MaxCount);
+    createBuffers();
+    createPipelines();
+    spdlog::info("tPrefixScan: Initialized with {} levels", BlockSums.size());
+}
+
+void tPrefixScan::recordScan(const vk::raii::CommandBuffer &commandBuffer,
+                             const vk::DeviceAddress data,
+                             const uint32_t count) const
+{
+    ZoneScopedN("tPrefixScan: recordScan()");
+    if (count > MaxCount)
+        throw std::runtime_error("tPrefixScan: count exceeds the capacity the scan was created with");
+    if (count == 0)
+        return;
+
+    recordLevel(commandBuffer, data, count, 0);
+}
+
+void tPrefixScan::createBuffers()
+{
+    spdlog::info("tPrefixScan: Creating block sum buffers...");
+    uint32_t count = std::max(MaxCount, 1u);
+    do
+    {
+        count = blockCount(count);
+        BlockSums.push_back(createStorageBuffer(Device, count * sizeof(uint32_t), "tPrefixScan"));
+    } while (count > 1);
+    spdlog::info("tPrefixScan: Block sum buffers created");
+}
+
+void tPrefixScan::createPipelines()
+{
+    spdlog::info("tPrefixScan: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(ScanPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    ScanBlocksPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "scanBlocks.comp.spv");
+    AddBlocksPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "scanAddBlocks.comp.spv");
+    spdlog::info("tPrefixScan: Compute pipelines created");
+}
+
+void tPrefixScan::recordLevel(const vk::raii::CommandBuffer &commandBuffer,
+                              const vk::DeviceAddress data,
+                              const uint32_t count,
+                              const size_t level) const
+{
+    const uint32_t groups = blockCount(count);
+    const ScanPushConstants pc{data, BlockSums[level].Address, count, 0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, ScanBlocksPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+
+    if (groups == 1)
+        return;
+
+    recordLevel(commandBuffer, BlockSums[level].Address, groups, level + 1);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, AddBlocksPipeline);
+    commandBuffer.pushConstants2(pushConstantsInfo);
+    commandBuffer.dispatch(groups, 1, 1);
+    recordComputeBarrier(commandBuffer);
+}
@@ -0,0 +1,104 @@
+#include "sim/tRadixSort.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct RadixPushConstants
+{
+    vk::DeviceAddress keysIn;
+    vk::DeviceAddress valuesIn;
+    vk::DeviceAddress keysOut;
+    vk::DeviceAddress valuesOut;
+    vk::DeviceAddress histogram;
+    uint32_t count;
+    uint32_t shift;
+    uint32_t numBlocks;
+    uint32_t pad0;
+};
+} // namespace
+
+tRadixSort::tRadixSort(const tVulkanDevice &device, const uint32_t maxCount)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), MaxCount(std::max(maxCount, 1u)),
+      MaxBlocks((MaxCount + BlockSize - 1) / BlockSize)
+{
+    spdlog::info("tRadixSort: Initializing for up to {} pairs...", MaxCount);
+    createBuffers();
+    createPipelines();
+    Scan = std::make_unique<tPrefixScan>(Device, RadixBins * MaxBlocks);
+    spdlog::info("tRadixSort: Initialized");
+}
+
+void tRadixSort::recordSort(const vk::raii::CommandBuffer &commandBuffer,
+                            const vk::DeviceAddress keys,
+                            const vk::DeviceAddress values,
+                            const uint32_t count,
+                            const uint32_t keyBits) const
+{
+    ZoneScopedN("tRadixSort: recordSort()");
+    if (count > MaxCount)
+        throw std::runtime_error("tRadixSort: count exceeds the capacity the sort was created with");
+    if (count < 2)
+        return;
+
+    const uint32_t numBlocks = (count + BlockSize - 1) / BlockSize;
+    uint32_t passes = (std::min(keyBits, 32u) + RadixBits - 1) / RadixBits;
+    passes += passes % 2;
+
+    for (uint32_t pass = 0; pass < passes; ++pass)
+    {
+        const bool fromCaller = pass % 2 == 0;
+        const RadixPushConstants pc{fromCaller ? keys : ScratchKeys.Address,
+                                    fromCaller ? values : ScratchValues.Address,
+                                    fromCaller ? ScratchKeys.Address : keys,
+                                    fromCaller ? ScratchValues.Address : values,
+                                    Histogram.Address,
+                                    count,
+                                    pass * RadixBits,
+                                    numBlocks,
+                                    0u};
+        const vk::PushConstantsInfo pushConstantsInfo{
+            *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, HistogramPipeline);
+        commandBuffer.pushConstants2(pushConstantsInfo);
+        commandBuffer.dispatch(numBlocks, 1, 1);
+        recordComputeBarrier(commandBuffer);
+
+        Scan->recordScan(commandBuffer, Histogram.Address, RadixBins * numBlocks);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, ScatterPipeline);
+        commandBuffer.pushConstants2(pushConstantsInfo);
+        commandBuffer.dispatch(numBlocks, 1, 1);
+        recordComputeBarrier(commandBuffer);
+    }
+}
+
+void tRadixSort::createBuffers()
+{
+    spdlog::info("tRadixSort: Creating buffers...");
+    ScratchKeys = createStorageBuffer(Device, MaxCount * sizeof(uint32_t), "tRadixSort");
+    ScratchValues = createStorageBuffer(Device, MaxCount * sizeof(uint32_t), "tRadixSort");
+    Histogram = createStorageBuffer(Device, RadixBins * MaxBlocks * sizeof(uint32_t), "tRadixSort");
+    spdlog::info("tRadixSort: Buffers created");
+}
+
+void tRadixSort::createPipelines()
+{
+    spdlog::info("tRadixSort: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(RadixPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    HistogramPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "radixHistogram.comp.spv");
+    ScatterPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "radixScatter.comp.spv");
+    spdlog::info("tRadixSort: Compute pipelines created");
+}
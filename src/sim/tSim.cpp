@@ -1,72 +1,521 @@
 #include "sim/tSim.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <tracy/Tracy.hpp>
 
-tSim::tSim(const tVulkanDevice &device, const uint32_t nrDescriptorSets)
+#include "helpers/barriers.h"
+#include "sim/constants.h"
+
+tSim::tSim(const tVulkanDevice &device,
+           const uint32_t framesInFlight,
+           const tCellGrid::tParams &gridParams,
+           const tParticleMesh::tParams &meshParams,
+           const tInitialConditions &initialConditions)
     : Device(device), LogicalDevice(device.getLogicalDevice()), PhysicalDevice(device.getPhysicalDevice()),
-      NrDescriptorSets(nrDescriptorSets)
+      FramesInFlight(framesInFlight)
 {
     spdlog::info("tSim: Initializing...");
     createDescriptorSetLayout();
+    EwaldTable = std::make_unique<tEwaldTable>(Device);
+    Physics = std::make_unique<tPhysics>(
+        Device, DescriptorLayout, NUM_PARTICLES, tPhysics::tKernel::Tiled, initialConditions);
     createDescriptorSets();
-    Physics = std::make_unique<tPhysics>(Device, DescriptorLayout);
+    writeDescriptorSets();
+    const uint32_t capacity = Physics->getCapacity();
+    Pool = std::make_unique<tParticlePool>(Device, DescriptorLayout, NUM_PARTICLES, capacity, FramesInFlight + 1);
+    Reorder = std::make_unique<tMortonReorder>(Device, capacity);
+    StateHash = std::make_unique<tStateHash>(Device, MaxCapacity, Pool->getReadbackSlots());
+    Diagnostics = std::make_unique<tDiagnostics>(Device, MaxCapacity, Pool->getReadbackSlots());
+    Readbacks.resize(Pool->getReadbackSlots());
+    ParticleReadback = std::make_unique<tParticleReadback>(Device, Pool->getReadbackSlots());
+    Integrator = std::make_unique<tIntegrator>(Device, DescriptorLayout, capacity);
+    BlockTimesteps = std::make_unique<tBlockTimesteps>(Device, DescriptorLayout, capacity);
+    BarnesHut = std::make_unique<tBarnesHut>(Device, DescriptorLayout, capacity);
+    CellGrid = std::make_unique<tCellGrid>(Device, DescriptorLayout, capacity, gridParams);
+    ParticleMesh =
+        std::make_unique<tParticleMesh>(Device, DescriptorLayout, capacity, Physics->getMaxTotalMass(), meshParams);
     spdlog::info("tSim: Initialized");
 }
 
-void tSim::recordComputePass(const vk::raii::CommandBuffer &commandBuffer, const size_t ixImage) const
+void tSim::setParticleMeshGridSize(const uint32_t gridSize)
+{
+    if (gridSize == getParticleMeshGridSize())
+        return;
+
+    tParticleMesh::tParams params = ParticleMesh->getParams();
+    params.GridSize = gridSize;
+    LogicalDevice.waitIdle();
+    ParticleMesh.reset();
+    ParticleMesh = std::make_unique<tParticleMesh>(
+        Device, DescriptorLayout, getCapacity(), Physics->getMaxTotalMass(), params);
+    ForcesCurrent = false;
+}
+
+void tSim::updateParams(const tPhysics::tParams &physicsParams)
+{
+    tPhysics::tParams stepParams = physicsParams;
+    Substeps = 1;
+    if (Deterministic)
+    {
+        // Lock-step: simulated time no longer follows the frame time, so no run-to-run timing leaks into the state.
+        stepParams.DeltaTime = FixedTimestep.DeltaTime;
+    }
+    else if (FixedTimestep.Enabled)
+    {
+        Substeps = takeSubsteps(Accumulator, physicsParams.DeltaTime, FixedTimestep);
+        stepParams.DeltaTime = FixedTimestep.DeltaTime;
+    }
+    // Only the direct solver has periodic forces; wrapping positions under an open-boundary solver would flip the
+    // pull on every particle that crosses a face.
+    stepParams.BoxSize = Solver == tSolver::Direct ? BoxSize : 0.f;
+    Physics->updateParams(stepParams);
+
+    // Emission follows simulated time, which falls behind the frame time once the substep limit is hit.
+    PendingEmission += EmissionRate * stepParams.DeltaTime * static_cast<float>(Substeps);
+    EmitCount = static_cast<uint32_t>(PendingEmission);
+    PendingEmission -= static_cast<float>(EmitCount);
+}
+
+void tSim::setFixedTimestep(const tFixedTimestep &params)
+{
+    FixedTimestep = params;
+    FixedTimestep.DeltaTime = std::max(FixedTimestep.DeltaTime, 1e-6f);
+    FixedTimestep.MaxSubsteps = std::max(FixedTimestep.MaxSubsteps, 1u);
+    Accumulator = 0.f;
+}
+
+uint32_t tSim::takeSubsteps(float &accumulator, const float frameTime, const tFixedTimestep &params)
+{
+    accumulator += frameTime;
+    const auto steps = static_cast<uint32_t>(std::floor(accumulator / params.DeltaTime));
+    if (steps > params.MaxSubsteps)
+    {
+        // Behind by more than the limit: drop the backlog instead of trying to catch up with ever longer frames.
+        accumulator = 0.f;
+        return params.MaxSubsteps;
+    }
+    accumulator -= static_cast<float>(steps) * params.DeltaTime;
+    return steps;
+}
+
+void tSim::updatePool()
+{
+    ZoneScopedN("tSim: updatePool()");
+    ParticleReadback->poll();
+    const uint32_t slots = Pool->getReadbackSlots();
+    // The slot the next frame overwrites was written slots frames ago, so that frame has finished.
+    if (FrameIndex >= slots)
+    {
+        const auto slot = static_cast<uint32_t>(FrameIndex % slots);
+        LastCounters = Pool->readCounters(slot);
+        auto &readback = Readbacks[slot];
+        if (readback.Hash)
+        {
+            LastStepHash = tStepHash{readback.Step, StateHash->readHash(slot)};
+            StepHashes.push_back(*LastStepHash);
+            if (StepHashes.size() > MaxStepHashes)
+            {
+                StepHashes.pop_front();
+            }
+        }
+        if (readback.Diagnostics)
+        {
+            const auto record = Diagnostics->readRecord(slot);
+            DiagnosticsHistory.push_back(tDiagnostics::tSample::fromRecord(record, readback.Step));
+            if (DiagnosticsHistory.size() > MaxDiagnosticsHistory)
+            {
+                DiagnosticsHistory.pop_front();
+            }
+        }
+        readback = {};
+    }
+    while (!Retired.empty() && Retired.front().first + slots <= FrameIndex)
+    {
+        Retired.pop_front();
+    }
+
+    // The counters lag by up to slots frames, and emission keeps going until a bigger pool is in use.
+    const uint32_t reserve = 2 * slots * EmitCount;
+    const uint32_t capacity = getCapacity();
+    if (LastCounters.getAlive() + reserve <= capacity || capacity >= MaxCapacity)
+        return;
+
+    uint32_t newCapacity = capacity;
+    while (newCapacity < LastCounters.getAlive() + reserve && newCapacity < MaxCapacity)
+    {
+        newCapacity *= 2;
+    }
+    grow(std::min(newCapacity, MaxCapacity));
+}
+
+void tSim::requestSnapshot(const tParticleReadback::tRequest &request, tParticleReadback::tCallback callback)
+{
+    ParticleReadback->request(request, std::move(callback));
+}
+
+void tSim::setSnapshotStream(const uint32_t interval,
+                             const tParticleReadback::tRequest &request,
+                             tParticleReadback::tCallback callback)
+{
+    SnapshotInterval = callback ? interval : 0;
+    SnapshotRequest = request;
+    SnapshotCallback = std::move(callback);
+}
+
+std::vector<tSim::tStepHash> tSim::takeStepHashes()
+{
+    std::vector<tStepHash> hashes(StepHashes.begin(), StepHashes.end());
+    StepHashes.clear();
+    return hashes;
+}
+
+void tSim::grow(const uint32_t capacity)
+{
+    ZoneScopedN("tSim: grow()");
+    spdlog::info("tSim: Growing capacity from {} to {}", getCapacity(), capacity);
+    // Frames in flight keep using the old resources, so they are retired instead of waiting for the device.
+    const auto retire = [this](std::shared_ptr<void> resources) {
+        Retired.emplace_back(FrameIndex, std::move(resources));
+    };
+    retire(Physics->grow(capacity));
+    // Frames in flight still bind the sets of the old buffers, so the new buffers get sets of their own.
+    retire(std::make_shared<std::pair<vk::raii::DescriptorPool, vk::raii::DescriptorSets>>(std::move(DescriptorPool),
+                                                                                          std::move(DescriptorSets)));
+    createDescriptorSets();
+    writeDescriptorSets();
+    retire(Pool->grow(capacity));
+
+    auto reorder = std::make_unique<tMortonReorder>(Device, capacity);
+    retire(std::shared_ptr<tMortonReorder>(std::move(Reorder)));
+    Reorder = std::move(reorder);
+
+    auto integrator = std::make_unique<tIntegrator>(Device, DescriptorLayout, capacity, Integrator->getScheme());
+    retire(std::shared_ptr<tIntegrator>(std::move(Integrator)));
+    Integrator = std::move(integrator);
+
+    auto blockTimesteps =
+        std::make_unique<tBlockTimesteps>(Device, DescriptorLayout, capacity, BlockTimesteps->getParams());
+    retire(std::shared_ptr<tBlockTimesteps>(std::move(BlockTimesteps)));
+    BlockTimesteps = std::move(blockTimesteps);
+
+    auto barnesHut = std::make_unique<tBarnesHut>(Device, DescriptorLayout, capacity);
+    barnesHut->setOpeningAngle(BarnesHut->getOpeningAngle());
+    retire(std::shared_ptr<tBarnesHut>(std::move(BarnesHut)));
+    BarnesHut = std::move(barnesHut);
+
+    auto cellGrid = std::make_unique<tCellGrid>(Device, DescriptorLayout, capacity, CellGrid->getParams());
+    retire(std::shared_ptr<tCellGrid>(std::move(CellGrid)));
+    CellGrid = std::move(cellGrid);
+
+    auto particleMesh = std::make_unique<tParticleMesh>(
+        Device, DescriptorLayout, capacity, Physics->getMaxTotalMass(), ParticleMesh->getParams());
+    retire(std::shared_ptr<tParticleMesh>(std::move(ParticleMesh)));
+    ParticleMesh = std::move(particleMesh);
+
+    ForcesCurrent = false;
+}
+
+void tSim::setSolver(const tSolver solver)
+{
+    // Solvers differ in softening and boundaries, so cached forces of another solver are not reused.
+    Solver = solver;
+    ForcesCurrent = false;
+}
+
+void tSim::setBoxSize(const float boxSize)
+{
+    const float size = std::max(boxSize, 0.f);
+    if (size == BoxSize)
+        return;
+
+    // Forces of the old boundaries are not reused.
+    BoxSize = size;
+    ForcesCurrent = false;
+}
+
+void tSim::setIntegrator(const tIntegrator::tScheme scheme)
+{
+    Integrator->setScheme(scheme);
+    ForcesCurrent = false;
+}
+
+void tSim::setBlockTimestepsEnabled(const bool enabled)
+{
+    // Levels are reassigned from fresh forces when block steps start.
+    BlockTimestepsEnabled = enabled;
+    ForcesCurrent = false;
+}
+
+void tSim::setBlockTimestepParams(const tBlockTimesteps::tParams &params)
+{
+    BlockTimesteps->setParams(params);
+    ForcesCurrent = false;
+}
+
+void tSim::recordComputePass(const vk::raii::CommandBuffer &commandBuffer, const size_t ixImage)
 {
     ZoneScopedN("tSim: recordComputePass()");
     spdlog::trace("tSim: Recording compute pass at index {}...", ixImage);
-    const auto &set = DescriptorSets[ixImage];
-    updateDescriptorSetForFrame(set);
+    const auto &set = getDescriptorSet();
+    Physics->recordGrowth(commandBuffer);
+    Pool->recordGrowth(commandBuffer);
+    recordBeginStep(commandBuffer, set);
+
+    // Killed and emitted particles have no forces yet, so the cached ones are dropped for this step.
+    if (Substeps > 0 && (EmitCount > 0 || KillRadius > 0.f))
+    {
+        const auto seed = static_cast<uint32_t>(FrameIndex);
+        Pool->recordKillAndEmit(commandBuffer, set, KillRadius, EmitCount, seed, Deterministic);
+        ForcesCurrent = false;
+    }
+
+    // Substeps continue in place on the write set, separated by barriers, so one submit advances the state by all
+    // of them and the read set stays untouched for the frame still being drawn.
+    for (uint32_t substep = 0; substep < Substeps; ++substep)
+    {
+        recordStep(commandBuffer, set, substep + 1 == Substeps ? getRenderStreamAddress() : 0);
+    }
+    if (Substeps == 0 && getRenderStreamAddress() != 0)
+    {
+        // Nothing stepped, so an empty kick packs the render stream of the unchanged state.
+        const tIntegrator::tStage pack{tIntegrator::tStageType::Kick, 0.f, 0.f};
+        Integrator->recordStage(commandBuffer, set, pack, Pool->getLiveList(), getRenderStreamAddress());
+        recordComputeBarrier(commandBuffer);
+    }
+    // Only the task shader reads the bounds, behind the compute to graphics barrier or hand-over.
+    Physics->recordClusterBounds(commandBuffer, Pool->getCountAddress());
 
-    Physics->recordPhysicsPass(commandBuffer, set);
+    const auto slot = static_cast<uint32_t>(FrameIndex % Pool->getReadbackSlots());
+    StepCount += Substeps;
+    auto &readback = Readbacks[slot];
+    readback = {StepCount, Deterministic && Substeps > 0, DiagnosticsEnabled};
+    if (readback.Hash)
+    {
+        StateHash->recordHash(commandBuffer, Physics->getBuffersB(), getCapacity(), Pool->getCountAddress(), slot);
+    }
+    if (readback.Diagnostics)
+    {
+        Diagnostics->recordDiagnostics(
+            commandBuffer, Physics->getBuffersB(), getCapacity(), Pool->getCountAddress(), PotentialSamples, slot);
+    }
+    if (SnapshotInterval > 0 && FrameIndex % SnapshotInterval == 0)
+    {
+        ParticleReadback->request(SnapshotRequest, SnapshotCallback);
+    }
+    ParticleReadback->recordReadbacks(commandBuffer,
+                                      Physics->getBuffersB(),
+                                      Pool->getIdsAddress(),
+                                      getCapacity(),
+                                      Pool->getCountAddress(),
+                                      StepCount);
+    Pool->recordReadback(commandBuffer, slot);
+    Pool->recordCounterSnapshot(commandBuffer, Physics->getBuffersB().DrawArgs.Buffer);
+    ++FrameIndex;
     spdlog::trace("tSim: Recorded compute pass");
 }
 
+void tSim::recordStep(const vk::raii::CommandBuffer &commandBuffer,
+                      const vk::raii::DescriptorSet &set,
+                      const vk::DeviceAddress renderStream)
+{
+    if (CellGridEnabled)
+    {
+        CellGrid->recordBuildPass(commandBuffer, set);
+        recordComputeBarrier(commandBuffer);
+    }
+
+    if (BlockTimestepsEnabled)
+    {
+        recordBlockStep(commandBuffer, set, renderStream);
+    }
+    else
+    {
+        const auto live = Pool->getLiveList();
+        if (Integrator->reusesForces() && !ForcesCurrent)
+        {
+            recordForcePass(commandBuffer, set, live);
+            recordComputeBarrier(commandBuffer);
+        }
+
+        // Every scheme ends with a kick or drift, which leaves the final state of the step in the render stream.
+        const auto &stages = Integrator->getStages();
+        for (const auto &stage : stages)
+        {
+            if (stage.Type == tIntegrator::tStageType::Force)
+            {
+                recordForcePass(commandBuffer, set, live);
+            }
+            else
+            {
+                const bool last = &stage == &stages.back();
+                Integrator->recordStage(commandBuffer, set, stage, live, last ? renderStream : 0);
+            }
+            recordComputeBarrier(commandBuffer);
+        }
+        ForcesCurrent = Integrator->reusesForces();
+    }
+}
+
+void tSim::recordBeginStep(const vk::raii::CommandBuffer &commandBuffer, const vk::raii::DescriptorSet &set)
+{
+    if (Substeps > 0 && ReorderInterval > 0 && FrameIndex % ReorderInterval == 0)
+    {
+        // Accelerations and block levels are stored per slot, so they are recomputed after the slots move.
+        Reorder->recordReorder(commandBuffer, set, Physics->getBuffersA(), Physics->getBuffersB(), *Pool);
+        ForcesCurrent = false;
+        return;
+    }
+
+    // The step works in place on the write buffer, starting from a copy of the read buffer.
+    recordComputeToTransferBarrier(commandBuffer);
+    const auto &source = Physics->getBuffersA();
+    const auto &destination = Physics->getBuffersB();
+    const vk::BufferCopy region{0, 0, getCapacity() * sizeof(glm::vec4)};
+    commandBuffer.copyBuffer(*source.Positions.Buffer, *destination.Positions.Buffer, region);
+    commandBuffer.copyBuffer(*source.Velocities.Buffer, *destination.Velocities.Buffer, region);
+    recordTransferToComputeBarrier(commandBuffer);
+}
+
+vk::DeviceAddress tSim::getRenderStreamAddress() const
+{
+    return isRenderStreamEnabled() ? Physics->getBuffersB().RenderStream.Address : 0;
+}
+
+void tSim::recordForcePass(const vk::raii::CommandBuffer &commandBuffer,
+                           const vk::raii::DescriptorSet &set,
+                           const tActiveList &active) const
+{
+    const auto accelerations = Integrator->getAccelerationAddress();
+    if (Solver == tSolver::BarnesHut)
+    {
+        BarnesHut->recordBarnesHutPass(commandBuffer, set, accelerations, active);
+    }
+    else if (Solver == tSolver::ParticleMesh)
+    {
+        // The mesh solve is global; inactive particles get their accelerations refreshed too, which is harmless
+        // because they are only read again at their own next sync point.
+        ParticleMesh->recordParticleMeshPass(commandBuffer, set, accelerations);
+    }
+    else
+    {
+        Physics->recordPhysicsPass(commandBuffer, set, accelerations, Pool->getCountAddress(), active);
+    }
+}
+
+void tSim::recordBlockStep(const vk::raii::CommandBuffer &commandBuffer,
+                           const vk::raii::DescriptorSet &set,
+                           const vk::DeviceAddress renderStream)
+{
+    ZoneScopedN("tSim: recordBlockStep()");
+    const auto accelerations = Integrator->getAccelerationAddress();
+    const auto live = Pool->getLiveList();
+    if (!ForcesCurrent)
+    {
+        recordForcePass(commandBuffer, set, live);
+        recordComputeBarrier(commandBuffer);
+        BlockTimesteps->recordKick(commandBuffer, set, accelerations, 0, tBlockTimesteps::KickReassign, live);
+        recordComputeBarrier(commandBuffer);
+    }
+    BlockTimesteps->recordKick(commandBuffer, set, accelerations, 0, tBlockTimesteps::KickOpening, live);
+    recordComputeBarrier(commandBuffer);
+
+    // Every level is in sync again after the last substep, so the frame ends with closed steps.
+    const uint32_t substeps = BlockTimesteps->getSubsteps();
+    const tIntegrator::tStage drift{tIntegrator::tStageType::Drift, 0.f, 1.f / static_cast<float>(substeps)};
+    for (uint32_t syncTime = 1; syncTime <= substeps; ++syncTime)
+    {
+        Integrator->recordStage(commandBuffer, set, drift, live);
+        recordComputeBarrier(commandBuffer);
+        if (syncTime < substeps)
+        {
+            const auto active = BlockTimesteps->recordCompaction(commandBuffer, syncTime, live);
+            recordForcePass(commandBuffer, set, active);
+            recordComputeBarrier(commandBuffer);
+            BlockTimesteps->recordKick(commandBuffer,
+                                       set,
+                                       accelerations,
+                                       syncTime,
+                                       tBlockTimesteps::KickClosing | tBlockTimesteps::KickReassign |
+                                           tBlockTimesteps::KickOpening,
+                                       active);
+        }
+        else
+        {
+            recordForcePass(commandBuffer, set, live);
+            recordComputeBarrier(commandBuffer);
+            BlockTimesteps->recordKick(commandBuffer,
+                                       set,
+                                       accelerations,
+                                       0,
+                                       tBlockTimesteps::KickClosing | tBlockTimesteps::KickReassign,
+                                       live,
+                                       renderStream);
+        }
+        recordComputeBarrier(commandBuffer);
+    }
+    ForcesCurrent = true;
+}
+
 void tSim::createDescriptorSets()
 {
-    spdlog::info("tSim: Creating {} descriptor sets...", NrDescriptorSets);
-    vk::DescriptorPoolSize paramsPoolSize{vk::DescriptorType::eUniformBuffer, 1u * NrDescriptorSets};
-    vk::DescriptorPoolSize buffersPoolSize{vk::DescriptorType::eStorageBuffer, 2u * NrDescriptorSets};
-    std::array poolSizes{paramsPoolSize, buffersPoolSize};
+    spdlog::info("tSim: Creating {} descriptor sets...", ParitySets);
+    vk::DescriptorPoolSize paramsPoolSize{vk::DescriptorType::eUniformBuffer, 1u * ParitySets};
+    vk::DescriptorPoolSize buffersPoolSize{vk::DescriptorType::eStorageBuffer, 2u * ParitySets};
+    vk::DescriptorPoolSize ewaldPoolSize{vk::DescriptorType::eCombinedImageSampler, 1u * ParitySets};
+    std::array poolSizes{paramsPoolSize, buffersPoolSize, ewaldPoolSize};
     vk::DescriptorPoolCreateInfo dpci{vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-                                      NrDescriptorSets,
+                                      ParitySets,
                                       static_cast<uint32_t>(poolSizes.size()),
                                       poolSizes.data()};
     DescriptorPool = vk::raii::DescriptorPool(LogicalDevice, dpci);
 
-    std::vector<vk::DescriptorSetLayout> layouts(NrDescriptorSets, *DescriptorLayout);
+    std::vector<vk::DescriptorSetLayout> layouts(ParitySets, *DescriptorLayout);
     vk::DescriptorSetAllocateInfo dsai{*DescriptorPool, static_cast<uint32_t>(layouts.size()), layouts.data()};
     DescriptorSets = vk::raii::DescriptorSets(LogicalDevice, dsai);
     spdlog::info("tSim: {} Descriptor sets created", DescriptorSets.size());
 }
 
+void tSim::writeDescriptorSets() const
+{
+    spdlog::info("tSim: Writing the descriptor sets of both buffer parities...");
+    // Every pass works on the write set in place: positions at binding 1, velocities at binding 2. Set A is
+    // Physics->getBufferSet(parity), so the set of each parity binds the other one. Nothing here changes from frame
+    // to frame; growth replaces the buffers and with them the sets.
+    vk::DescriptorBufferInfo simInfo{Physics->getParamsBuffer(), 0, sizeof(tPhysics::tParams)};
+    vk::DescriptorImageInfo ewaldInfo{
+        *EwaldTable->getSampler(), *EwaldTable->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal};
+    std::array<vk::DescriptorBufferInfo, ParitySets> positionsInfos;
+    std::array<vk::DescriptorBufferInfo, ParitySets> velocitiesInfos;
+    std::vector<vk::WriteDescriptorSet> writes;
+    const auto storage = vk::DescriptorType::eStorageBuffer;
+    for (uint32_t parity = 0; parity < ParitySets; ++parity)
+    {
+        const auto &buffers = Physics->getBufferSet(parity ^ 1u);
+        const auto set = *DescriptorSets[parity];
+        positionsInfos[parity] = vk::DescriptorBufferInfo{buffers.Positions.Buffer, 0, VK_WHOLE_SIZE};
+        velocitiesInfos[parity] = vk::DescriptorBufferInfo{buffers.Velocities.Buffer, 0, VK_WHOLE_SIZE};
+        writes.push_back(vk::WriteDescriptorSet{set, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &simInfo});
+        writes.push_back(vk::WriteDescriptorSet{set, 1, 0, 1, storage, nullptr, &positionsInfos[parity]});
+        writes.push_back(vk::WriteDescriptorSet{set, 2, 0, 1, storage, nullptr, &velocitiesInfos[parity]});
+        writes.push_back(vk::WriteDescriptorSet{set, 3, 0, 1, vk::DescriptorType::eCombinedImageSampler, &ewaldInfo});
+    }
+    LogicalDevice.updateDescriptorSets(writes, {});
+    spdlog::info("tSim: Wrote the descriptor sets of both buffer parities");
+}
+
 void tSim::createDescriptorSetLayout()
 {
-    spdlog::info("tSim: Creating {} descriptor set layout...", NrDescriptorSets);
+    spdlog::info("tSim: Creating the descriptor set layout of the {} parity sets...", ParitySets);
     const auto simStages = vk::ShaderStageFlagBits::eCompute;
     vk::DescriptorSetLayoutBinding physicsParamsBinding{0, vk::DescriptorType::eUniformBuffer, 1, simStages};
-    vk::DescriptorSetLayoutBinding readParticlesBinding{1, vk::DescriptorType::eStorageBuffer, 1, simStages};
-    vk::DescriptorSetLayoutBinding writeParticlesBinding{2, vk::DescriptorType::eStorageBuffer, 1, simStages};
-    std::array bindings{physicsParamsBinding, readParticlesBinding, writeParticlesBinding};
+    vk::DescriptorSetLayoutBinding positionsBinding{1, vk::DescriptorType::eStorageBuffer, 1, simStages};
+    vk::DescriptorSetLayoutBinding velocitiesBinding{2, vk::DescriptorType::eStorageBuffer, 1, simStages};
+    vk::DescriptorSetLayoutBinding ewaldBinding{3, vk::DescriptorType::eCombinedImageSampler, 1, simStages};
+    std::array bindings{physicsParamsBinding, positionsBinding, velocitiesBinding, ewaldBinding};
 
     vk::DescriptorSetLayoutCreateInfo dslci({}, bindings);
     DescriptorLayout = LogicalDevice.createDescriptorSetLayout(dslci);
-    spdlog::info("tSim: Creating {} descriptor set layout...", NrDescriptorSets);
-}
-
-void tSim::updateDescriptorSetForFrame(const vk::raii::DescriptorSet &set) const
-{
-    ZoneScopedN("tSim: updateDescriptorSetForFrame()");
-    spdlog::trace("tSim: Updating the descriptor sets for the current frame...");
-    vk::DescriptorBufferInfo simInfo{Physics->getParamsBuffer(), 0, sizeof(tPhysics::tParams)};
-    vk::DescriptorBufferInfo readInfo{Physics->getBufferA(), 0, VK_WHOLE_SIZE};
-    vk::DescriptorBufferInfo writeInfo{Physics->getBufferB(), 0, VK_WHOLE_SIZE};
-
-    std::array writes{vk::WriteDescriptorSet{*set, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &simInfo},
-                      vk::WriteDescriptorSet{*set, 1, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &readInfo},
-                      vk::WriteDescriptorSet{*set, 2, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &writeInfo}};
-    LogicalDevice.updateDescriptorSets(writes, {});
-    spdlog::trace("tSim: Updated the descriptor sets for the current frame");
+    spdlog::info("tSim: Descriptor set layout created");
 }
@@ -0,0 +1,140 @@
+#include "sim/tStateHash.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "helpers/barriers.h"
+#include "helpers/createPipeline.h"
+
+namespace
+{
+struct HashPushConstants
+{
+    vk::DeviceAddress positions;
+    vk::DeviceAddress velocities;
+    vk::DeviceAddress particleCount;
+    vk::DeviceAddress blockHashes;
+    vk::DeviceAddress result;
+    uint32_t blockCount;
+    uint32_t pad0;
+};
+
+// Same as pcgHash() in stateHashBlocks.comp.
+uint32_t pcgHash(const uint32_t v)
+{
+    const uint32_t state = v * 747796405u + 2891336453u;
+    const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+} // namespace
+
+tStateHash::tStateHash(const tVulkanDevice &device, const uint32_t maxCapacity, const uint32_t readbackSlots)
+    : Device(device), LogicalDevice(device.getLogicalDevice()), TracyContext(device.getComputeTracyContext()),
+      MaxCapacity(maxCapacity), ReadbackSlots(readbackSlots)
+{
+    spdlog::info("tStateHash: Initializing for up to {} slots...", MaxCapacity);
+    createBuffers();
+    createPipelines();
+    spdlog::info("tStateHash: Initialized");
+}
+
+void tStateHash::recordHash(const vk::raii::CommandBuffer &commandBuffer,
+                            const tPhysics::tParticleBuffers &buffers,
+                            const uint32_t capacity,
+                            const vk::DeviceAddress particleCount,
+                            const uint32_t slot) const
+{
+    ZoneScopedN("tStateHash: recordHash()");
+    if (capacity > MaxCapacity)
+        throw std::runtime_error("tStateHash: capacity exceeds the one the hash was created with");
+
+    TracyVkNamedZone(TracyContext, tracyHashZone, *commandBuffer, "State Hash", true);
+    const uint32_t blocks = (capacity + LocalSize - 1) / LocalSize;
+    const HashPushConstants pc{buffers.Positions.Address,
+                               buffers.Velocities.Address,
+                               particleCount,
+                               BlockHashes.Address,
+                               Result.Address,
+                               blocks,
+                               0u};
+    const vk::PushConstantsInfo pushConstantsInfo{
+        *PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pc), &pc};
+    commandBuffer.pushConstants2(pushConstantsInfo);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, BlocksPipeline);
+    commandBuffer.dispatch(blocks, 1, 1);
+    recordComputeBarrier(commandBuffer);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, CombinePipeline);
+    commandBuffer.dispatch(1, 1, 1);
+
+    recordComputeToTransferBarrier(commandBuffer);
+    commandBuffer.copyBuffer(
+        *Result.Buffer, *ReadbackBuffer, vk::BufferCopy{0, slot * sizeof(uint64_t), sizeof(uint64_t)});
+    // The next hash overwrites the result only after this copy.
+    recordTransferToComputeBarrier(commandBuffer);
+}
+
+uint64_t tStateHash::readHash(const uint32_t slot) const
+{
+    uint64_t hash;
+    std::memcpy(&hash, static_cast<const char *>(MappedReadback) + slot * sizeof(uint64_t), sizeof(hash));
+    return hash;
+}
+
+uint64_t tStateHash::hashParticles(const std::vector<tParticle> &particles)
+{
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    for (uint32_t i = 0; i < particles.size(); ++i)
+    {
+        const auto &p = particles[i];
+        const float values[8] = {p.Position.x, p.Position.y, p.Position.z, p.Position.w,
+                                 p.Velocity.x, p.Velocity.y, p.Velocity.z, p.Velocity.w};
+        uint32_t x = pcgHash(i);
+        uint32_t y = pcgHash(i ^ 0x9e3779b9u);
+        for (const float value : values)
+        {
+            const auto word = std::bit_cast<uint32_t>(value);
+            x = pcgHash(x ^ word);
+            y = pcgHash(y + word);
+        }
+        lo += x;
+        hi += y;
+    }
+    return static_cast<uint64_t>(hi) << 32 | lo;
+}
+
+void tStateHash::createBuffers()
+{
+    spdlog::info("tStateHash: Creating buffers...");
+    const uint32_t blocks = (MaxCapacity + LocalSize - 1) / LocalSize;
+    BlockHashes = createStorageBuffer(Device, blocks * 2 * sizeof(uint32_t), "tStateHash");
+    Result = createStorageBuffer(Device, sizeof(uint64_t), "tStateHash");
+    std::tie(ReadbackBuffer, ReadbackMemory, MappedReadback) =
+        createBuffer(Device,
+                     ReadbackSlots * sizeof(uint64_t),
+                     vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "tStateHash");
+    std::memset(MappedReadback, 0, ReadbackSlots * sizeof(uint64_t));
+    spdlog::info("tStateHash: Buffers created");
+}
+
+void tStateHash::createPipelines()
+{
+    spdlog::info("tStateHash: Creating compute pipelines...");
+    vk::PushConstantRange pcRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(HashPushConstants)};
+    vk::PipelineLayoutCreateInfo plci({}, {}, pcRange);
+    PipelineLayout = LogicalDevice.createPipelineLayout(plci);
+
+    const auto &cache = Device.getPipelineCache();
+    BlocksPipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "stateHashBlocks.comp.spv");
+    CombinePipeline = createComputePipeline(LogicalDevice, cache, PipelineLayout, "stateHashCombine.comp.spv");
+    spdlog::info("tStateHash: Compute pipelines created");
+}
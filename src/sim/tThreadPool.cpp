@@ -0,0 +1,143 @@
+#include "sim/tThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+tThreadPool::tThreadPool(const uint32_t threadCount)
+{
+    const uint32_t count = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    spdlog::info("tThreadPool: Starting {} threads...", count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Queues.push_back(std::make_unique<tQueue>());
+    }
+    // The last queue belongs to the thread calling parallelFor().
+    for (uint32_t i = 0; i + 1 < count; ++i)
+    {
+        Workers.emplace_back([this, i] { workerLoop(i); });
+    }
+    spdlog::info("tThreadPool: Started");
+}
+
+tThreadPool::~tThreadPool()
+{
+    {
+        std::lock_guard lock(JobMutex);
+        Stopping = true;
+    }
+    JobReady.notify_all();
+    for (auto &worker : Workers)
+    {
+        worker.join();
+    }
+    spdlog::info("tThreadPool: Destroyed");
+}
+
+void tThreadPool::parallelFor(const size_t begin, const size_t end, const size_t grain, const tRangeFn &body)
+{
+    if (begin >= end)
+        return;
+
+    const size_t step = std::max<size_t>(grain, 1);
+    const size_t chunks = (end - begin + step - 1) / step;
+    const size_t threads = Queues.size();
+    for (size_t t = 0; t < threads; ++t)
+    {
+        std::lock_guard lock(Queues[t]->Mutex);
+        for (size_t c = chunks * t / threads; c < chunks * (t + 1) / threads; ++c)
+        {
+            const size_t chunkBegin = begin + c * step;
+            Queues[t]->Chunks.push_back({chunkBegin, std::min(chunkBegin + step, end)});
+        }
+    }
+
+    {
+        std::lock_guard lock(JobMutex);
+        Body = &body;
+        Busy = static_cast<uint32_t>(Workers.size());
+        ++Generation;
+    }
+    JobReady.notify_all();
+
+    runChunks(static_cast<uint32_t>(threads - 1));
+
+    std::unique_lock lock(JobMutex);
+    JobDone.wait(lock, [this] { return Busy == 0; });
+    Body = nullptr;
+    if (Error)
+    {
+        std::rethrow_exception(std::exchange(Error, nullptr));
+    }
+}
+
+void tThreadPool::workerLoop(const uint32_t index)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(JobMutex);
+            JobReady.wait(lock, [this, seen] { return Stopping || Generation != seen; });
+            if (Stopping)
+                return;
+            seen = Generation;
+        }
+
+        runChunks(index);
+
+        std::lock_guard lock(JobMutex);
+        if (--Busy == 0)
+        {
+            JobDone.notify_one();
+        }
+    }
+}
+
+void tThreadPool::runChunks(const uint32_t index)
+{
+    // All chunks are queued before the job starts, so a thread that finds every queue empty is done.
+    tChunk chunk{};
+    while (popOwn(index, chunk) || steal(index, chunk))
+    {
+        try
+        {
+            (*Body)(chunk.Begin, chunk.End);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(JobMutex);
+            if (!Error)
+            {
+                Error = std::current_exception();
+            }
+        }
+    }
+}
+
+bool tThreadPool::popOwn(const uint32_t index, tChunk &chunk)
+{
+    auto &queue = *Queues[index];
+    std::lock_guard lock(queue.Mutex);
+    if (queue.Chunks.empty())
+        return false;
+    chunk = queue.Chunks.back();
+    queue.Chunks.pop_back();
+    return true;
+}
+
+bool tThreadPool::steal(const uint32_t thief, tChunk &chunk)
+{
+    const auto count = static_cast<uint32_t>(Queues.size());
+    for (uint32_t offset = 1; offset < count; ++offset)
+    {
+        auto &queue = *Queues[(thief + offset) % count];
+        std::lock_guard lock(queue.Mutex);
+        if (!queue.Chunks.empty())
+        {
+            chunk = queue.Chunks.front();
+            queue.Chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,5 +1,7 @@
 #include "tApp.h"
 
+#include <chrono>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <tracy/Tracy.hpp>
@@ -14,14 +16,16 @@ tApp::tApp(const bool enableValidation)
     : ValidationEnabled(enableValidation), Instance(enableValidation), Window(WindowWidth, WindowHeight, Name)
 {
     spdlog::info("tApp: Initializing...");
+    const auto start = std::chrono::steady_clock::now();
     Window.createWindowSurface(Instance.getInstance());
     Device.init(Instance.getInstance(), Window.getSurface(), ValidationEnabled);
     Swapchain.init(Instance.getInstance(), Device, Window.getSurface(), Window.getExtent());
     Sim = std::make_unique<tSim>(Device, Swapchain.getImageCount());
     Camera = std::make_unique<tCamera>(Device, Swapchain.getExtent());
-    Gui = std::make_unique<tGui>(*Camera, Device, Swapchain, Instance.getInstance(), Window.getWindow());
+    Gui = std::make_unique<tGui>(*Camera, *Sim, Device, Swapchain, Instance.getInstance(), Window.getWindow());
     Renderer = std::make_unique<tRenderer>(*Camera, *Gui, Device, Swapchain, *Sim);
-    spdlog::info("tApp: Initialized");
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info("tApp: Initialized in {:.1f} ms", elapsed.count());
 }
 
 tApp::~tApp()
@@ -75,11 +79,14 @@ void tApp::updateSimulation(float deltaTime)
 {
     const tPhysics::tParams physicsParams{deltaTime};
     Sim->updateParams(physicsParams);
+    Sim->updatePool();
 }
 
 void tApp::updateGui()
 {
+    Gui->setFrameStats(Renderer->getFrameStats());
     Gui->update();
+    Renderer->setRasterizer(Gui->getRasterizer());
 }
 
 void tApp::renderFrame()
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tPhilox.h"
+
+namespace
+{
+constexpr uint32_t Count = 4000;
+constexpr double Gravity = 1e-5;
+
+std::vector<tParticle> create(const tInitialConditions::tModel model, const uint32_t threadCount)
+{
+    tInitialConditions conditions{};
+    conditions.Model = model;
+    conditions.TruncationRadius = 100.f;
+    return createInitialParticles(Count, conditions, threadCount);
+}
+
+double halfMassRadius(const std::vector<tParticle> &particles)
+{
+    std::vector<double> radii;
+    for (const auto &p : particles)
+    {
+        radii.push_back(glm::length(glm::vec3(p.Position)));
+    }
+    std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+    return radii[radii.size() / 2];
+}
+
+// 2 K / |W| by direct summation, 1 in equilibrium.
+double virialRatio(const std::vector<tParticle> &particles)
+{
+    double kinetic = 0.0;
+    double potential = 0.0;
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        const auto velocity = glm::vec3(particles[i].Velocity);
+        kinetic += 0.5 * particles[i].Position.w * glm::dot(velocity, velocity);
+        for (size_t j = i + 1; j < particles.size(); ++j)
+        {
+            const double distance = glm::length(glm::vec3(particles[i].Position - particles[j].Position));
+            potential -= Gravity * particles[i].Position.w * particles[j].Position.w / distance;
+        }
+    }
+    return 2.0 * kinetic / -potential;
+}
+} // namespace
+
+TEST(initialParticlesTest, PhiloxMatchesKnownAnswers)
+{
+    // Known-answer vectors of the Random123 reference implementation.
+    EXPECT_EQ(tPhilox::generate({0u, 0u, 0u, 0u}, {0u, 0u}),
+              (tPhilox::tCounter{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}));
+    EXPECT_EQ(tPhilox::generate({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u}),
+              (tPhilox::tCounter{0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}));
+}
+
+TEST(initialParticlesTest, ThreadCountDoesNotChangeParticles)
+{
+    using tModel = tInitialConditions::tModel;
+    for (const auto model :
+         {tModel::Shell, tModel::Plummer, tModel::Hernquist, tModel::Disk, tModel::Merger, tModel::Lattice})
+    {
+        SCOPED_TRACE(static_cast<int>(model));
+        const auto single = create(model, 1);
+        const auto parallel = create(model, 7);
+        for (size_t i = 0; i < single.size(); ++i)
+        {
+            ASSERT_EQ(parallel[i].Position, single[i].Position) << "particle " << i;
+            ASSERT_EQ(parallel[i].Velocity, single[i].Velocity) << "particle " << i;
+        }
+    }
+}
+
+TEST(initialParticlesTest, SpheresMatchTheirProfiles)
+{
+    // Half-mass radii of 1.305 a and (1 + sqrt(2)) a.
+    const auto plummer = create(tInitialConditions::tModel::Plummer, 0);
+    EXPECT_NEAR(halfMassRadius(plummer), 1.305, 0.08);
+    EXPECT_NEAR(virialRatio(plummer), 1.0, 0.1);
+
+    const auto hernquist = create(tInitialConditions::tModel::Hernquist, 0);
+    EXPECT_NEAR(halfMassRadius(hernquist), 2.414, 0.15);
+    EXPECT_NEAR(virialRatio(hernquist), 1.0, 0.15);
+}
+
+TEST(initialParticlesTest, MergerStartsAtRestAboutItsCentreOfMass)
+{
+    const auto particles = create(tInitialConditions::tModel::Merger, 0);
+    glm::dvec3 centre{0.0};
+    glm::dvec3 momentum{0.0};
+    glm::dvec3 firstCentre{0.0};
+    for (size_t i = 0; i < particles.size(); ++i)
+    {
+        centre += glm::dvec3(glm::vec3(particles[i].Position));
+        momentum += glm::dvec3(glm::vec3(particles[i].Velocity));
+        if (i < particles.size() / 2)
+            firstCentre += glm::dvec3(glm::vec3(particles[i].Position));
+    }
+    centre /= static_cast<double>(particles.size());
+    momentum /= static_cast<double>(particles.size());
+    firstCentre /= static_cast<double>(particles.size() / 2);
+
+    EXPECT_LT(glm::length(centre), 0.1);
+    EXPECT_LT(glm::length(momentum), 2e-3);
+    // Equal galaxies sit half the separation from the centre of mass.
+    EXPECT_NEAR(glm::length(firstCentre), 0.5 * tInitialConditions{}.MergerSeparation, 0.2);
+}
@@ -0,0 +1,71 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+// RMS of the force error relative to the RMS force of direct summation.
+float relativeRmsError(const std::vector<glm::vec3> &reference, const std::vector<glm::vec3> &approx)
+{
+    double errorSum = 0.0;
+    double referenceSum = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        const auto error = reference[i] - approx[i];
+        errorSum += glm::dot(error, error);
+        referenceSum += glm::dot(reference[i], reference[i]);
+    }
+    return static_cast<float>(std::sqrt(errorSum / referenceSum));
+}
+} // namespace
+
+TEST(tBarnesHutTest, AccuracyAgainstDirectSummation)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1.0f});
+
+    sim.setSolver(tSim::tSolver::Direct);
+    const auto direct = stepAccelerations(context, sim);
+
+    sim.setSolver(tSim::tSolver::BarnesHut);
+    const std::vector<float> thetas{0.25f, 0.5f, 1.0f};
+    std::vector<float> errors;
+    for (const auto theta : thetas)
+    {
+        sim.setOpeningAngle(theta);
+        errors.push_back(relativeRmsError(direct, stepAccelerations(context, sim)));
+    }
+
+    // Monopole-only Barnes-Hut: error grows with the opening angle and stays around a percent at 0.5.
+    EXPECT_LT(errors[0], 5e-3f);
+    EXPECT_LT(errors[1], 2e-2f);
+    EXPECT_LT(errors[2], 1e-1f);
+    EXPECT_LE(errors[0], errors[1]);
+    EXPECT_LE(errors[1], errors[2]);
+}
+
+TEST(tBarnesHutTest, ClusteredParticlesMatchDirectSummation)
+{
+    // A Plummer core inside a far-reaching halo: the core shares a handful of Morton keys, so the tree below it is
+    // split by slot index alone and runs as deep as it can get.
+    tInitialConditions initialConditions{};
+    initialConditions.Model = tInitialConditions::tModel::Plummer;
+    initialConditions.ScaleRadius = 1e-3f;
+    initialConditions.TruncationRadius = 1e5f;
+
+    tTestContext context;
+    tSim sim{context.Device, 1, {}, {}, initialConditions};
+    sim.updateParams({1.0f});
+
+    sim.setSolver(tSim::tSolver::Direct);
+    const auto direct = stepAccelerations(context, sim);
+    sim.setSolver(tSim::tSolver::BarnesHut);
+    sim.setOpeningAngle(0.5f);
+    EXPECT_LT(relativeRmsError(direct, stepAccelerations(context, sim)), 5e-2f);
+}
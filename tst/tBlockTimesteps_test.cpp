@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+TEST(tBlockTimestepsTest, MinActiveLevel)
+{
+    // Four levels: level 3 steps every substep, level 2 every second, level 1 every fourth.
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(1, 3), 3u);
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(2, 3), 2u);
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(3, 3), 3u);
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(4, 3), 1u);
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(6, 3), 2u);
+    EXPECT_EQ(tBlockTimesteps::minActiveLevel(8, 3), 0u);
+}
+
+TEST(tBlockTimestepsTest, SingleLevelMatchesLeapfrog)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({0.01f});
+
+    sim.setIntegrator(tIntegrator::tScheme::LeapfrogKdk);
+    stepSim(context, sim);
+    const auto leapfrog = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+
+    sim.setBlockTimestepParams({1, 0.05f});
+    sim.setBlockTimestepsEnabled(true);
+    stepSim(context, sim);
+    const auto block = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+
+    for (size_t i = 0; i < block.size(); ++i)
+    {
+        ASSERT_NEAR(glm::length(glm::vec3(block[i].Position - leapfrog[i].Position)), 0.f, 1e-6f) << "particle " << i;
+        ASSERT_NEAR(glm::length(glm::vec3(block[i].Velocity - leapfrog[i].Velocity)), 0.f, 1e-6f) << "particle " << i;
+    }
+}
+
+TEST(tBlockTimestepsTest, ActiveListMatchesLevels)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({0.1f});
+    sim.setBlockTimestepParams({4, 0.05f});
+    sim.setBlockTimestepsEnabled(true);
+    stepSim(context, sim);
+
+    const auto &blockTimesteps = sim.getBlockTimesteps();
+    const auto levels = readBuffer<uint32_t>(context.Device, *blockTimesteps.getLevelsBuffer(), NUM_PARTICLES);
+    EXPECT_TRUE(std::ranges::all_of(levels, [](const uint32_t level) { return level < 4; }));
+
+    for (const uint32_t syncTime : {1u, 2u, 4u})
+    {
+        auto commandBuffer = context.Device.beginSingleTimeCommands();
+        blockTimesteps.recordCompaction(commandBuffer, syncTime, sim.getParticlePool().getLiveList());
+        context.Device.endSingleTimeCommands(commandBuffer);
+
+        const auto dispatch = readBuffer<uint32_t>(context.Device, *blockTimesteps.getDispatchBuffer(), 8);
+        const auto &indicesBuffer = blockTimesteps.getActiveIndicesBuffer();
+        std::vector<uint32_t> active;
+        if (dispatch[0] > 0)
+        {
+            active = readBuffer<uint32_t>(context.Device, *indicesBuffer, dispatch[0]);
+        }
+
+        const uint32_t minLevel = tBlockTimesteps::minActiveLevel(syncTime, 3);
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < NUM_PARTICLES; ++i)
+        {
+            if (levels[i] >= minLevel)
+                expected.push_back(i);
+        }
+        EXPECT_EQ(active, expected) << "sync time " << syncTime;
+        EXPECT_EQ(dispatch[4], (dispatch[0] + tActiveList::LocalSize - 1) / tActiveList::LocalSize);
+        EXPECT_EQ(dispatch[5], 1u);
+        EXPECT_EQ(dispatch[6], 1u);
+    }
+}
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+TEST(tCellGridTest, MatchesCpuReference)
+{
+    tTestContext context;
+    tCellGrid::tParams params{};
+    params.Dimensions = {16, 12, 8};
+    params.CellSize = 0.3f;
+    params.Origin = {-2.4f, -1.8f, -1.2f};
+    tSim sim{context.Device, 1, params};
+    sim.setCellGridEnabled(true);
+
+    stepSim(context, sim);
+
+    // The grid is built from the read buffer, which is the write buffer after a swap.
+    sim.swapParticleBuffers();
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    sim.swapParticleBuffers();
+
+    const auto &grid = sim.getCellGrid();
+    const auto cellTotal = grid.getCellTotal();
+    const auto cellStart = readBuffer<uint32_t>(context.Device, *grid.getCellStartBuffer(), cellTotal);
+    const auto cellCount = readBuffer<uint32_t>(context.Device, *grid.getCellCountBuffer(), cellTotal);
+    auto sortedIndices = readBuffer<uint32_t>(context.Device, *grid.getSortedIndicesBuffer(), NUM_PARTICLES);
+
+    const auto reference = tCellGrid::buildReference(particles, params);
+    EXPECT_EQ(cellStart, reference.CellStart);
+    EXPECT_EQ(cellCount, reference.CellCount);
+
+    // Order inside a cell follows atomic arrival on the GPU, so compare each cell as a set.
+    for (uint32_t c = 0; c < cellTotal; ++c)
+    {
+        const auto begin = sortedIndices.begin() + reference.CellStart[c];
+        std::sort(begin, begin + reference.CellCount[c]);
+    }
+    EXPECT_EQ(sortedIndices, reference.SortedIndices);
+}
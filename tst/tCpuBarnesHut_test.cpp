@@ -0,0 +1,118 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tCpuBarnesHut.h"
+#include "sim/tCpuPhysics.h"
+
+namespace
+{
+constexpr uint32_t Count = 3000;
+
+// Small enough for direct summation, with a free slot and two particles on the same spot.
+std::vector<tParticle> createParticles()
+{
+    auto particles = createInitialParticles(Count);
+    particles[5].Position.w = 0.f;
+    particles[7].Position = particles[6].Position;
+    return particles;
+}
+
+std::vector<glm::vec3> directAccelerations(const std::vector<tParticle> &particles)
+{
+    tCpuPhysics direct{0, 1};
+    direct.setKernel(tCpuPhysics::tKernel::Scalar);
+    direct.setParticles(particles);
+    direct.computeAccelerations();
+    return direct.getAccelerations();
+}
+
+// RMS of the force error relative to the RMS force of direct summation.
+float relativeRmsError(const std::vector<glm::vec3> &reference, const std::vector<glm::vec3> &approx)
+{
+    double errorSum = 0.0;
+    double referenceSum = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        const auto error = reference[i] - approx[i];
+        errorSum += glm::dot(error, error);
+        referenceSum += glm::dot(reference[i], reference[i]);
+    }
+    return static_cast<float>(std::sqrt(errorSum / referenceSum));
+}
+} // namespace
+
+TEST(tCpuBarnesHutTest, ZeroOpeningAngleMatchesDirectSummation)
+{
+    const auto particles = createParticles();
+    const auto direct = directAccelerations(particles);
+
+    tCpuBarnesHut tree{4};
+    tree.setParams({0.f, 8});
+    const auto accelerations = tree.computeAccelerations(particles);
+    ASSERT_EQ(accelerations.size(), direct.size());
+    EXPECT_EQ(accelerations[5], glm::vec3(0.f));
+    EXPECT_LT(relativeRmsError(direct, accelerations), 1e-5f);
+}
+
+TEST(tCpuBarnesHutTest, AccuracyAgainstDirectSummation)
+{
+    const auto particles = createParticles();
+    const auto direct = directAccelerations(particles);
+
+    tCpuBarnesHut tree{4};
+    std::vector<float> errors;
+    for (const auto theta : {0.25f, 0.5f, 1.0f})
+    {
+        tree.setParams({theta, 8});
+        errors.push_back(relativeRmsError(direct, tree.computeAccelerations(particles)));
+    }
+
+    // Same bounds as the GPU tree.
+    EXPECT_LT(errors[0], 5e-3f);
+    EXPECT_LT(errors[1], 2e-2f);
+    EXPECT_LT(errors[2], 1e-1f);
+    EXPECT_LE(errors[0], errors[1]);
+    EXPECT_LE(errors[1], errors[2]);
+}
+
+TEST(tCpuBarnesHutTest, LeafSizeKeepsAccuracy)
+{
+    const auto particles = createParticles();
+    const auto direct = directAccelerations(particles);
+
+    tCpuBarnesHut tree{4};
+    std::vector<float> errors;
+    for (const uint32_t leafSize : {1u, 16u, 64u})
+    {
+        tree.setParams({0.5f, leafSize});
+        errors.push_back(relativeRmsError(direct, tree.computeAccelerations(particles)));
+    }
+
+    // Larger leaves sum more pairs directly.
+    EXPECT_LT(errors[0], 3e-2f);
+    EXPECT_LE(errors[1], errors[0]);
+    EXPECT_LE(errors[2], errors[1]);
+}
+
+TEST(tCpuBarnesHutTest, ThreadCountDoesNotChangeResults)
+{
+    auto single = createParticles();
+    auto parallel = single;
+    tCpuBarnesHut singleTree{1};
+    tCpuBarnesHut parallelTree{8};
+    for (int i = 0; i < 3; ++i)
+    {
+        singleTree.step(single, 1e-3f);
+        parallelTree.step(parallel, 1e-3f);
+    }
+    EXPECT_EQ(singleTree.getNodeCount(), parallelTree.getNodeCount());
+
+    for (size_t i = 0; i < single.size(); ++i)
+    {
+        ASSERT_EQ(parallel[i].Position, single[i].Position) << "particle " << i;
+        ASSERT_EQ(parallel[i].Velocity, single[i].Velocity) << "particle " << i;
+    }
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "sim/tCpuPhysics.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+float maxLength(const std::vector<glm::vec3> &values)
+{
+    float result = 0.f;
+    for (const auto &v : values)
+    {
+        result = std::max(result, glm::length(v));
+    }
+    return result;
+}
+} // namespace
+
+TEST(tCpuPhysicsTest, VectorKernelsMatchScalar)
+{
+    // Not a multiple of any vector width, so the padding slots are exercised too.
+    tCpuPhysics physics{1000, 4};
+    physics.setKernel(tCpuPhysics::tKernel::Scalar);
+    physics.computeAccelerations();
+    const auto scalar = physics.getAccelerations();
+    const float maxAcceleration = maxLength(scalar);
+    ASSERT_GT(maxAcceleration, 0.f);
+
+    for (const auto kernel : {tCpuPhysics::tKernel::Avx2, tCpuPhysics::tKernel::Avx512})
+    {
+        if (!tCpuPhysics::isSupported(kernel))
+            continue;
+        physics.setKernel(kernel);
+        physics.computeAccelerations();
+        const auto vector = physics.getAccelerations();
+        for (size_t i = 0; i < scalar.size(); ++i)
+        {
+            ASSERT_LE(glm::length(vector[i] - scalar[i]), tCpuPhysics::KernelTolerance * maxAcceleration)
+                << "particle " << i;
+        }
+    }
+}
+
+TEST(tCpuPhysicsTest, ThreadCountDoesNotChangeResults)
+{
+    tCpuPhysics single{2000, 1};
+    tCpuPhysics parallel{2000, 8};
+    for (auto *physics : {&single, &parallel})
+    {
+        physics->updateParams({1e-3f});
+        for (int i = 0; i < 3; ++i)
+        {
+            physics->step();
+        }
+    }
+
+    const auto expected = single.getParticles();
+    const auto particles = parallel.getParticles();
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        ASSERT_EQ(particles[i].Position, expected[i].Position) << "particle " << i;
+        ASSERT_EQ(particles[i].Velocity, expected[i].Velocity) << "particle " << i;
+    }
+}
+
+TEST(tCpuPhysicsTest, MatchesGpuDirectSum)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1.0f});
+    sim.setForceKernel(tPhysics::tKernel::Naive);
+    const auto gpu = stepAccelerations(context, sim);
+
+    tCpuPhysics physics{};
+    physics.computeAccelerations();
+    const auto cpu = physics.getAccelerations();
+    ASSERT_EQ(cpu.size(), gpu.size());
+
+    const float maxAcceleration = maxLength(gpu);
+    ASSERT_GT(maxAcceleration, 0.f);
+    for (size_t i = 0; i < gpu.size(); ++i)
+    {
+        EXPECT_LE(glm::length(cpu[i] - gpu[i]), tPhysics::KernelTolerance * maxAcceleration) << "particle " << i;
+    }
+}
+
+// Benchmark: reports the best kernel's throughput as a test property so it is tracked across runs.
+TEST(tCpuPhysicsTest, Throughput)
+{
+    tCpuPhysics physics{};
+    double best = 0.0;
+    for (int i = 0; i < 5; ++i)
+    {
+        physics.computeAccelerations();
+        best = std::max(best, physics.getInteractionsPerSecond());
+    }
+    EXPECT_GT(best, 0.0);
+    spdlog::info("tCpuPhysicsTest: {:.3e} pair interactions/s on {} threads", best, physics.getThreadCount());
+    RecordProperty("pair_interactions_per_second", std::to_string(static_cast<uint64_t>(best)));
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "helpers/barriers.h"
+#include "sim/tDiagnostics.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+void expectNear(const glm::vec4 &actual, const glm::vec4 &expected, const float tolerance)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        EXPECT_NEAR(actual[k], expected[k], tolerance * std::max(std::abs(expected[k]), 1.f)) << "component " << k;
+    }
+}
+} // namespace
+
+TEST(tDiagnosticsTest, GpuRecordMatchesHost)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+    stepSim(context, sim);
+
+    constexpr uint32_t Samples = 512;
+    tDiagnostics diagnostics{context.Device, sim.getCapacity(), 1};
+    auto commandBuffer = context.Device.beginSingleTimeCommands();
+    recordComputeBarrier(commandBuffer);
+    diagnostics.recordDiagnostics(commandBuffer,
+                                  sim.getParticleBuffers(),
+                                  sim.getCapacity(),
+                                  sim.getParticlePool().getCountAddress(),
+                                  Samples,
+                                  0);
+    context.Device.endSingleTimeCommands(commandBuffer);
+
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    const auto expected = tDiagnostics::computeRecord(particles, Samples);
+    const auto actual = diagnostics.readRecord(0);
+    EXPECT_LT(expected.Energy.y, 0.f);
+    EXPECT_EQ(actual.Energy.w, static_cast<float>(NUM_PARTICLES));
+    // Float sums in a different order than the double ones on the host.
+    expectNear(actual.Energy, expected.Energy, 1e-4f);
+    expectNear(actual.Momentum, expected.Momentum, 1e-3f);
+    expectNear(actual.AngularMomentum, expected.AngularMomentum, 1e-3f);
+    expectNear(actual.MassMoment, expected.MassMoment, 1e-3f);
+}
+
+TEST(tDiagnosticsTest, SimReadsBackHistory)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.setDiagnosticsEnabled(true);
+    for (int i = 0; i < 8; ++i)
+    {
+        sim.updatePool();
+        sim.updateParams({1e-3f});
+        stepSim(context, sim);
+        sim.swapParticleBuffers();
+    }
+    sim.updatePool();
+
+    // Two readback slots with one frame in flight: every frame but the last arrives, in step order.
+    const auto &history = sim.getDiagnosticsHistory();
+    ASSERT_EQ(history.size(), 7u);
+    for (size_t i = 0; i < history.size(); ++i)
+    {
+        EXPECT_EQ(history[i].Step, i + 1);
+        EXPECT_EQ(history[i].Count, NUM_PARTICLES);
+    }
+    // A handful of small steps barely moves the total energy.
+    const float energy = history.front().getTotalEnergy();
+    EXPECT_NEAR(history.back().getTotalEnergy(), energy, 1e-2f * std::abs(energy));
+}
+
+TEST(tDiagnosticsTest, FreeSlotsAreNotCounted)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+
+    // The initial shell of radius 2 is killed, then 100 particles are emitted into the top of the free list, leaving
+    // the slot count at NUM_PARTICLES with only 100 of them live.
+    sim.updateParams({1e-3f});
+    sim.setKillRadius(1.f);
+    stepSim(context, sim);
+    sim.setKillRadius(0.f);
+    sim.setEmissionRate(200.f);
+    sim.updateParams({0.5f});
+    sim.swapParticleBuffers();
+    stepSim(context, sim);
+
+    tDiagnostics diagnostics{context.Device, sim.getCapacity(), 1};
+    auto commandBuffer = context.Device.beginSingleTimeCommands();
+    recordComputeBarrier(commandBuffer);
+    diagnostics.recordDiagnostics(commandBuffer,
+                                  sim.getParticleBuffers(),
+                                  sim.getCapacity(),
+                                  sim.getParticlePool().getCountAddress(),
+                                  0,
+                                  0);
+    context.Device.endSingleTimeCommands(commandBuffer);
+
+    const auto sample = tDiagnostics::tSample::fromRecord(diagnostics.readRecord(0), 0);
+    EXPECT_EQ(sample.Count, 100u);
+    EXPECT_NEAR(sample.Mass, 100.f, 1e-3f);
+}
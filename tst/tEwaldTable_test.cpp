@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tEwaldTable.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+constexpr float BoxSize = 10.f;
+
+tInitialConditions latticeConditions()
+{
+    tInitialConditions conditions{};
+    conditions.Model = tInitialConditions::tModel::Lattice;
+    conditions.ScaleRadius = BoxSize;
+    return conditions;
+}
+
+std::vector<glm::vec3> periodicLatticeAccelerations(const tTestContext &context)
+{
+    tSim sim{context.Device, 1, {}, {}, latticeConditions()};
+    sim.setBoxSize(BoxSize);
+    sim.updateParams({1.f});
+    return stepAccelerations(context, sim);
+}
+
+// The periodic force on one site in closed form, with the same minimum image and softening as forceNaive.comp and
+// the Ewald sum itself in place of the table.
+glm::dvec3 periodicAcceleration(const std::vector<tParticle> &particles, const size_t site, const double box)
+{
+    const glm::dvec3 self{particles[site].Position};
+    glm::dvec3 acceleration{0.0};
+    for (size_t j = 0; j < particles.size(); ++j)
+    {
+        if (j == site)
+            continue;
+        glm::dvec3 dir = glm::dvec3(particles[j].Position) - self;
+        dir -= box * glm::dvec3(std::nearbyint(dir.x / box), std::nearbyint(dir.y / box), std::nearbyint(dir.z / box));
+        const double invDist = 1.0 / std::sqrt(std::clamp(glm::dot(dir, dir), 1e-1, 1e6));
+        const double mass = particles[j].Position.w;
+        acceleration += 1e-5 * mass *
+                        (dir * invDist * invDist * invDist + tEwaldTable::computeCorrection(dir / box) / (box * box));
+    }
+    return acceleration;
+}
+} // namespace
+
+TEST(tEwaldTableTest, PeriodicForceVanishesAtSymmetricPoints)
+{
+    // Half a box away along one, two or three axes, every image is balanced by one on the other side.
+    for (const auto r : {glm::dvec3(0.5, 0.0, 0.0), glm::dvec3(0.5, 0.5, 0.0), glm::dvec3(0.5, 0.5, 0.5)})
+    {
+        const auto total = r / std::pow(glm::length(r), 3.0) + tEwaldTable::computeCorrection(r);
+        EXPECT_LT(glm::length(total), 1e-8) << r.x << " " << r.y << " " << r.z;
+    }
+    EXPECT_EQ(tEwaldTable::computeCorrection(glm::dvec3(0.0)), glm::dvec3(0.0));
+}
+
+TEST(tEwaldTableTest, TableSamplesTheFirstOctant)
+{
+    constexpr uint32_t Size = tEwaldTable::Size;
+    const auto table = tEwaldTable::computeTable();
+    ASSERT_EQ(table.size(), Size * Size * Size);
+    EXPECT_EQ(table[0], glm::vec4(0.f));
+    // Texel Size - 1 along x is half a box away, where the correction cancels the minimum image.
+    EXPECT_NEAR(table[Size - 1].x, -4.f, 1e-5f);
+    EXPECT_NEAR(table[Size - 1].y, 0.f, 1e-5f);
+    const double step = 0.5 / (Size - 1);
+    const glm::dvec3 r{3 * step, 5 * step, 7 * step};
+    const auto expected = glm::vec3(tEwaldTable::computeCorrection(r));
+    EXPECT_EQ(glm::vec3(table[3 + 5 * Size + 7 * Size * Size]), expected);
+}
+
+TEST(tEwaldTableTest, LatticeForcesMatchTheEwaldSum)
+{
+    tTestContext context;
+    const auto periodic = periodicLatticeAccelerations(context);
+    const auto particles = createInitialParticles(NUM_PARTICLES, latticeConditions());
+
+    // A corner, a site inside and the last one of the partly filled top layer. The lattice does not fill the box,
+    // so these forces do not vanish; leaving out the correction moves each by more than 1e-4.
+    for (const size_t site : {size_t{0}, size_t{NUM_PARTICLES / 2}, size_t{NUM_PARTICLES - 1}})
+    {
+        const auto expected = glm::vec3(periodicAcceleration(particles, site, BoxSize));
+        for (int k = 0; k < 3; ++k)
+        {
+            // Interpolating the table, fp16 texels where fp32 is not filterable, and float sums over every pair.
+            EXPECT_NEAR(periodic[site][k], expected[k], 1e-5f) << "site " << site << " component " << k;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+TEST(tIntegratorTest, StagesAreConsistent)
+{
+    using enum tIntegrator::tScheme;
+    for (const auto scheme : {SemiImplicitEuler, LeapfrogKdk, VelocityVerlet, Yoshida4})
+    {
+        float kick = 0.f;
+        float drift = 0.f;
+        bool driftAfterForce = false;
+        for (const auto &stage : tIntegrator::buildStages(scheme))
+        {
+            kick += stage.Kick;
+            drift += stage.Drift;
+            const bool isForce = stage.Type == tIntegrator::tStageType::Force;
+            driftAfterForce = !isForce && (driftAfterForce || stage.Drift != 0.f);
+        }
+        EXPECT_NEAR(kick, 1.f, 1e-5f) << "scheme " << static_cast<int>(scheme);
+        EXPECT_NEAR(drift, 1.f, 1e-5f) << "scheme " << static_cast<int>(scheme);
+
+        // Reused forces are only valid if nothing moves the particles after the last force evaluation.
+        if (tIntegrator::reusesForces(scheme))
+        {
+            EXPECT_FALSE(driftAfterForce) << "scheme " << static_cast<int>(scheme);
+        }
+    }
+}
+
+TEST(tIntegratorTest, SchemesAgreeOnShortStep)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    const float dt = 1e-3f;
+    sim.updateParams({dt});
+
+    sim.setIntegrator(tIntegrator::tScheme::SemiImplicitEuler);
+    stepSim(context, sim);
+    const auto euler = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    float maxAcceleration = 0.f;
+    for (const auto &a : stepAccelerations(context, sim))
+    {
+        maxAcceleration = std::max(maxAcceleration, glm::length(a) / dt);
+    }
+    ASSERT_GT(maxAcceleration, 0.f);
+
+    // All schemes are consistent, so after one short step they differ from Euler by O(a dt^2) only.
+    const float tolerance = 2.f * maxAcceleration * dt * dt + 4e-6f;
+    using enum tIntegrator::tScheme;
+    for (const auto scheme : {LeapfrogKdk, VelocityVerlet, Yoshida4})
+    {
+        sim.setIntegrator(scheme);
+        stepSim(context, sim);
+        const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+        for (size_t i = 0; i < particles.size(); ++i)
+        {
+            ASSERT_LE(glm::length(glm::vec3(particles[i].Position - euler[i].Position)), tolerance)
+                << "scheme " << static_cast<int>(scheme) << " particle " << i;
+            ASSERT_LE(glm::length(glm::vec3(particles[i].Velocity - euler[i].Velocity)), tolerance / dt)
+                << "scheme " << static_cast<int>(scheme) << " particle " << i;
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/tMemoryAllocator.h"
+#include "helpers/memoryAllocation.h"
+#include "testHelpers.h"
+
+namespace
+{
+using Flag = vk::MemoryPropertyFlagBits;
+
+// A discrete GPU: plain VRAM, the host-visible BAR window, system memory with and without caching and a lazily
+// allocated type.
+vk::PhysicalDeviceMemoryProperties discreteMemoryProperties()
+{
+    vk::PhysicalDeviceMemoryProperties properties{};
+    const std::array<vk::MemoryPropertyFlags, 5> types{Flag::eDeviceLocal,
+                                                       Flag::eDeviceLocal | Flag::eHostVisible | Flag::eHostCoherent,
+                                                       Flag::eHostVisible | Flag::eHostCoherent,
+                                                       Flag::eHostVisible | Flag::eHostCoherent | Flag::eHostCached,
+                                                       Flag::eDeviceLocal | Flag::eLazilyAllocated};
+    properties.memoryTypeCount = types.size();
+    for (uint32_t i = 0; i < types.size(); ++i)
+    {
+        properties.memoryTypes[i] = vk::MemoryType{types[i], types[i] & Flag::eDeviceLocal ? 0u : 1u};
+    }
+    properties.memoryHeapCount = 2;
+    properties.memoryHeaps[0] = vk::MemoryHeap{8ull << 30, vk::MemoryHeapFlagBits::eDeviceLocal};
+    properties.memoryHeaps[1] = vk::MemoryHeap{32ull << 30, {}};
+    return properties;
+}
+
+vk::MemoryRequirements storageRequirements(const tVulkanDevice &device, const vk::DeviceSize size)
+{
+    const vk::raii::Buffer buffer{device.getLogicalDevice(),
+                                  vk::BufferCreateInfo({}, size, vk::BufferUsageFlagBits::eStorageBuffer)};
+    return buffer.getMemoryRequirements();
+}
+} // namespace
+
+TEST(tMemoryAllocatorTest, RanksExactMatchesFirst)
+{
+    const auto properties = discreteMemoryProperties();
+    // Device-local requests take VRAM before the BAR and fall back to system memory last.
+    EXPECT_EQ(rankMemoryTypes(properties, 0x1F, {}, Flag::eDeviceLocal), (std::vector<uint32_t>{0, 1, 2, 3}));
+    EXPECT_EQ(rankMemoryTypes(properties, 0x1E, {}, Flag::eDeviceLocal), (std::vector<uint32_t>{1, 2, 3}));
+    EXPECT_EQ(rankMemoryTypes(properties, 0x1F, Flag::eHostVisible | Flag::eHostCoherent),
+              (std::vector<uint32_t>{2, 1, 3}));
+    EXPECT_EQ(rankMemoryTypes(properties, 0x1F, Flag::eLazilyAllocated), (std::vector<uint32_t>{4}));
+    EXPECT_TRUE(rankMemoryTypes(properties, 0x1F, Flag::eProtected).empty());
+    EXPECT_TRUE(rankMemoryTypes(properties, 0x1, Flag::eHostVisible).empty());
+}
+
+TEST(tMemoryAllocatorTest, SubAllocatesManyBuffersFromFewBlocks)
+{
+    tTestContext context;
+    auto &allocator = context.Device.getAllocator();
+    const uint32_t baseBlocks = allocator.getBlockCount();
+    const uint32_t baseAllocations = allocator.getAllocationCount();
+
+    constexpr uint32_t Count = 512;
+    std::vector<tStorageBuffer> buffers;
+    for (uint32_t i = 0; i < Count; ++i)
+    {
+        buffers.push_back(createStorageBuffer(context.Device, 4096 + 16 * i, "allocator test"));
+    }
+    EXPECT_LE(allocator.getBlockCount(), baseBlocks + 1);
+    EXPECT_EQ(allocator.getAllocationCount(), baseAllocations + Count);
+
+    // Ranges sharing a block must not overlap.
+    std::vector<const tStorageBuffer *> sorted;
+    for (const auto &buffer : buffers)
+    {
+        sorted.push_back(&buffer);
+    }
+    std::ranges::sort(sorted, [](const auto *a, const auto *b) {
+        const auto memoryA = static_cast<VkDeviceMemory>(a->Memory.getMemory());
+        const auto memoryB = static_cast<VkDeviceMemory>(b->Memory.getMemory());
+        return memoryA != memoryB ? memoryA < memoryB : a->Memory.getOffset() < b->Memory.getOffset();
+    });
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        if (sorted[i]->Memory.getMemory() == sorted[i - 1]->Memory.getMemory())
+        {
+            EXPECT_GE(sorted[i]->Memory.getOffset(),
+                      sorted[i - 1]->Memory.getOffset() + sorted[i - 1]->Memory.getSize());
+        }
+    }
+
+    const auto usage = allocator.getTagUsage();
+    const auto tag = std::ranges::find(usage, std::string("allocator test"), &tMemoryAllocator::tTagUsage::Tag);
+    ASSERT_NE(tag, usage.end());
+    EXPECT_EQ(tag->Allocations, Count);
+
+    buffers.clear();
+    EXPECT_EQ(allocator.getAllocationCount(), baseAllocations);
+    const auto after = allocator.getTagUsage();
+    EXPECT_EQ(std::ranges::find(after, std::string("allocator test"), &tMemoryAllocator::tTagUsage::Tag),
+              after.end());
+}
+
+TEST(tMemoryAllocatorTest, RespectsAlignmentAndReusesFreedRanges)
+{
+    tTestContext context;
+    auto &allocator = context.Device.getAllocator();
+    auto requirements = storageRequirements(context.Device, 256);
+    requirements.size = 100;
+    requirements.alignment = 1;
+    auto odd = allocator.allocate(requirements, Flag::eDeviceLocal, tMemoryAllocator::tResource::Buffer, "test");
+
+    requirements.size = 64;
+    requirements.alignment = 4096;
+    auto aligned = allocator.allocate(requirements, Flag::eDeviceLocal, tMemoryAllocator::tResource::Buffer, "test");
+    EXPECT_EQ(aligned.getOffset() % 4096, 0u);
+    EXPECT_EQ(aligned.getMemory(), odd.getMemory());
+
+    // The freed range, padding included, is whole again and fits the same request at the same place.
+    const auto offset = aligned.getOffset();
+    aligned = nullptr;
+    auto again = allocator.allocate(requirements, Flag::eDeviceLocal, tMemoryAllocator::tResource::Buffer, "test");
+    EXPECT_EQ(again.getOffset(), offset);
+}
+
+TEST(tMemoryAllocatorTest, HostVisibleBuffersStayMapped)
+{
+    tTestContext context;
+    std::vector<uint32_t> data(1000);
+    std::iota(data.begin(), data.end(), 7u);
+    const auto flags = Flag::eHostVisible | Flag::eHostCoherent;
+    auto [first, firstMemory, firstMapped] = createBuffer(context.Device,
+                                                          data.size() * sizeof(uint32_t),
+                                                          vk::BufferUsageFlagBits::eTransferSrc,
+                                                          vk::SharingMode::eExclusive,
+                                                          flags,
+                                                          data.data(),
+                                                          "test");
+    auto [second, secondMemory, secondMapped] = createBuffer(context.Device,
+                                                             data.size() * sizeof(uint32_t),
+                                                             vk::BufferUsageFlagBits::eTransferSrc,
+                                                             vk::SharingMode::eExclusive,
+                                                             flags,
+                                                             data.data(),
+                                                             "test");
+    ASSERT_NE(firstMapped, nullptr);
+    ASSERT_NE(secondMapped, nullptr);
+    EXPECT_EQ(firstMemory.getMemory(), secondMemory.getMemory());
+    EXPECT_NE(firstMapped, secondMapped);
+    EXPECT_EQ(std::memcmp(secondMapped, data.data(), data.size() * sizeof(uint32_t)), 0);
+
+    // The GPU reads the same bytes through the sub-allocated range.
+    const auto gpu = readBuffer<uint32_t>(context.Device, *first, data.size());
+    EXPECT_EQ(gpu, data);
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+float pathLength(const std::vector<tParticle> &particles, const size_t count)
+{
+    float length = 0.f;
+    for (size_t i = 1; i < count; ++i)
+    {
+        length += glm::length(glm::vec3(particles[i].Position - particles[i - 1].Position));
+    }
+    return length;
+}
+} // namespace
+
+TEST(tMortonReorderTest, ParticlesKeepTheirIds)
+{
+    tTestContext context;
+    tSim reference{context.Device, 1};
+    tSim sim{context.Device, 1};
+    reference.updateParams({0.01f});
+    sim.updateParams({0.01f});
+    sim.setReorderInterval(1);
+    stepSim(context, reference);
+    stepSim(context, sim);
+
+    const auto expected = readParticles(context.Device, reference.getParticleBuffers(), NUM_PARTICLES);
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    const auto ids = readBuffer<uint32_t>(context.Device, *sim.getParticlePool().getIdsBuffer(), NUM_PARTICLES);
+
+    // The initial particles are numbered by slot, so the IDs are a permutation of the reference slots.
+    auto sortedIds = ids;
+    std::ranges::sort(sortedIds);
+    std::vector<uint32_t> slots(NUM_PARTICLES);
+    std::iota(slots.begin(), slots.end(), 0u);
+    ASSERT_EQ(sortedIds, slots);
+
+    // Forces sum in a different order after the reorder, so only rounding may differ.
+    for (size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        const auto &other = expected[ids[i]];
+        ASSERT_NEAR(glm::length(glm::vec3(particles[i].Position - other.Position)), 0.f, 1e-5f) << "slot " << i;
+        ASSERT_NEAR(glm::length(glm::vec3(particles[i].Velocity - other.Velocity)), 0.f, 1e-5f) << "slot " << i;
+    }
+
+    // Neighbours in memory are neighbours in space along the Z-order curve.
+    EXPECT_LT(pathLength(particles, NUM_PARTICLES), 0.25f * pathLength(expected, NUM_PARTICLES));
+}
+
+TEST(tMortonReorderTest, FreeSlotsAreCompacted)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    const auto &pool = sim.getParticlePool();
+
+    // Kill everything, then emit 100 particles into the top of the free list.
+    sim.updateParams({0.001f});
+    sim.setKillRadius(1.f);
+    stepSim(context, sim);
+    sim.swapParticleBuffers();
+    sim.setKillRadius(0.f);
+    sim.setEmissionRate(200.f);
+    sim.updateParams({0.5f});
+    stepSim(context, sim);
+    sim.swapParticleBuffers();
+
+    sim.setEmissionRate(0.f);
+    sim.updateParams({0.001f});
+    sim.setReorderInterval(1);
+    stepSim(context, sim);
+
+    const auto counters = readBuffer<uint32_t>(context.Device, *pool.getCounterBuffer(), 12);
+    EXPECT_EQ(counters[0], 100u);
+    EXPECT_EQ(counters[1], 0u);
+    EXPECT_EQ(counters[4], (100 + tActiveList::LocalSize - 1) / tActiveList::LocalSize);
+
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    auto ids = readBuffer<uint32_t>(context.Device, *pool.getIdsBuffer(), NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        EXPECT_EQ(particles[i].Position.w > 0.f, i < 100) << "slot " << i;
+    }
+    EXPECT_TRUE(std::all_of(
+        ids.begin() + 100, ids.end(), [](const uint32_t id) { return id == tParticlePool::InvalidId; }));
+
+    // Emitted particles are numbered after the initial ones.
+    std::sort(ids.begin(), ids.begin() + 100);
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(ids[i], NUM_PARTICLES + i);
+    }
+}
@@ -0,0 +1,97 @@
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+TEST(tParticleMeshTest, FftMatchesCpuReference)
+{
+    tTestContext context;
+    tParticleMesh::tParams params{};
+    params.GridSize = 16;
+    tSim sim{context.Device, 1, {}, params};
+    const auto &mesh = sim.getParticleMesh();
+
+    const uint32_t n = params.GridSize;
+    const uint32_t cellTotal = n * n * n;
+    std::vector<std::complex<float>> input(cellTotal);
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    for (auto &value : input)
+    {
+        value = {dist(rng), dist(rng)};
+    }
+
+    vk::raii::Buffer buffer{nullptr};
+    tAllocation memory{nullptr};
+    std::tie(buffer, memory, std::ignore) =
+        createBuffer(context.Device,
+                     cellTotal * sizeof(std::complex<float>),
+                     vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                         vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eDeviceLocal,
+                     input.data(),
+                     "test");
+    const auto address = context.Device.getLogicalDevice().getBufferAddress({*buffer});
+
+    auto commandBuffer = context.Device.beginSingleTimeCommands();
+    mesh.recordFft(commandBuffer, address, 1);
+    context.Device.endSingleTimeCommands(commandBuffer);
+    const auto forward = readBuffer<std::complex<float>>(context.Device, *buffer, cellTotal);
+
+    // Each output sums n^3 unit-magnitude terms, so scale the tolerance with the transform length.
+    const auto reference = tParticleMesh::dftReference(input, n, 1);
+    const float tolerance = 1e-5f * static_cast<float>(cellTotal);
+    for (uint32_t i = 0; i < cellTotal; ++i)
+    {
+        ASSERT_NEAR(forward[i].real(), reference[i].real(), tolerance) << "cell " << i;
+        ASSERT_NEAR(forward[i].imag(), reference[i].imag(), tolerance) << "cell " << i;
+    }
+
+    // The inverse is unnormalized: a round trip returns the input scaled by n^3.
+    commandBuffer = context.Device.beginSingleTimeCommands();
+    mesh.recordFft(commandBuffer, address, -1);
+    context.Device.endSingleTimeCommands(commandBuffer);
+    const auto roundTrip = readBuffer<std::complex<float>>(context.Device, *buffer, cellTotal);
+    for (uint32_t i = 0; i < cellTotal; ++i)
+    {
+        ASSERT_NEAR(roundTrip[i].real() / cellTotal, input[i].real(), 1e-4f) << "cell " << i;
+        ASSERT_NEAR(roundTrip[i].imag() / cellTotal, input[i].imag(), 1e-4f) << "cell " << i;
+    }
+}
+
+TEST(tParticleMeshTest, DepositConservesMass)
+{
+    // A deposit's fixed-point resolution is set by its share of the maximum total mass. 1e-4 of MaxParticleMass in a
+    // pool of NUM_PARTICLES slots is the share of a full-mass particle among 2 * 10^8, where 32-bit cells kept about
+    // ten units per particle, spread over eight rounded corners.
+    tInitialConditions initialConditions{};
+    initialConditions.ParticleMass = 1e-4f;
+
+    tTestContext context;
+    tParticleMesh::tParams params{};
+    params.GridSize = 32;
+    tSim sim{context.Device, 1, {}, params, initialConditions};
+    sim.updateParams({1.0f});
+    sim.setSolver(tSim::tSolver::ParticleMesh);
+    stepAccelerations(context, sim);
+
+    const auto &mesh = sim.getParticleMesh();
+    const uint32_t cellTotal = params.GridSize * params.GridSize * params.GridSize;
+    const auto words = readBuffer<uint32_t>(context.Device, *mesh.getDensity().Buffer, 2 * cellTotal);
+    long double deposited = 0.0L;
+    for (uint32_t i = 0; i < cellTotal; ++i)
+    {
+        deposited += std::ldexp(static_cast<long double>(words[2 * i + 1]), 32) + words[2 * i];
+    }
+    deposited /= mesh.getMassScale();
+
+    const double exact = static_cast<double>(NUM_PARTICLES) * initialConditions.ParticleMass;
+    EXPECT_NEAR(static_cast<double>(deposited), exact, 1e-5 * exact);
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+size_t countLive(const std::vector<tParticle> &particles)
+{
+    return std::ranges::count_if(particles, [](const tParticle &p) { return p.Position.w > 0.f; });
+}
+} // namespace
+
+TEST(tParticlePoolTest, KilledSlotsAreReusedByEmission)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    const auto &pool = sim.getParticlePool();
+
+    // The initial particles sit on a shell of radius 2, so all of them leave.
+    sim.updateParams({0.001f});
+    sim.setKillRadius(1.f);
+    stepSim(context, sim);
+
+    auto counters = readBuffer<uint32_t>(context.Device, *pool.getCounterBuffer(), 12);
+    EXPECT_EQ(counters[0], NUM_PARTICLES);
+    EXPECT_EQ(counters[1], NUM_PARTICLES);
+    EXPECT_EQ(countLive(readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES)), 0u);
+
+    // 200/s over 0.5 s emits 100 particles into the top of the free list without appending.
+    sim.setKillRadius(0.f);
+    sim.setEmissionRate(200.f);
+    sim.updateParams({0.5f});
+    sim.swapParticleBuffers();
+    stepSim(context, sim);
+
+    counters = readBuffer<uint32_t>(context.Device, *pool.getCounterBuffer(), 12);
+    EXPECT_EQ(counters[0], NUM_PARTICLES);
+    EXPECT_EQ(counters[1], NUM_PARTICLES - 100);
+    EXPECT_EQ(counters[4], (NUM_PARTICLES + tActiveList::LocalSize - 1) / tActiveList::LocalSize);
+    EXPECT_EQ(counters[8], (NUM_PARTICLES + tParticlePool::TaskParticles - 1) / tParticlePool::TaskParticles);
+    EXPECT_EQ(countLive(readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES)), 100u);
+}
+
+TEST(tParticlePoolTest, CapacityGrowsAheadOfEmission)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    ASSERT_EQ(sim.getCapacity(), NUM_PARTICLES);
+
+    // The pool starts full, so emitting needs more capacity before the first emitted particle lands.
+    sim.setEmissionRate(200.f);
+    sim.updateParams({0.5f});
+    sim.updatePool();
+    EXPECT_GE(sim.getCapacity(), 2 * NUM_PARTICLES);
+    stepSim(context, sim);
+
+    const auto counters = readBuffer<uint32_t>(context.Device, *sim.getParticlePool().getCounterBuffer(), 12);
+    EXPECT_EQ(counters[0], NUM_PARTICLES + 100);
+    EXPECT_EQ(counters[1], 0u);
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), sim.getCapacity());
+    EXPECT_EQ(countLive(particles), NUM_PARTICLES + 100);
+    EXPECT_TRUE(std::ranges::all_of(particles.begin() + NUM_PARTICLES + 100,
+                                    particles.end(),
+                                    [](const tParticle &p) { return p.Position.w == 0.f; }));
+}
@@ -0,0 +1,91 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sim/tParticleReadback.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+namespace
+{
+struct tCapture
+{
+    uint64_t Step{0};
+    std::vector<tParticle> Particles;
+    std::vector<uint32_t> Ids;
+};
+
+tParticleReadback::tCallback capture(std::vector<tCapture> &captures)
+{
+    return [&captures](const tParticleReadback::tSnapshot &snapshot) {
+        captures.push_back({snapshot.Step,
+                            {snapshot.Particles.begin(), snapshot.Particles.end()},
+                            {snapshot.Ids.begin(), snapshot.Ids.end()}});
+    };
+}
+
+void stepAndSubmit(const tTestContext &context, tSim &sim)
+{
+    stepSim(context, sim);
+    sim.submitReadbacks();
+}
+} // namespace
+
+TEST(tParticleReadbackTest, SnapshotMatchesParticleBuffers)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+    std::vector<tCapture> captures;
+    sim.requestSnapshot({}, capture(captures));
+    stepAndSubmit(context, sim);
+    sim.getParticleReadback().drain();
+
+    ASSERT_EQ(captures.size(), 1u);
+    EXPECT_EQ(captures[0].Step, 1u);
+    const auto expected = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    const auto ids = readBuffer<uint32_t>(context.Device, *sim.getParticlePool().getIdsBuffer(), NUM_PARTICLES);
+    ASSERT_EQ(captures[0].Particles.size(), NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        ASSERT_EQ(captures[0].Particles[i].Position, expected[i].Position) << "slot " << i;
+        ASSERT_EQ(captures[0].Particles[i].Velocity, expected[i].Velocity) << "slot " << i;
+    }
+    EXPECT_EQ(captures[0].Ids, ids);
+    EXPECT_TRUE(sim.getParticleReadback().isIdle());
+}
+
+TEST(tParticleReadbackTest, StridedRequestsQueueForFreeSlots)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+    const uint32_t slots = sim.getParticlePool().getReadbackSlots();
+    const tParticleReadback::tRequest request{5, 7, 100};
+    std::vector<tCapture> captures;
+    for (uint32_t i = 0; i < slots + 2; ++i)
+    {
+        sim.requestSnapshot(request, capture(captures));
+    }
+
+    // The first pass fills every slot, the rest wait for one to come back instead of blocking.
+    stepAndSubmit(context, sim);
+    sim.getParticleReadback().drain();
+    EXPECT_EQ(captures.size(), slots);
+    EXPECT_FALSE(sim.getParticleReadback().isIdle());
+    sim.swapParticleBuffers();
+    stepAndSubmit(context, sim);
+    sim.getParticleReadback().drain();
+    ASSERT_EQ(captures.size(), slots + 2);
+    EXPECT_TRUE(sim.getParticleReadback().isIdle());
+
+    const auto expected = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    const auto &last = captures.back();
+    EXPECT_EQ(last.Step, 2u);
+    ASSERT_EQ(last.Particles.size(), 100u);
+    for (uint32_t i = 0; i < last.Particles.size(); ++i)
+    {
+        ASSERT_EQ(last.Particles[i].Position, expected[5 + 7 * i].Position) << "record " << i;
+    }
+    EXPECT_EQ(captures.front().Step, 1u);
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "sim/initialParticles.h"
+#include "sim/tSim.h"
+#include "testHelpers.h"
+
+TEST(tPhysicsTest, TiledKernelMatchesNaive)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1.0f});
+
+    sim.setForceKernel(tPhysics::tKernel::Naive);
+    const auto naive = stepAccelerations(context, sim);
+    sim.setForceKernel(tPhysics::tKernel::Tiled);
+    const auto tiled = stepAccelerations(context, sim);
+
+    float maxAcceleration = 0.f;
+    for (const auto &a : naive)
+    {
+        maxAcceleration = std::max(maxAcceleration, glm::length(a));
+    }
+    ASSERT_GT(maxAcceleration, 0.f);
+
+    for (size_t i = 0; i < naive.size(); ++i)
+    {
+        EXPECT_LE(glm::length(naive[i] - tiled[i]), tPhysics::KernelTolerance * maxAcceleration) << "particle " << i;
+    }
+}
+
+TEST(tPhysicsTest, RenderStreamMatchesParticles)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+    sim.setRenderStreamEnabled(true);
+
+    stepSim(context, sim);
+
+    const auto &buffers = sim.getParticleBuffers();
+    const auto particles = readParticles(context.Device, buffers, NUM_PARTICLES);
+    const auto stream = readBuffer<glm::uvec2>(context.Device, *buffers.RenderStream.Buffer, NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        const glm::vec2 xy = glm::unpackHalf2x16(stream[i].x);
+        const glm::vec2 zSpeed = glm::unpackHalf2x16(stream[i].y);
+        const glm::vec3 position{xy, zSpeed.x};
+        // fp16 keeps 11 significant bits.
+        EXPECT_LE(glm::length(position - glm::vec3(particles[i].Position)), 2e-3f * glm::length(position) + 1e-4f)
+            << "particle " << i;
+        const float speed = glm::length(glm::vec3(particles[i].Velocity));
+        EXPECT_NEAR(zSpeed.y, speed, 2e-3f * speed + 1e-4f) << "particle " << i;
+    }
+}
+
+TEST(tPhysicsTest, ClusterBoundsEncloseLiveParticles)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+
+    stepSim(context, sim);
+
+    const auto &buffers = sim.getParticleBuffers();
+    const auto particles = readParticles(context.Device, buffers, NUM_PARTICLES);
+    const uint32_t clusters = (NUM_PARTICLES + tPhysics::ClusterSize - 1) / tPhysics::ClusterSize;
+    const auto bounds = readBuffer<glm::vec4>(context.Device, *buffers.ClusterBounds.Buffer, clusters);
+    for (uint32_t cluster = 0; cluster < clusters; ++cluster)
+    {
+        const uint32_t first = cluster * tPhysics::ClusterSize;
+        const uint32_t last = std::min(first + tPhysics::ClusterSize, NUM_PARTICLES);
+        const glm::vec3 center{bounds[cluster]};
+        float farthest = -1.f;
+        for (uint32_t i = first; i < last; ++i)
+        {
+            if (particles[i].Position.w > 0.f)
+                farthest = std::max(farthest, glm::length(glm::vec3(particles[i].Position) - center));
+        }
+        // Empty clusters carry a negative radius; otherwise the sphere is tight around the farthest particle.
+        EXPECT_NEAR(bounds[cluster].w, farthest, 1e-4f * std::max(farthest, 1.f)) << "cluster " << cluster;
+    }
+}
+
+TEST(tPhysicsTest, GpuInitialParticlesMatchHost)
+{
+    tTestContext context;
+    using tModel = tInitialConditions::tModel;
+    for (const auto model :
+         {tModel::Shell, tModel::Plummer, tModel::Hernquist, tModel::Disk, tModel::Merger, tModel::Lattice})
+    {
+        SCOPED_TRACE(static_cast<int>(model));
+        tInitialConditions conditions{};
+        conditions.Model = model;
+        const auto expected = createInitialParticles(NUM_PARTICLES, conditions);
+
+        // A step of zero length copies the generated set through unchanged.
+        tSim sim{context.Device, 1, {}, {}, conditions};
+        sim.updateParams({0.f});
+        stepSim(context, sim);
+        const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+
+        // Same streams, so the same particles up to single-precision rounding; a rejection test decided the other
+        // way by rounding sends a particle down a different path, which has to stay rare.
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < particles.size(); ++i)
+        {
+            ASSERT_EQ(particles[i].Position.w, expected[i].Position.w) << "particle " << i;
+            const auto position = glm::vec3(expected[i].Position);
+            const auto velocity = glm::vec3(expected[i].Velocity);
+            const bool positionClose = glm::length(glm::vec3(particles[i].Position) - position) <=
+                                       1e-3f * glm::length(position) + 1e-5f;
+            const bool velocityClose = glm::length(glm::vec3(particles[i].Velocity) - velocity) <=
+                                       1e-3f * glm::length(velocity) + 1e-7f;
+            mismatches += positionClose && velocityClose ? 0u : 1u;
+        }
+        EXPECT_LE(mismatches, NUM_PARTICLES / 1000);
+    }
+}
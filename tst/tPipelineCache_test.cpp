@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "engine/tPipelineCache.h"
+#include "testHelpers.h"
+
+namespace
+{
+std::filesystem::path testPath(const char *name)
+{
+    const auto path = std::filesystem::temp_directory_path() / "vulkan-compute-test" / name;
+    std::filesystem::remove(path);
+    return path;
+}
+
+std::vector<char> readFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::filesystem::path &path, const std::vector<char> &bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+} // namespace
+
+TEST(tPipelineCacheTest, SavedCacheIsLoadedByTheNextRun)
+{
+    tTestContext context;
+    const auto path = testPath("roundTrip.bin");
+    {
+        tPipelineCache cache(context.Device.getPhysicalDevice(), context.Device.getLogicalDevice(), path);
+        EXPECT_FALSE(cache.wasLoaded());
+    }
+    ASSERT_TRUE(std::filesystem::exists(path));
+
+    tPipelineCache cache(context.Device.getPhysicalDevice(), context.Device.getLogicalDevice(), path);
+    EXPECT_TRUE(cache.wasLoaded());
+}
+
+TEST(tPipelineCacheTest, DamagedOrForeignFilesAreIgnored)
+{
+    tTestContext context;
+    const auto path = testPath("damaged.bin");
+    {
+        tPipelineCache cache(context.Device.getPhysicalDevice(), context.Device.getLogicalDevice(), path);
+    }
+    const auto valid = readFile(path);
+    ASSERT_GT(valid.size(), 8u);
+
+    // Byte 4 is the first of the format version, the last byte belongs to the driver's data.
+    for (const size_t offset : {size_t{4}, valid.size() - 1})
+    {
+        auto damaged = valid;
+        damaged[offset] ^= 0x5a;
+        writeFile(path, damaged);
+        EXPECT_FALSE(tPipelineCache(context.Device.getPhysicalDevice(), context.Device.getLogicalDevice(), path)
+                         .wasLoaded())
+            << "offset " << offset;
+    }
+
+    auto truncated = valid;
+    truncated.pop_back();
+    writeFile(path, truncated);
+    EXPECT_FALSE(
+        tPipelineCache(context.Device.getPhysicalDevice(), context.Device.getLogicalDevice(), path).wasLoaded());
+}
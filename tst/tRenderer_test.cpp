@@ -16,11 +16,11 @@ TEST(tRendererTest, RendererInit)
     tWindow window(1, 1, "test");
     window.createWindowSurface(instance.getInstance());
     tVulkanDevice device{};
-    device.init(instance.getInstance(), window.getSurface(), validatoinEnabled);
+    device.init(instance.getInstance(), window.getSurface(), validatoinEnabled, true, false);
     tSwapchain swapchain{};
     swapchain.init(instance.getInstance(), device, window.getSurface(), window.getExtent());
     tCamera camera{device, swapchain.getExtent()};
-    tGui gui{camera, device, swapchain, instance.getInstance(), window.getWindow()};
     tSim sim{device, swapchain.getImageCount()};
+    tGui gui{camera, sim, device, swapchain, instance.getInstance(), window.getWindow()};
     EXPECT_NO_THROW((tRenderer{camera, gui, device, swapchain, sim}));
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "helpers/barriers.h"
+#include "sim/tSim.h"
+#include "sim/tStateHash.h"
+#include "testHelpers.h"
+
+TEST(tStateHashTest, GpuHashMatchesHost)
+{
+    tTestContext context;
+    tSim sim{context.Device, 1};
+    sim.updateParams({1e-3f});
+    stepSim(context, sim);
+
+    tStateHash hash{context.Device, sim.getCapacity(), 1};
+    auto commandBuffer = context.Device.beginSingleTimeCommands();
+    recordComputeBarrier(commandBuffer);
+    hash.recordHash(
+        commandBuffer, sim.getParticleBuffers(), sim.getCapacity(), sim.getParticlePool().getCountAddress(), 0);
+    context.Device.endSingleTimeCommands(commandBuffer);
+
+    const auto particles = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    EXPECT_EQ(hash.readHash(0), tStateHash::hashParticles(particles));
+
+    // A single ulp anywhere changes the checksum.
+    auto changed = particles;
+    changed[123].Velocity.x = std::nextafter(changed[123].Velocity.x, 1.f);
+    EXPECT_NE(tStateHash::hashParticles(changed), tStateHash::hashParticles(particles));
+}
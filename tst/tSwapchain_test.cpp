@@ -13,7 +13,7 @@ TEST(tSwapchainTest, SwapchainInit)
     window.createWindowSurface(instance.getInstance());
 
     tVulkanDevice device{};
-    device.init(instance.getInstance(), window.getSurface(), validatoinEnabled);
+    device.init(instance.getInstance(), window.getSurface(), validatoinEnabled, true, false);
 
     tSwapchain swapchain{};
 
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/tUploader.h"
+#include "testHelpers.h"
+
+TEST(tUploaderTest, UploadsSpanningSegmentsLandAfterFlush)
+{
+    tTestContext context;
+    auto &uploader = context.Device.getUploader();
+    // Larger than a segment and not a multiple of the chunk alignment, so it splits and pads.
+    const size_t count = tUploader::SegmentSize / sizeof(uint32_t) + 12345;
+    std::vector<uint32_t> data(count);
+    std::iota(data.begin(), data.end(), 3u);
+    const auto buffer = createStorageBuffer(context.Device, count * sizeof(uint32_t), "test");
+
+    const uint64_t before = uploader.getSubmittedValue();
+    const uint64_t value = uploader.upload(*buffer.Buffer, 0, data.data(), count * sizeof(uint32_t));
+    // The first segment filled up and went out on its own; the rest waits for the flush.
+    EXPECT_GT(uploader.getSubmittedValue(), before);
+    EXPECT_LT(uploader.getSubmittedValue(), value);
+    EXPECT_EQ(uploader.flush(), value);
+    EXPECT_EQ(uploader.flush(), value);
+
+    uploader.wait(value);
+    EXPECT_TRUE(uploader.isComplete(value));
+    EXPECT_EQ(readBuffer<uint32_t>(context.Device, *buffer.Buffer, count), data);
+}
+
+TEST(tUploaderTest, BatchesSmallUploadsUntilFlushed)
+{
+    tTestContext context;
+    auto &uploader = context.Device.getUploader();
+    constexpr uint32_t Count = 64;
+    const auto buffer = createStorageBuffer(context.Device, Count * sizeof(uint32_t), "test");
+
+    // Odd-sized pieces at neighbouring offsets; each source chunk is padded in the ring, the destinations are not.
+    std::vector<uint32_t> expected(Count);
+    std::iota(expected.begin(), expected.end(), 100u);
+    const uint64_t submitted = uploader.getSubmittedValue();
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < Count; i += 3)
+    {
+        const uint32_t n = std::min(3u, Count - i);
+        value = uploader.upload(*buffer.Buffer, i * sizeof(uint32_t), &expected[i], n * sizeof(uint32_t));
+    }
+    EXPECT_EQ(uploader.getSubmittedValue(), submitted);
+    EXPECT_EQ(uploader.flush(), value);
+
+    // Single-time commands flush first and order after the uploads without waiting for the value themselves.
+    EXPECT_EQ(readBuffer<uint32_t>(context.Device, *buffer.Buffer, Count), expected);
+    EXPECT_TRUE(uploader.isComplete(value));
+}
+
+TEST(tUploaderTest, WrapsTheRingMoreThanOnce)
+{
+    tTestContext context;
+    auto &uploader = context.Device.getUploader();
+    const size_t count = tUploader::SegmentSize / sizeof(uint32_t);
+    const auto buffer = createStorageBuffer(context.Device, count * sizeof(uint32_t), "test");
+
+    std::vector<uint32_t> data(count);
+    for (uint32_t round = 0; round < 3 * tUploader::SegmentCount; ++round)
+    {
+        std::iota(data.begin(), data.end(), round);
+        uploader.upload(*buffer.Buffer, 0, data.data(), count * sizeof(uint32_t));
+        uploader.flush();
+    }
+    EXPECT_EQ(readBuffer<uint32_t>(context.Device, *buffer.Buffer, count), data);
+}
@@ -12,5 +12,19 @@ TEST(tVulkanDeviceTest, VulkanDeviceInit)
     window.createWindowSurface(instance.getInstance());
 
     tVulkanDevice device{};
-    EXPECT_NO_THROW((device.init(instance.getInstance(), window.getSurface(), validatoinEnabled)));
-}
\ No newline at end of file
+    EXPECT_NO_THROW((device.init(instance.getInstance(), window.getSurface(), validatoinEnabled, true, false)));
+}
+
+TEST(tVulkanDeviceTest, ComputeQueueFallsBackToGraphicsQueue)
+{
+    const bool validationEnabled = false;
+    tVulkanInstance instance(validationEnabled);
+    tWindow window(1, 1, "test");
+    window.createWindowSurface(instance.getInstance());
+
+    tVulkanDevice device{};
+    device.init(instance.getInstance(), window.getSurface(), validationEnabled, false, false);
+    EXPECT_FALSE(device.hasAsyncCompute());
+    EXPECT_EQ(device.getComputeQueueFamily(), device.getQueueFamily());
+    EXPECT_EQ(*device.getComputeQueue(), *device.getQueue());
+}
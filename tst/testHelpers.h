@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "engine/tVulkanDevice.h"
+#include "engine/tVulkanInstance.h"
+#include "engine/tWindow.h"
+#include "helpers/createBuffer.h"
+#include "sim/constants.h"
+#include "sim/tParticle.h"
+#include "sim/tSim.h"
+
+// Instance, window and device for tests that dispatch work; validation stays off to match the other tests.
+struct tTestContext
+{
+    tTestContext() : Instance(false), Window(1, 1, "test")
+    {
+        Window.createWindowSurface(Instance.getInstance());
+        Device.init(Instance.getInstance(), Window.getSurface(), false, true, false);
+    }
+
+    tVulkanInstance Instance;
+    tWindow Window;
+    tVulkanDevice Device;
+};
+
+// Blocking copy of a device buffer into host memory. Only meant for tests.
+template <typename T>
+std::vector<T> readBuffer(const tVulkanDevice &device, const vk::Buffer source, const size_t count)
+{
+    const vk::DeviceSize size = count * sizeof(T);
+    auto [buffer, memory, mapped] =
+        createBuffer(device,
+                     size,
+                     vk::BufferUsageFlagBits::eTransferDst,
+                     vk::SharingMode::eExclusive,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                     nullptr,
+                     "test");
+
+    auto commandBuffer = device.beginSingleTimeCommands();
+    vk::MemoryBarrier2 writesToCopy{vk::PipelineStageFlagBits2::eAllCommands,
+                                    vk::AccessFlagBits2::eMemoryWrite,
+                                    vk::PipelineStageFlagBits2::eTransfer,
+                                    vk::AccessFlagBits2::eTransferRead};
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setMemoryBarriers(writesToCopy));
+    commandBuffer.copyBuffer(source, *buffer, vk::BufferCopy{0, 0, size});
+    device.endSingleTimeCommands(commandBuffer);
+
+    std::vector<T> values(count);
+    std::memcpy(values.data(), mapped, static_cast<size_t>(size));
+    return values;
+}
+
+// Blocking copy of the first count slots of a particle buffer set, zipped back into host-side particles.
+inline std::vector<tParticle> readParticles(const tVulkanDevice &device,
+                                            const tPhysics::tParticleBuffers &buffers,
+                                            const size_t count)
+{
+    const auto positions = readBuffer<glm::vec4>(device, *buffers.Positions.Buffer, count);
+    const auto velocities = readBuffer<glm::vec4>(device, *buffers.Velocities.Buffer, count);
+    std::vector<tParticle> particles(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        particles[i] = {positions[i], velocities[i]};
+    }
+    return particles;
+}
+
+// Records and submits steps compute passes, swapping the particle buffers in between as a frame does, so each pass
+// continues from the last. The final output is left in the write buffer, getParticleBuffers().
+inline void stepSim(const tTestContext &context, tSim &sim, const int steps = 1)
+{
+    for (int i = 0; i < steps; ++i)
+    {
+        if (i > 0)
+        {
+            sim.swapParticleBuffers();
+        }
+        auto commandBuffer = context.Device.beginSingleTimeCommands();
+        sim.recordComputePass(commandBuffer, 0);
+        context.Device.endSingleTimeCommands(commandBuffer);
+    }
+}
+
+// Runs one compute pass and returns the velocity change per particle. With DeltaTime = 1 and the default
+// semi-implicit Euler scheme that is the acceleration the active solver computed. The particle buffers are left as
+// they were.
+inline std::vector<glm::vec3> stepAccelerations(const tTestContext &context, tSim &sim)
+{
+    stepSim(context, sim);
+
+    const auto out = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    sim.swapParticleBuffers();
+    const auto in = readParticles(context.Device, sim.getParticleBuffers(), NUM_PARTICLES);
+    sim.swapParticleBuffers();
+
+    std::vector<glm::vec3> accelerations(NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i)
+    {
+        accelerations[i] = glm::vec3(out[i].Velocity - in[i].Velocity);
+    }
+    return accelerations;
+}